@@ -0,0 +1,677 @@
+/*
+ * Copyright (c) 2017-2018, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <plorth/context.hpp>
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <unordered_map>
+
+namespace plorth
+{
+  namespace cli
+  {
+    namespace
+    {
+      /**
+       * Support code included in every generated program.
+       */
+      static const char* prologue = R"(#include <plorth/context.hpp>
+
+#include <cstdlib>
+#include <iostream>
+
+using namespace plorth;
+
+namespace
+{
+  using value_vector = std::vector<std::shared_ptr<value>>;
+
+  /**
+   * Calls word which was resolved ahead of time, if the top-most value of the
+   * stack is of the type which the word was resolved for. Otherwise the
+   * symbol is resolved and executed normally.
+   */
+  inline bool call(const std::shared_ptr<context>& ctx,
+                   const std::shared_ptr<value>& sym,
+                   enum value::type type,
+                   const std::shared_ptr<quote>& word)
+  {
+    const auto& stack = ctx->data();
+
+    if (!word || stack.empty() || !value::is(stack.back(), type))
+    {
+      return value::exec(ctx, sym);
+    }
+    if (const auto position = std::static_pointer_cast<symbol>(sym)->position())
+    {
+      ctx->position() = *position;
+    }
+
+    return word->call(ctx);
+  }
+
+  /**
+   * Pushes number which was constructed from a number literal ahead of time,
+   * unless a word of the same name would be found by the interpreter, in
+   * which case the symbol is executed normally.
+   */
+  inline bool literal(const std::shared_ptr<context>& ctx,
+                      const std::shared_ptr<value>& sym,
+                      const std::shared_ptr<number>& num)
+  {
+    const auto& stack = ctx->data();
+    const auto& rt = ctx->runtime();
+    const auto s = std::static_pointer_cast<symbol>(sym);
+
+    if (!stack.empty() && value::is(stack.back(), value::type::object))
+    {
+      const auto prototype = stack.back()->prototype(rt);
+      std::shared_ptr<value> slot;
+
+      if (prototype && prototype->property(rt, s->id(), slot))
+      {
+        return value::exec(ctx, sym);
+      }
+    }
+    if (ctx->module_scope()
+        || ctx->dictionary().find(s)
+        || rt->dictionary().find(s))
+    {
+      return value::exec(ctx, sym);
+    }
+    if (const auto position = s->position())
+    {
+      ctx->position() = *position;
+    }
+    ctx->push(num);
+
+    return true;
+  }
+
+  /**
+   * Looks up word from a prototype of a built-in type.
+   */
+  inline std::shared_ptr<quote> resolve(
+    const std::shared_ptr<object>& prototype,
+    const std::u32string& id
+  )
+  {
+    std::shared_ptr<value> slot;
+
+    if (prototype->own_property(id, slot)
+        && value::is(slot, value::type::quote))
+    {
+      return std::static_pointer_cast<quote>(slot);
+    }
+
+    return std::shared_ptr<quote>();
+  }
+
+  inline std::shared_ptr<symbol> symbol_at(const std::shared_ptr<runtime>& rt,
+                                           const std::u32string& id,
+                                           const std::u32string& filename,
+                                           int line,
+                                           int column)
+  {
+    const position position = { filename, line, column };
+
+    return rt->symbol(id, &position);
+  }
+)";
+
+      /**
+       * Translates compiled quotes into C++ functions which execute their
+       * values without the interpreter loop, and C++ code which reconstructs
+       * the values when the generated program is started.
+       */
+      class cpp_emitter
+      {
+      public:
+        explicit cpp_emitter(const std::shared_ptr<runtime>& runtime,
+                             const std::u32string& filename)
+          : m_runtime(runtime)
+          , m_filename(filename)
+          , m_counter(0) {}
+
+        void emit(const std::shared_ptr<quote>& program, std::ostream& out)
+        {
+          const auto name = emit_quote(program, true);
+
+          out << "// Generated by plorth --emit-cpp from "
+              << utf8_encode(m_filename)
+              << ". Do not edit."
+              << std::endl
+              << prologue
+              << std::endl
+              << "  const std::u32string script_filename = "
+              << string_literal(m_filename)
+              << ";" << std::endl
+              << std::endl
+              << "  /** Words resolved ahead of time. */" << std::endl
+              << "  std::shared_ptr<quote> w[" << m_words.size() + 1 << "];"
+              << std::endl
+              << std::endl
+              << "  /** Numbers constructed from number literals. */"
+              << std::endl
+              << "  std::shared_ptr<number> n[" << m_numbers.size() + 1 << "];"
+              << std::endl
+              << std::endl
+              << m_functions.str()
+              << "  std::shared_ptr<quote> build("
+              << "const std::shared_ptr<runtime>& rt)"
+              << std::endl
+              << "  {" << std::endl;
+          for (std::size_t i = 0; i < m_words.size(); ++i)
+          {
+            out << "    w[" << i << "] = resolve(rt->"
+                << prototype_name(m_words[i].first)
+                << "_prototype(), "
+                << string_literal(m_words[i].second)
+                << ");" << std::endl;
+          }
+          for (std::size_t i = 0; i < m_numbers.size(); ++i)
+          {
+            out << "    n[" << i << "] = rt->number("
+                << string_literal(m_numbers[i])
+                << ");" << std::endl;
+          }
+          out << m_build.str()
+              << std::endl
+              << "    return " << name << ";" << std::endl
+              << "  }" << std::endl
+              << "}" << std::endl
+              << main_function;
+        }
+
+      private:
+        /**
+         * Emits code which constructs given value, and returns name of the
+         * variable which holds it.
+         */
+        std::string emit_value(const std::shared_ptr<value>& value)
+        {
+          const auto existing = m_names.find(value.get());
+          std::ostringstream expression;
+
+          if (!value)
+          {
+            return "nullptr";
+          }
+          else if (existing != std::end(m_names))
+          {
+            return existing->second;
+          }
+
+          switch (value->type())
+          {
+            case value::type::quote:
+              return emit_quote(std::static_pointer_cast<quote>(value), false);
+
+            case value::type::string:
+              expression << "rt->string("
+                         << string_literal(value->to_string())
+                         << ")";
+              break;
+
+            case value::type::symbol:
+              {
+                const auto sym = std::static_pointer_cast<symbol>(value);
+                const auto position = sym->position();
+
+                if (position)
+                {
+                  expression << "symbol_at(rt, "
+                             << string_literal(sym->id())
+                             << ", "
+                             << (position->filename == m_filename
+                                 ? std::string("script_filename")
+                                 : string_literal(position->filename))
+                             << ", " << position->line
+                             << ", " << position->column
+                             << ")";
+                } else {
+                  expression << "rt->symbol("
+                             << string_literal(sym->id())
+                             << ")";
+                }
+              }
+              break;
+
+            case value::type::word:
+              {
+                const auto wrd = std::static_pointer_cast<word>(value);
+                const auto sym = emit_value(wrd->symbol());
+                const auto quo = emit_value(wrd->quote());
+
+                expression << "rt->word(" << sym << ", " << quo << ")";
+              }
+              break;
+
+            case value::type::array:
+              {
+                const auto ary = std::static_pointer_cast<array>(value);
+                std::vector<std::string> elements;
+
+                for (array::size_type i = 0; i < ary->size(); ++i)
+                {
+                  elements.push_back(emit_value(ary->at(i)));
+                }
+                expression << "rt->array(value_vector{"
+                           << join(elements)
+                           << "}.data(), "
+                           << elements.size()
+                           << ")";
+              }
+              break;
+
+            case value::type::object:
+              {
+                std::vector<std::string> properties;
+
+                std::static_pointer_cast<object>(value)->for_each(
+                  [&](const object::key_type& key,
+                      const object::mapped_type& property)
+                  {
+                    properties.push_back(
+                      "{ " + string_literal(key)
+                      + ", " + emit_value(property) + " }"
+                    );
+
+                    return true;
+                  }
+                );
+                expression << "rt->object({" << join(properties) << "})";
+              }
+              break;
+
+            default:
+              // The compiler does not produce other types of values.
+              expression << "nullptr";
+              break;
+          }
+
+          return define(value, expression.str());
+        }
+
+        /**
+         * Emits C++ function which executes values of given compiled quote,
+         * and code which constructs the quote.
+         */
+        std::string emit_quote(const std::shared_ptr<quote>& quo, bool program)
+        {
+          const auto values = quo->values();
+          std::vector<std::string> names;
+          stack_analysis analysis;
+          std::size_t site = 0;
+          std::size_t function;
+
+          if (!values)
+          {
+            return "nullptr";
+          }
+
+          for (const auto& value : *values)
+          {
+            names.push_back(emit_value(value));
+          }
+
+          // The program is executed with an empty stack, so its analysis can
+          // proceed further than analysis of other quotes.
+          analysis = stack_analysis::analyze(*m_runtime, *values, {}, program);
+
+          function = m_counter++;
+          m_functions << "  bool q" << function
+                      << "(const std::shared_ptr<context>& ctx, "
+                      << "const value_vector& v)" << std::endl
+                      << "  {" << std::endl;
+          for (std::size_t i = 0; i < values->size(); ++i)
+          {
+            const auto& value = (*values)[i];
+
+            m_functions << "    ";
+            if (site < analysis.sites.size() && analysis.sites[site].index == i)
+            {
+              const auto& resolved = analysis.sites[site++];
+
+              m_functions << "if (!call(ctx, v[" << i << "], value::type::"
+                          << prototype_name(resolved.type)
+                          << ", w[" << word_index(
+                               resolved.type,
+                               std::static_pointer_cast<symbol>(value)->id()
+                             )
+                          << "])) return false;";
+            }
+            else if (!value)
+            {
+              m_functions << "ctx->push_null();";
+            }
+            else if (value->is(value::type::symbol)
+                     && is_number(
+                       std::static_pointer_cast<symbol>(value)->id()
+                     ))
+            {
+              m_functions << "if (!literal(ctx, v[" << i << "], n["
+                          << number_index(
+                               std::static_pointer_cast<symbol>(value)->id()
+                             )
+                          << "])) return false;";
+            }
+            else if (value->is(value::type::word))
+            {
+              m_functions << "ctx->dictionary().insert("
+                          << "std::static_pointer_cast<word>(v[" << i
+                          << "]));";
+            }
+            else if (value->is(value::type::symbol)
+                     || value->is(value::type::array)
+                     || value->is(value::type::object))
+            {
+              m_functions << "if (!value::exec(ctx, v[" << i
+                          << "])) return false;";
+            } else {
+              m_functions << "ctx->push(v[" << i << "]);";
+            }
+            m_functions << " // " << utf8_encode(comment(value)) << std::endl;
+          }
+          m_functions << std::endl
+                      << "    return true;" << std::endl
+                      << "  }" << std::endl
+                      << std::endl;
+
+          return define(
+            quo,
+            "rt->compiled_quote({" + join(names) + "}, &q"
+            + std::to_string(function) + ")"
+          );
+        }
+
+        std::string define(const std::shared_ptr<value>& value,
+                           const std::string& expression)
+        {
+          const auto name = "v" + std::to_string(m_counter++);
+
+          m_build << "    const auto " << name << " = " << expression << ";"
+                  << std::endl;
+          m_names[value.get()] = name;
+
+          return name;
+        }
+
+        std::size_t word_index(enum value::type type, const std::u32string& id)
+        {
+          const auto key = std::make_pair(type, id);
+          const auto existing = std::find(
+            std::begin(m_words),
+            std::end(m_words),
+            key
+          );
+
+          if (existing != std::end(m_words))
+          {
+            return existing - std::begin(m_words);
+          }
+          m_words.push_back(key);
+
+          return m_words.size() - 1;
+        }
+
+        std::size_t number_index(const std::u32string& id)
+        {
+          const auto existing = std::find(
+            std::begin(m_numbers),
+            std::end(m_numbers),
+            id
+          );
+
+          if (existing != std::end(m_numbers))
+          {
+            return existing - std::begin(m_numbers);
+          }
+          m_numbers.push_back(id);
+
+          return m_numbers.size() - 1;
+        }
+
+        static std::u32string comment(const std::shared_ptr<value>& value)
+        {
+          std::u32string result;
+
+          for (const auto c : value ? value->to_source() : U"null")
+          {
+            if (result.length() >= 40)
+            {
+              result += U"...";
+              break;
+            }
+            // Avoid line continuations and trigraphs.
+            if (c == '\n' || c == '\r' || c == '\\'
+                || (c == '?' && !result.empty() && result.back() == '?'))
+            {
+              result += ' ';
+            } else {
+              result += c;
+            }
+          }
+
+          return result;
+        }
+
+        static std::string join(const std::vector<std::string>& parts)
+        {
+          std::string result;
+
+          for (std::size_t i = 0; i < parts.size(); ++i)
+          {
+            if (i > 0)
+            {
+              result += ", ";
+            }
+            result += parts[i];
+          }
+
+          return result;
+        }
+
+        static const char* prototype_name(enum value::type type)
+        {
+          switch (type)
+          {
+            case value::type::null:
+              return "null";
+
+            case value::type::boolean:
+              return "boolean";
+
+            case value::type::number:
+              return "number";
+
+            case value::type::string:
+              return "string";
+
+            case value::type::array:
+              return "array";
+
+            case value::type::object:
+              return "object";
+
+            case value::type::symbol:
+              return "symbol";
+
+            case value::type::quote:
+              return "quote";
+
+            case value::type::word:
+              return "word";
+
+            case value::type::error:
+              return "error";
+
+            case value::type::string_builder:
+              return "string_builder";
+
+            case value::type::file:
+              return "file";
+
+            case value::type::bytes:
+              return "bytes";
+
+            case value::type::stream:
+              return "stream";
+          }
+
+          return "null";
+        }
+
+        /**
+         * Converts given string into C++ expression which constructs an
+         * equivalent std::u32string.
+         */
+        static std::string string_literal(const std::u32string& input)
+        {
+          std::ostringstream result;
+
+          for (const auto c : input)
+          {
+            // Surrogates cannot be used in string literals.
+            if (c >= 0xd800 && (c <= 0xdfff || c > 0x10ffff))
+            {
+              result << "std::u32string{";
+              for (std::size_t i = 0; i < input.length(); ++i)
+              {
+                result << (i > 0 ? ", " : "")
+                       << "char32_t(" << static_cast<unsigned long>(input[i])
+                       << ")";
+              }
+              result << "}";
+
+              return result.str();
+            }
+          }
+
+          result << "std::u32string(U\"";
+          for (const auto c : input)
+          {
+            if (c >= 0x20 && c < 0x7f && c != '"' && c != '\\' && c != '?')
+            {
+              result << static_cast<char>(c);
+            } else {
+              result << "\\U"
+                     << std::hex << std::setw(8) << std::setfill('0')
+                     << static_cast<unsigned long>(c)
+                     << std::dec;
+            }
+          }
+          result << "\", " << input.length() << ")";
+
+          return result.str();
+        }
+
+      private:
+        const std::shared_ptr<runtime> m_runtime;
+        const std::u32string m_filename;
+        /** Counter used for naming generated functions and variables. */
+        std::size_t m_counter;
+        /** Prototype words called directly by the generated functions. */
+        std::vector<std::pair<enum value::type, std::u32string>> m_words;
+        /** Number literals pushed by the generated functions. */
+        std::vector<std::u32string> m_numbers;
+        /** Names of variables holding values which have been constructed. */
+        std::unordered_map<const value*, std::string> m_names;
+        std::ostringstream m_functions;
+        std::ostringstream m_build;
+        static const char* main_function;
+      };
+
+      const char* cpp_emitter::main_function = R"(
+static int report(const std::shared_ptr<context>& ctx)
+{
+  const auto& err = ctx->error();
+
+  std::cerr << "Error: ";
+  if (err)
+  {
+    const auto position = err->position();
+
+    if (position && (!position->filename.empty() || position->line))
+    {
+      std::cerr << *position << ':';
+    }
+    std::cerr << err->code() << " - " << utf8_encode(err->message());
+  } else {
+    std::cerr << "Unknown error.";
+  }
+  std::cerr << std::endl;
+
+  return EXIT_FAILURE;
+}
+
+int main(int argc, char** argv)
+{
+  memory::manager memory_manager;
+  auto runtime = runtime::make(memory_manager);
+  auto context = context::make(runtime);
+  int result;
+
+#if PLORTH_ENABLE_FILE_SYSTEM_MODULES
+  runtime->module_manager() = module::manager::file_system(
+    memory_manager,
+    module::manager::default_lookup_paths()
+  );
+  context->filename(script_filename);
+#endif
+  for (int i = 1; i < argc; ++i)
+  {
+    runtime->arguments().push_back(utf8_decode(argv[i]));
+  }
+
+  result = build(runtime)->call(context) ? EXIT_SUCCESS : report(context);
+
+  // Resolved words and numbers have been allocated from the memory manager,
+  // so they must be released before it is destroyed.
+  for (auto& word : w)
+  {
+    word.reset();
+  }
+  for (auto& number : n)
+  {
+    number.reset();
+  }
+
+  return result;
+}
+)";
+    }
+
+    void emit_cpp(const std::shared_ptr<quote>& script,
+                  const std::shared_ptr<runtime>& runtime,
+                  const std::u32string& filename,
+                  std::ostream& out)
+    {
+      cpp_emitter(runtime, filename).emit(script, out);
+    }
+  }
+}
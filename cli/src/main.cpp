@@ -26,6 +26,7 @@
 #include <plorth/plorth.hpp>
 #include <plorth/cli/config.hpp>
 
+#include <algorithm>
 #include <cstring>
 #include <fstream>
 #if PLORTH_ENABLE_FILE_SYSTEM_MODULES
@@ -50,8 +51,16 @@ using namespace plorth;
 static const char* script_filename = nullptr;
 static bool flag_test_syntax = false;
 static bool flag_fork = false;
+static bool flag_stats = false;
+static bool flag_emit_cpp = false;
 static std::string inline_script;
 #if PLORTH_ENABLE_FILE_SYSTEM_MODULES
+static bool flag_preload = false;
+static bool flag_watch = false;
+static bool flag_test = false;
+static const char* junit_filename = nullptr;
+static unsigned long test_jobs = 0;
+static std::vector<std::string> test_paths;
 static std::unordered_set<std::u32string> imported_modules;
 #endif
 
@@ -60,6 +69,28 @@ static void compile_and_run(const std::shared_ptr<context>&,
                             const std::string&,
                             const std::u32string&);
 static void handle_error(const std::shared_ptr<context>&);
+#if PLORTH_ENABLE_FILE_SYSTEM_MODULES
+static void preload_modules(const std::shared_ptr<context>&);
+#endif
+static void print_statistics(const std::shared_ptr<runtime>&);
+static void print_site_profiles(const struct runtime::statistics&);
+
+namespace plorth
+{
+  namespace cli
+  {
+    void emit_cpp(const std::shared_ptr<quote>&,
+                  const std::shared_ptr<runtime>&,
+                  const std::u32string&,
+                  std::ostream&);
+#if PLORTH_ENABLE_FILE_SYSTEM_MODULES
+    int run_tests(const std::shared_ptr<runtime>&,
+                  const std::vector<std::string>&,
+                  const char*,
+                  unsigned long);
+#endif
+  }
+}
 
 #if PLORTH_CLI_ENABLE_REPL
 static inline bool is_console_interactive();
@@ -79,13 +110,33 @@ int main(int argc, char** argv)
   auto runtime = runtime::make(memory_manager);
   auto context = context::make(runtime);
 
+  scan_arguments(runtime, argc, argv);
+
+  if (flag_stats)
+  {
+    runtime->statistics().profile_sites = true;
+  }
+
 #if PLORTH_ENABLE_FILE_SYSTEM_MODULES
-  plorth::cli::utils::scan_module_path(runtime);
-#endif
+  if (flag_test)
+  {
+    return plorth::cli::run_tests(
+      runtime,
+      test_paths,
+      junit_filename,
+      test_jobs
+    );
+  }
 
-  scan_arguments(runtime, argc, argv);
+  plorth::cli::utils::scan_module_path(runtime, flag_watch);
+#endif
 
 #if PLORTH_ENABLE_FILE_SYSTEM_MODULES
+  if (flag_preload)
+  {
+    preload_modules(context);
+  }
+
   for (const auto& module_path : imported_modules)
   {
     if (!runtime->import(context, module_path))
@@ -142,6 +193,11 @@ int main(int argc, char** argv)
     );
   }
 
+  if (flag_stats)
+  {
+    print_statistics(runtime);
+  }
+
   return EXIT_SUCCESS;
 }
 
@@ -162,7 +218,27 @@ static void print_usage(std::ostream& out, const char* executable)
       << std::endl;
 #if PLORTH_ENABLE_FILE_SYSTEM_MODULES
   out << "  -r <path>    Import module before executing script." << std::endl;
+  out << "  --preload    Load imported modules in parallel before execution."
+      << std::endl;
+#if HAVE_SYS_INOTIFY_H
+  out << "  --watch      Reload changed modules in interactive mode."
+      << std::endl;
+#endif
+  out << "  --test       Run test files from given paths in parallel."
+      << std::endl;
+  out << "  --junit <f>  Write results of --test as JUnit XML into file f."
+      << std::endl;
+  out << "  --jobs <n>   Number of test files run in parallel with --test."
+      << std::endl;
+#endif
+  out << "  --emit-cpp   Print script translated into C++ instead of executing it."
+      << std::endl;
+#if PLORTH_ENABLE_JIT
+  out << "  --jit        Compile frequently called quotes into machine code."
+      << std::endl;
 #endif
+  out << "  --stats      Print runtime statistics after execution."
+      << std::endl;
   out << "  --version    Print the version." << std::endl;
   out << "  --help       Display this message." << std::endl;
   out << std::endl;
@@ -184,6 +260,15 @@ static void scan_arguments(const std::shared_ptr<class runtime>& runtime,
     }
     else if (*arg != '-')
     {
+#if PLORTH_ENABLE_FILE_SYSTEM_MODULES
+      // In test mode, all arguments which are not switches are paths to
+      // test files or directories containing them.
+      if (flag_test)
+      {
+        test_paths.push_back(arg);
+        continue;
+      }
+#endif
       if (inline_script.empty())
       {
         script_filename = arg;
@@ -201,6 +286,71 @@ static void scan_arguments(const std::shared_ptr<class runtime>& runtime,
         print_usage(std::cout, argv[0]);
         std::exit(EXIT_SUCCESS);
       }
+      else if (!std::strcmp(arg, "--stats"))
+      {
+        flag_stats = true;
+        continue;
+      }
+      else if (!std::strcmp(arg, "--emit-cpp"))
+      {
+        flag_emit_cpp = true;
+        continue;
+      }
+#if PLORTH_ENABLE_JIT
+      else if (!std::strcmp(arg, "--jit"))
+      {
+        runtime->jit_enabled() = true;
+        continue;
+      }
+#endif
+#if PLORTH_ENABLE_FILE_SYSTEM_MODULES
+      else if (!std::strcmp(arg, "--preload"))
+      {
+        flag_preload = true;
+        continue;
+      }
+#if HAVE_SYS_INOTIFY_H
+      else if (!std::strcmp(arg, "--watch"))
+      {
+        flag_watch = true;
+        continue;
+      }
+#endif
+      else if (!std::strcmp(arg, "--test"))
+      {
+        flag_test = true;
+        continue;
+      }
+      else if (!std::strcmp(arg, "--junit"))
+      {
+        if (offset < argc)
+        {
+          junit_filename = argv[offset++];
+        } else {
+          std::cerr << "Argument expected for the --junit option." << std::endl;
+          print_usage(std::cerr, argv[0]);
+          std::exit(EX_USAGE);
+        }
+        continue;
+      }
+      else if (!std::strcmp(arg, "--jobs"))
+      {
+        char* end = nullptr;
+
+        if (offset < argc)
+        {
+          test_jobs = std::strtoul(argv[offset++], &end, 10);
+        }
+        if (!end || *end || !test_jobs)
+        {
+          std::cerr << "Positive number expected for the --jobs option."
+                    << std::endl;
+          print_usage(std::cerr, argv[0]);
+          std::exit(EX_USAGE);
+        }
+        continue;
+      }
+#endif
       else if (!std::strcmp(arg, "--version"))
       {
         std::cerr << "Plorth " << utf8_encode(PLORTH_VERSION) << std::endl;
@@ -231,7 +381,7 @@ static void scan_arguments(const std::shared_ptr<class runtime>& runtime,
         if (offset < argc)
         {
           inline_script.append(argv[offset++]);
-          inline_script.append('\n', 1);
+          inline_script.append(1, '\n');
         } else {
           std::cerr << "Argument expected for the -e option." << std::endl;
           print_usage(std::cerr, argv[0]);
@@ -298,6 +448,41 @@ static inline bool is_console_interactive()
 }
 #endif
 
+#if PLORTH_ENABLE_FILE_SYSTEM_MODULES
+static void preload_modules(const std::shared_ptr<context>& ctx)
+{
+  std::vector<std::u32string> paths(
+    std::begin(imported_modules),
+    std::end(imported_modules)
+  );
+
+  // Preload the script as well, so that modules imported by it are also
+  // preloaded. The path is given relative to the script itself.
+  if (script_filename)
+  {
+    const auto filename = utf8_decode(script_filename);
+    const auto index = filename.find_last_of('/');
+
+    ctx->filename(filename);
+    paths.push_back(
+      U"./" + (index == std::u32string::npos
+        ? filename
+        : filename.substr(index + 1))
+    );
+  }
+
+  ctx->runtime()->module_manager()->preload(ctx, paths);
+
+  // The script itself is compiled from source before it is executed, so the
+  // preloaded version of it is not needed once modules it imports have been
+  // queued.
+  if (script_filename)
+  {
+    ctx->runtime()->module_manager()->discard_preloaded(ctx, paths.back());
+  }
+}
+#endif
+
 static void handle_error(const std::shared_ptr<context>& ctx)
 {
   const std::shared_ptr<error>& err = ctx->error();
@@ -316,9 +501,99 @@ static void handle_error(const std::shared_ptr<context>& ctx)
     std::cerr << "Unknown error.";
   }
   std::cerr << std::endl;
+  if (flag_stats)
+  {
+    print_statistics(ctx->runtime());
+  }
   std::exit(EXIT_FAILURE);
 }
 
+static void print_statistics(const std::shared_ptr<class runtime>& runtime)
+{
+  const auto& stats = runtime->statistics();
+
+  std::cerr << "Object updates:        " << stats.object_updates << std::endl
+            << "Object compactions:    " << stats.object_compactions << std::endl
+            << "Average object depth:  " << stats.average_object_depth()
+            << std::endl;
+  std::cerr << "Inlined words:         " << stats.inlined_words << std::endl;
+  std::cerr << "Unchecked call sites:  " << stats.unchecked_sites << std::endl;
+#if PLORTH_ENABLE_JIT
+  std::cerr << "JIT compilations:      " << stats.jit_compilations << std::endl
+            << "JIT deoptimizations:   " << stats.jit_deoptimizations
+            << std::endl;
+#endif
+  print_site_profiles(stats);
+}
+
+/**
+ * Prints operand types observed by the most frequently executed arithmetic
+ * and comparison call sites.
+ */
+static void print_site_profiles(const struct runtime::statistics& stats)
+{
+  static const std::size_t max_sites = 20;
+  using profile_type = std::shared_ptr<runtime::statistics::site_profile>;
+  std::vector<profile_type> profiles(stats.site_profiles);
+  std::size_t printed = 0;
+
+  if (profiles.empty())
+  {
+    return;
+  }
+  std::stable_sort(
+    std::begin(profiles),
+    std::end(profiles),
+    [](const profile_type& a, const profile_type& b)
+    {
+      return a->total() > b->total();
+    }
+  );
+  std::cerr << "Call sites:" << std::endl;
+  for (const auto& profile : profiles)
+  {
+    const std::pair<const char*, std::size_t> counts[] =
+    {
+      { "integer", profile->integers },
+      { "real", profile->reals },
+      { "string", profile->strings },
+      { "array", profile->arrays },
+      { "other", profile->others }
+    };
+    bool first = true;
+
+    if (printed++ == max_sites)
+    {
+      std::cerr << "  ... and "
+                << profiles.size() - max_sites
+                << " more"
+                << std::endl;
+      break;
+    }
+    std::cerr << "  ";
+    if (profile->has_position)
+    {
+      std::cerr << profile->position << ": ";
+    }
+    std::cerr << utf8_encode(profile->word) << " (";
+    for (const auto& count : counts)
+    {
+      if (!count.second)
+      {
+        continue;
+      }
+      if (first)
+      {
+        first = false;
+      } else {
+        std::cerr << ", ";
+      }
+      std::cerr << count.first << ": " << count.second;
+    }
+    std::cerr << ')' << std::endl;
+  }
+}
+
 static void compile_and_run(const std::shared_ptr<context>& ctx,
                             const std::string& input,
                             const std::u32string& filename)
@@ -332,7 +607,7 @@ static void compile_and_run(const std::shared_ptr<context>& ctx,
     std::exit(EXIT_FAILURE);
   }
 
-  if (!(script = ctx->compile(source, filename)))
+  if (!(script = ctx->compile(source, filename)) || !ctx->check(script))
   {
     handle_error(ctx);
     return;
@@ -345,6 +620,13 @@ static void compile_and_run(const std::shared_ptr<context>& ctx,
     return;
   }
 
+  if (flag_emit_cpp)
+  {
+    plorth::cli::emit_cpp(script, ctx->runtime(), filename, std::cout);
+    std::exit(EXIT_SUCCESS);
+    return;
+  }
+
   if (flag_fork)
   {
 #if HAVE_FORK
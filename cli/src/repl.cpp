@@ -95,6 +95,19 @@ namespace plorth
           continue;
         }
 
+#if PLORTH_ENABLE_FILE_SYSTEM_MODULES
+        // Reload modules which have been changed since previous input was
+        // executed, if the module manager is watching for changes. Modules
+        // which fail to load are reported below and previous versions of
+        // them remain in use.
+        ctx->runtime()->module_manager()->reload(ctx);
+        if (ctx->error())
+        {
+          std::cout << ctx->error() << std::endl;
+          ctx->clear_error();
+        }
+#endif
+
         // Attempt to compile the source code into a quote and execute it
         // unless syntax errors were encountered.
         if (auto script = ctx->compile(source, U"<repl>", line_counter))
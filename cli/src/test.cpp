@@ -0,0 +1,719 @@
+/*
+ * Copyright (c) 2017-2018, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <plorth/plorth.hpp>
+#include <plorth/cli/config.hpp>
+
+#if PLORTH_ENABLE_FILE_SYSTEM_MODULES
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#if PLORTH_ENABLE_THREADS
+# include <thread>
+#endif
+#if HAVE_DIRENT_H
+# include <dirent.h>
+#endif
+#if HAVE_SYS_STAT_H
+# include <sys/stat.h>
+#endif
+
+#include "./utils.hpp"
+
+namespace plorth
+{
+  namespace cli
+  {
+    namespace
+    {
+      using clock = std::chrono::steady_clock;
+
+      /** Index used for test cases which are not inside any `describe`. */
+      static const std::size_t no_suite = static_cast<std::size_t>(-1);
+
+      /**
+       * Result of single `it` block.
+       */
+      struct test_case
+      {
+        /** Index of the enclosing `describe` block. */
+        std::size_t suite;
+        std::string name;
+        /** Time spent executing the block, in seconds. */
+        double time;
+        bool passed;
+        /** Description of the error which failed the test. */
+        std::string message;
+      };
+
+      /**
+       * Aggregated results of single `describe` block.
+       */
+      struct test_suite
+      {
+        /** Name of the block, prefixed with names of enclosing blocks. */
+        std::string name;
+        double time;
+        std::size_t passed;
+        std::size_t failed;
+      };
+
+      /**
+       * Results of single test file.
+       */
+      struct test_file
+      {
+        std::string path;
+        double time;
+        std::vector<test_suite> suites;
+        std::vector<test_case> cases;
+        /** Error which aborted the file outside of any `it` block. */
+        std::string error;
+        /** Everything the file printed while it was executed. */
+        std::string output;
+        std::size_t failed;
+      };
+
+      /**
+       * Output which collects everything written into it, so that output of
+       * test files executed in parallel does not get mixed up.
+       */
+      class buffered_output : public io::output
+      {
+      public:
+        void write(const std::u32string& str)
+        {
+          m_buffer.append(str);
+        }
+
+        std::string take()
+        {
+          const auto result = utf8_encode(m_buffer);
+
+          m_buffer.clear();
+
+          return result;
+        }
+
+      private:
+        std::u32string m_buffer;
+      };
+
+      static double seconds_since(const clock::time_point& start)
+      {
+        return std::chrono::duration<double>(clock::now() - start).count();
+      }
+
+      static std::string describe_error(const std::shared_ptr<error>& err)
+      {
+        std::ostringstream out;
+
+        if (!err)
+        {
+          return "Unknown error.";
+        }
+        if (const auto position = err->position())
+        {
+          if (!position->filename.empty() || position->line)
+          {
+            out << *position << ':';
+          }
+        }
+        out << err->code() << " - " << utf8_encode(err->message());
+
+        return out.str();
+      }
+
+      /**
+       * Executes test files with a runtime of its own. The runtime is
+       * reused for every file the worker executes, so that modules such as
+       * the test framework are compiled only once per worker, while each
+       * file is executed in a new context with a dictionary of its own.
+       */
+      class worker
+      {
+      public:
+        explicit worker(const std::shared_ptr<runtime>& parent)
+          : m_output(new (m_memory_manager) buffered_output())
+          , m_runtime(runtime::make(
+            m_memory_manager,
+            io::input::dummy(m_memory_manager),
+            m_output
+          ))
+          , m_file(nullptr)
+        {
+#if PLORTH_ENABLE_JIT
+          m_runtime->jit_enabled() = parent->jit_enabled();
+#endif
+          m_runtime->arguments() = parent->arguments();
+          utils::scan_module_path(m_runtime, false);
+
+          // Words of the test framework are wrapped once they have been
+          // imported, so that results of the blocks can be recorded.
+          m_runtime->dictionary().insert(m_runtime->word(
+            U"import",
+            m_runtime->native_quote(
+              [this](const std::shared_ptr<context>& ctx)
+              {
+                std::shared_ptr<string> path;
+
+                if (ctx->pop_string(path)
+                    && ctx->runtime()->import(ctx, path->to_string()))
+                {
+                  wrap_framework(ctx);
+                }
+              }
+            )
+          ));
+        }
+
+        worker(const worker&) = delete;
+        worker(worker&&) = delete;
+        void operator=(const worker&) = delete;
+        void operator=(worker&&) = delete;
+
+        void run(test_file& file)
+        {
+          const auto start = clock::now();
+          const auto filename = utf8_decode(file.path);
+          const auto ctx = context::make(m_runtime);
+          std::ifstream is(file.path, std::ios_base::in);
+          std::u32string source;
+          std::shared_ptr<quote> script;
+
+          m_file = &file;
+          m_suite_stack.clear();
+          m_wrappers.clear();
+          ctx->filename(filename);
+          if (!is.good())
+          {
+            file.error = "Unable to open file for reading.";
+          }
+          else if (!utf8_decode_test(
+            std::string(
+              std::istreambuf_iterator<char>(is),
+              std::istreambuf_iterator<char>()
+            ),
+            source
+          ))
+          {
+            file.error = "Unable to decode source code as UTF-8.";
+          }
+          else if (!(script = ctx->compile(source, filename))
+                   || !ctx->check(script)
+                   || !script->call(ctx))
+          {
+            // Failing test case also aborts the file, but there is no need
+            // to report the same error twice.
+            if (!file.failed)
+            {
+              file.error = describe_error(ctx->error());
+            }
+          }
+          file.time = seconds_since(start);
+          file.output = m_output->take();
+          m_file = nullptr;
+        }
+
+      private:
+        static std::string block_name(const std::shared_ptr<context>& ctx)
+        {
+          const auto& data = ctx->data();
+          const auto size = data.size();
+
+          if (size >= 2 && value::is(data[size - 2], value::type::string))
+          {
+            return utf8_encode(data[size - 2]->to_string());
+          }
+
+          return std::string();
+        }
+
+        void wrap_framework(const std::shared_ptr<context>& ctx)
+        {
+          wrap(ctx, U"describe", &worker::run_suite);
+          wrap(ctx, U"it", &worker::run_case);
+        }
+
+        /**
+         * Replaces word with given name in the dictionary of given context
+         * with a native quote which calls the original quote through given
+         * member function.
+         */
+        void wrap(const std::shared_ptr<context>& ctx,
+                  const std::u32string& id,
+                  void (worker::*callback)(const std::shared_ptr<context>&,
+                                           const std::shared_ptr<quote>&))
+        {
+          const auto word = ctx->dictionary().find(id);
+          std::shared_ptr<quote> original;
+          std::shared_ptr<quote> wrapper;
+
+          if (!word || std::find(
+            std::begin(m_wrappers),
+            std::end(m_wrappers),
+            (original = word->quote())
+          ) != std::end(m_wrappers))
+          {
+            return;
+          }
+          wrapper = m_runtime->native_quote(
+            [this, callback, original](const std::shared_ptr<context>& ctx)
+            {
+              (this->*callback)(ctx, original);
+            }
+          );
+          m_wrappers.push_back(wrapper);
+          ctx->dictionary().insert(m_runtime->word(id, wrapper));
+        }
+
+        void run_suite(const std::shared_ptr<context>& ctx,
+                       const std::shared_ptr<quote>& original)
+        {
+          const auto start = clock::now();
+          const auto index = m_file->suites.size();
+          auto name = block_name(ctx);
+
+          if (!m_suite_stack.empty())
+          {
+            name = m_file->suites[m_suite_stack.back()].name + " " + name;
+          }
+          m_file->suites.push_back({ name, 0, 0, 0 });
+          m_suite_stack.push_back(index);
+          original->call(ctx);
+          m_suite_stack.pop_back();
+          m_file->suites[index].time = seconds_since(start);
+        }
+
+        void run_case(const std::shared_ptr<context>& ctx,
+                      const std::shared_ptr<quote>& original)
+        {
+          const auto start = clock::now();
+          test_case result;
+
+          result.suite = m_suite_stack.empty()
+            ? no_suite
+            : m_suite_stack.back();
+          result.name = block_name(ctx);
+          result.passed = original->call(ctx);
+          result.time = seconds_since(start);
+          if (!result.passed)
+          {
+            result.message = describe_error(ctx->error());
+            ++m_file->failed;
+          }
+          if (result.suite != no_suite)
+          {
+            auto& suite = m_file->suites[result.suite];
+
+            ++(result.passed ? suite.passed : suite.failed);
+          }
+          m_file->cases.push_back(result);
+        }
+
+      private:
+        memory::manager m_memory_manager;
+        std::shared_ptr<buffered_output> m_output;
+        std::shared_ptr<runtime> m_runtime;
+        /** File which is currently being executed. */
+        test_file* m_file;
+        /** Indexes of the `describe` blocks currently being executed. */
+        std::vector<std::size_t> m_suite_stack;
+        /** Wrappers created for the file currently being executed. */
+        std::vector<std::shared_ptr<quote>> m_wrappers;
+      };
+
+      static bool is_test_file(const std::string& name)
+      {
+        static const std::string prefix = "test-";
+        static const std::string suffix = ".plorth";
+
+        return name.length() > prefix.length() + suffix.length()
+          && !name.compare(0, prefix.length(), prefix)
+          && !name.compare(name.length() - suffix.length(), suffix.length(), suffix);
+      }
+
+      /**
+       * Adds given path into list of test files. Directories are searched
+       * for files named `test-*.plorth`.
+       */
+      static bool discover(const std::string& path,
+                           std::vector<std::string>& files)
+      {
+#if HAVE_DIRENT_H && HAVE_SYS_STAT_H
+        struct stat st;
+
+        if (::stat(path.c_str(), &st) != 0)
+        {
+          std::cerr << "Unable to find test files from `" << path << "'."
+                    << std::endl;
+
+          return false;
+        }
+        else if (S_ISDIR(st.st_mode))
+        {
+          std::vector<std::string> found;
+          DIR* dir = ::opendir(path.c_str());
+
+          if (!dir)
+          {
+            std::cerr << "Unable to read directory `" << path << "'."
+                      << std::endl;
+
+            return false;
+          }
+          while (const auto entry = ::readdir(dir))
+          {
+            if (is_test_file(entry->d_name))
+            {
+              found.push_back(
+                path + (path.back() == '/' ? "" : "/") + entry->d_name
+              );
+            }
+          }
+          ::closedir(dir);
+          std::sort(std::begin(found), std::end(found));
+          files.insert(std::end(files), std::begin(found), std::end(found));
+
+          return true;
+        }
+#endif
+        files.push_back(path);
+
+        return true;
+      }
+
+      static void print_report(const std::vector<test_file>& results)
+      {
+        std::cout << std::fixed << std::setprecision(3);
+        for (const auto& file : results)
+        {
+          const bool passed = !file.failed && file.error.empty();
+
+          std::cout << (passed ? "PASS " : "FAIL ")
+                    << file.path
+                    << " (" << file.time << "s)"
+                    << std::endl;
+          for (std::size_t i = 0; i < file.suites.size(); ++i)
+          {
+            const auto& suite = file.suites[i];
+
+            std::cout << "  " << suite.name << ": " << suite.passed << " passed";
+            if (suite.failed)
+            {
+              std::cout << ", " << suite.failed << " failed";
+            }
+            std::cout << " (" << suite.time << "s)" << std::endl;
+            for (const auto& c : file.cases)
+            {
+              if (c.suite == i && !c.passed)
+              {
+                std::cout << "    ✘ " << c.name << ": " << c.message
+                          << std::endl;
+              }
+            }
+          }
+          for (const auto& c : file.cases)
+          {
+            if (c.suite == no_suite && !c.passed)
+            {
+              std::cout << "  ✘ " << c.name << ": " << c.message
+                        << std::endl;
+            }
+          }
+          if (!file.error.empty())
+          {
+            std::cout << "  Error: " << file.error << std::endl;
+          }
+          if (!passed && !file.output.empty())
+          {
+            std::istringstream lines(file.output);
+            std::string line;
+
+            std::cout << "  Output:" << std::endl;
+            while (std::getline(lines, line))
+            {
+              std::cout << "    " << line << std::endl;
+            }
+          }
+        }
+      }
+
+      /**
+       * Escapes string for XML attribute or text. Control characters which
+       * cannot be represented in XML, such as ANSI escape sequences used in
+       * output of the test framework, are removed.
+       */
+      static std::string xml_escape(const std::string& input)
+      {
+        std::string result;
+
+        result.reserve(input.length());
+        for (std::size_t i = 0; i < input.length(); ++i)
+        {
+          const auto c = input[i];
+
+          switch (c)
+          {
+          case '&':
+            result.append("&amp;");
+            break;
+
+          case '<':
+            result.append("&lt;");
+            break;
+
+          case '>':
+            result.append("&gt;");
+            break;
+
+          case '"':
+            result.append("&quot;");
+            break;
+
+          case '\'':
+            result.append("&apos;");
+            break;
+
+          case '\x1b':
+            // Skip the whole ANSI escape sequence.
+            if (i + 1 < input.length() && input[i + 1] == '[')
+            {
+              for (i += 2; i < input.length() && !std::isalpha(input[i]); ++i);
+            }
+            break;
+
+          default:
+            if (static_cast<unsigned char>(c) >= 0x20
+                || c == '\t'
+                || c == '\n'
+                || c == '\r')
+            {
+              result.append(1, c);
+            }
+          }
+        }
+
+        return result;
+      }
+
+      static bool write_junit(const char* filename,
+                              const std::vector<test_file>& results,
+                              double time)
+      {
+        std::ofstream out(filename, std::ios_base::out | std::ios_base::trunc);
+        std::size_t tests = 0;
+        std::size_t failures = 0;
+        std::size_t errors = 0;
+
+        if (!out.good())
+        {
+          std::cerr << "Unable to open file `" << filename << "' for writing."
+                    << std::endl;
+
+          return false;
+        }
+        for (const auto& file : results)
+        {
+          tests += file.cases.size() + (file.error.empty() ? 0 : 1);
+          failures += file.failed;
+          errors += file.error.empty() ? 0 : 1;
+        }
+        out << std::fixed << std::setprecision(6);
+        out << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>" << std::endl
+            << "<testsuites"
+            << " tests=\"" << tests << '"'
+            << " failures=\"" << failures << '"'
+            << " errors=\"" << errors << '"'
+            << " time=\"" << time << "\">" << std::endl;
+        for (const auto& file : results)
+        {
+          const auto path = xml_escape(file.path);
+
+          out << "  <testsuite"
+              << " name=\"" << path << '"'
+              << " tests=\""
+              << file.cases.size() + (file.error.empty() ? 0 : 1) << '"'
+              << " failures=\"" << file.failed << '"'
+              << " errors=\"" << (file.error.empty() ? 0 : 1) << '"'
+              << " time=\"" << file.time << "\">" << std::endl;
+          for (const auto& c : file.cases)
+          {
+            out << "    <testcase"
+                << " classname=\""
+                << (c.suite == no_suite
+                  ? path
+                  : xml_escape(file.suites[c.suite].name)) << '"'
+                << " name=\"" << xml_escape(c.name) << '"'
+                << " time=\"" << c.time << '"';
+            if (c.passed)
+            {
+              out << "/>" << std::endl;
+              continue;
+            }
+            out << '>' << std::endl
+                << "      <failure message=\"" << xml_escape(c.message)
+                << "\"/>" << std::endl
+                << "    </testcase>" << std::endl;
+          }
+          if (!file.error.empty())
+          {
+            out << "    <testcase classname=\"" << path << '"'
+                << " name=\"" << path << '"'
+                << " time=\"" << file.time << "\">" << std::endl
+                << "      <error message=\"" << xml_escape(file.error)
+                << "\"/>" << std::endl
+                << "    </testcase>" << std::endl;
+          }
+          if ((file.failed || !file.error.empty()) && !file.output.empty())
+          {
+            out << "    <system-out>" << xml_escape(file.output)
+                << "</system-out>" << std::endl;
+          }
+          out << "  </testsuite>" << std::endl;
+        }
+        out << "</testsuites>" << std::endl;
+
+        return out.good();
+      }
+    }
+
+    int run_tests(const std::shared_ptr<runtime>& runtime,
+                  const std::vector<std::string>& paths,
+                  const char* junit_filename,
+                  unsigned long jobs)
+    {
+      const auto start = clock::now();
+      std::vector<std::string> files;
+      std::vector<test_file> results;
+      std::atomic<std::size_t> next(0);
+      std::size_t worker_count = 1;
+#if !PLORTH_ENABLE_THREADS
+      (void) jobs;
+#endif
+      std::size_t failed = 0;
+      std::size_t total = 0;
+      double time;
+
+      for (const auto& path : paths.empty()
+           ? std::vector<std::string>{ "tests" }
+           : paths)
+      {
+        if (!discover(path, files))
+        {
+          return EXIT_FAILURE;
+        }
+      }
+      if (files.empty())
+      {
+        std::cerr << "No test files were found." << std::endl;
+
+        return EXIT_FAILURE;
+      }
+      results.resize(files.size());
+      for (std::size_t i = 0; i < files.size(); ++i)
+      {
+        results[i].path = files[i];
+        results[i].time = 0;
+        results[i].failed = 0;
+      }
+
+      // Each worker takes the next file which has not yet been taken by
+      // other workers, until all of the files have been executed.
+      const auto work = [&runtime, &results, &next]()
+      {
+        std::unique_ptr<worker> w;
+
+        for (;;)
+        {
+          const auto index = next++;
+
+          if (index >= results.size())
+          {
+            return;
+          }
+          if (!w)
+          {
+            w.reset(new worker(runtime));
+          }
+          w->run(results[index]);
+        }
+      };
+
+#if PLORTH_ENABLE_THREADS
+      std::vector<std::thread> threads;
+
+      worker_count = jobs
+        ? jobs
+        : std::max(1u, std::thread::hardware_concurrency());
+      worker_count = std::min(worker_count, files.size());
+      // The calling thread is also used as one of the workers.
+      for (std::size_t i = 1; i < worker_count; ++i)
+      {
+        threads.emplace_back(work);
+      }
+#endif
+      work();
+#if PLORTH_ENABLE_THREADS
+      for (auto& thread : threads)
+      {
+        thread.join();
+      }
+#endif
+      time = seconds_since(start);
+
+      print_report(results);
+      for (const auto& file : results)
+      {
+        total += file.cases.size();
+        if (file.failed || !file.error.empty())
+        {
+          ++failed;
+        }
+      }
+      std::cout << std::endl
+                << results.size() << " files, "
+                << total << " tests, "
+                << failed << " failed files in "
+                << time << "s ("
+                << worker_count << (worker_count == 1 ? " worker)" : " workers)")
+                << std::endl;
+
+      if (junit_filename && !write_junit(junit_filename, results, time))
+      {
+        return EXIT_FAILURE;
+      }
+
+      return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+  }
+}
+#endif
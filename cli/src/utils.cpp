@@ -32,53 +32,13 @@ namespace plorth
     namespace utils
     {
 #if PLORTH_ENABLE_FILE_SYSTEM_MODULES
-      void scan_module_path(const std::shared_ptr<runtime>& rt)
+      void scan_module_path(const std::shared_ptr<runtime>& rt, bool watch)
       {
-#if defined(_WIN32)
-        static const char path_separator = ';';
-#else
-        static const char path_separator = ':';
-#endif
-        std::vector<std::u32string> module_paths;
-        auto begin = std::getenv("PLORTHPATH");
-        auto end = begin;
-
-        if (end)
-        {
-          for (; *end; ++end)
-          {
-            if (*end != path_separator)
-            {
-              continue;
-            }
-
-            if (end - begin > 0)
-            {
-              module_paths.push_back(utf8_decode(
-                std::string(begin, end - begin)
-              ));
-            }
-            begin = end + 1;
-          }
-
-          if (end - begin > 0)
-          {
-            module_paths.push_back(utf8_decode(
-              std::string(begin, end - begin)
-            ));
-          }
-        }
-
-#if defined(PLORTH_RUNTIME_LIBRARY_PATH)
-        if (module_paths.empty())
-        {
-          module_paths.push_back(PLORTH_RUNTIME_LIBRARY_PATH);
-        }
-#endif
-
         rt->module_manager() = module::manager::file_system(
           rt->memory_manager(),
-          module_paths
+          module::manager::default_lookup_paths(),
+          module::manager::default_module_file_extension,
+          watch
         );
       }
 #endif
@@ -34,7 +34,7 @@ namespace plorth
     namespace utils
     {
 #if PLORTH_ENABLE_FILE_SYSTEM_MODULES
-      void scan_module_path(const std::shared_ptr<runtime>&);
+      void scan_module_path(const std::shared_ptr<runtime>&, bool watch);
 #endif
 
       template<class StringT>
@@ -0,0 +1,50 @@
+# Compiles Plorth script ahead of time into standalone executable, which is
+# linked against libplorth. The script is translated into C++ with the
+# `--emit-cpp` option of the interpreter.
+#
+#   PLORTH_ADD_EXECUTABLE(<name> <script>)
+#
+# Interpreter built by this project is used when available, otherwise it's
+# looked up from the system.
+FUNCTION(PLORTH_ADD_EXECUTABLE NAME SCRIPT)
+  GET_FILENAME_COMPONENT(SCRIPT_PATH ${SCRIPT} ABSOLUTE)
+  SET(OUTPUT ${CMAKE_CURRENT_BINARY_DIR}/${NAME}.cpp)
+
+  IF(TARGET plorth-cli)
+    SET(PLORTH_INTERPRETER $<TARGET_FILE:plorth-cli>)
+    SET(PLORTH_INTERPRETER_DEPENDENCY plorth-cli)
+  ELSE()
+    FIND_PROGRAM(PLORTH_INTERPRETER plorth)
+    IF(NOT PLORTH_INTERPRETER)
+      MESSAGE(FATAL_ERROR "Plorth interpreter was not found.")
+    ENDIF()
+  ENDIF()
+
+  ADD_CUSTOM_COMMAND(
+    OUTPUT
+      ${OUTPUT}
+    COMMAND
+      ${PLORTH_INTERPRETER} --emit-cpp ${SCRIPT_PATH} > ${OUTPUT}
+    DEPENDS
+      ${SCRIPT_PATH}
+      ${PLORTH_INTERPRETER_DEPENDENCY}
+    COMMENT
+      "Translating ${SCRIPT} into C++"
+  )
+
+  ADD_EXECUTABLE(
+    ${NAME}
+    ${OUTPUT}
+  )
+
+  TARGET_COMPILE_FEATURES(
+    ${NAME}
+    PRIVATE
+      cxx_std_11
+  )
+
+  TARGET_LINK_LIBRARIES(
+    ${NAME}
+    plorth
+  )
+ENDFUNCTION()
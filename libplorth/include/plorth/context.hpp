@@ -30,9 +30,11 @@
 #include <plorth/value-error.hpp>
 
 #include <deque>
+#include <unordered_map>
 
 namespace plorth
 {
+  class token;
   class word;
 
   /**
@@ -43,6 +45,22 @@ namespace plorth
   public:
     using container_type = std::deque<std::shared_ptr<value>>;
 
+    /**
+     * Module bound as a namespace.
+     */
+    struct namespace_binding
+    {
+      /** Path which the module was imported from. */
+      std::u32string path;
+      /** The imported module. */
+      std::shared_ptr<object> module;
+    };
+
+    using namespace_container_type = std::unordered_map<
+      std::u32string,
+      namespace_binding
+    >;
+
     /**
      * Constructs new context.
      *
@@ -93,6 +111,38 @@ namespace plorth
                const std::u32string& message,
                const struct position* position = nullptr);
 
+    /**
+     * Constructs new error instance with given error code and error message
+     * and replaces this execution state's currently uncaught error with it.
+     * The message is not copied, so it must be a string literal or otherwise
+     * remain valid for the lifetime of the error.
+     *
+     * \param code     Error code
+     * \param message  Textual description of the error
+     * \param position Optional position in the source code where the error
+     *                 occurred
+     */
+    void error(enum error::code code,
+               const char32_t* message,
+               const struct position* position = nullptr);
+
+    /**
+     * Replaces currently uncaught error with range error about stack
+     * underflow. Previously constructed error instance is reused if it's not
+     * referenced anywhere else.
+     */
+    void stack_underflow();
+
+    /**
+     * Replaces currently uncaught error with type error about value of
+     * unexpected type. Previously constructed error instance is reused if
+     * it's not referenced anywhere else.
+     *
+     * \param expected Type of value which was expected.
+     * \param actual   Type of value which was encountered instead.
+     */
+    void type_mismatch(enum value::type expected, enum value::type actual);
+
     /**
      * Removes currently uncaught error in the context.
      */
@@ -117,6 +167,78 @@ namespace plorth
       return m_dictionary;
     }
 
+    /**
+     * Returns the modules which have been bound as namespaces in this
+     * context.
+     */
+    inline const namespace_container_type& namespaces() const
+    {
+      return m_namespaces;
+    }
+
+    /**
+     * Binds given module as a namespace in this context. Words of the module
+     * can then be called with qualified symbols such as `name:word`, and
+     * they are resolved only when used.
+     *
+     * \param name   Name of the namespace.
+     * \param path   Path which the module was imported from. Used for
+     *               importing new version of the module if it's reloaded.
+     * \param module Module to bind under the namespace.
+     */
+    void bind_namespace(const std::u32string& name,
+                        const std::u32string& path,
+                        const std::shared_ptr<object>& module);
+
+    /**
+     * Resolves qualified symbol such as `name:word` into a word exported by
+     * module bound as namespace in this context. Results are cached into the
+     * symbol until namespaces of the context are changed.
+     *
+     * \param symbol Symbol to resolve.
+     * \param module Where the module which the word belongs to will be
+     *               placed into.
+     * \return       Quote of the word, or null reference if the symbol does
+     *               not resolve into any word from the namespaces.
+     */
+    std::shared_ptr<quote> resolve_qualified(
+      const std::shared_ptr<class symbol>& symbol,
+      std::shared_ptr<object>& module
+    );
+
+    /**
+     * Resolves symbol into a word from the module which the quote currently
+     * being executed was defined in, which allows words of a module to call
+     * each other without qualified names.
+     *
+     * \param symbol Symbol to resolve.
+     * \return       Quote of the word, or null reference if the quote does
+     *               not belong to any module or the module does not have
+     *               such word.
+     */
+    std::shared_ptr<quote> resolve_scoped(
+      const std::shared_ptr<class symbol>& symbol
+    ) const;
+
+    /**
+     * Provides direct access to the modules which the quotes currently being
+     * executed were defined in, innermost last. Null references are used for
+     * quotes which do not belong to any module.
+     */
+    inline std::vector<std::shared_ptr<object>>& module_scopes()
+    {
+      return m_module_scopes;
+    }
+
+    /**
+     * Returns the module which the quote currently being executed was defined
+     * in, or null pointer if it does not belong to any module.
+     */
+    inline const object* module_scope() const
+    {
+      return m_module_scopes.empty() ? nullptr : m_module_scopes.back().get();
+    }
+
     /**
      * Compiles given source code into a quote.
      *
@@ -135,6 +257,30 @@ namespace plorth
                                    int line = 1,
                                    int column = 1);
 
+    /**
+     * Compiles tokens which have already been parsed from source code into
+     * a quote.
+     *
+     * \param tokens Tokens to compile into quote.
+     * \return       Reference to the quote that was compiled from the tokens.
+     */
+    std::shared_ptr<quote> compile(
+      const std::vector<std::shared_ptr<token>>& tokens
+    );
+
+    /**
+     * Checks compiled quote against static stack effects of the words it
+     * consists of, before it's executed in this context. Currently this
+     * detects code which is certain to underflow the stack, as long as the
+     * types of the values are known up to that point.
+     *
+     * \param quote Quote to check.
+     * \return      Boolean flag which tells whether the quote passed the
+     *              check or not. If not, an error will be set in the
+     *              context.
+     */
+    bool check(const std::shared_ptr<quote>& quote);
+
     /**
      * Provides direct access to the data stack.
      */
@@ -387,6 +533,21 @@ namespace plorth
      */
     bool pop_word(std::shared_ptr<word>& slot);
 
+    /**
+     * Pops value from the data stack without checking that the stack is not
+     * empty or that the value is of expected type. Only unchecked variants of
+     * native words use this, as their callers have already verified the
+     * values on the stack.
+     *
+     * \param slot Where the value will be placed into.
+     */
+    template<class T>
+    inline void pop_unchecked(std::shared_ptr<T>& slot)
+    {
+      slot = std::static_pointer_cast<T>(m_data.back());
+      m_data.pop_back();
+    }
+
 #if PLORTH_ENABLE_FILE_SYSTEM_MODULES
     /**
      * Returns optional filename of the context, when the context is executed
@@ -433,15 +594,42 @@ namespace plorth
      */
     explicit context(const std::shared_ptr<class runtime>& runtime);
 
+  private:
+    /**
+     * Replaces modules bound as namespaces with their current versions, after
+     * modules have been reloaded by the module manager.
+     */
+    void refresh_namespaces();
+
+    /**
+     * Returns position which is attached to errors constructed by the
+     * context, when no position is explicitly given.
+     */
+    const struct position* error_position(
+      const struct position* position
+    ) const;
+
   private:
     /** Runtime associated with this context. */
     const std::shared_ptr<class runtime> m_runtime;
     /** Currently uncaught error in this context. */
     std::shared_ptr<class error> m_error;
+    /** Reusable stack underflow error. */
+    std::shared_ptr<class error> m_stack_underflow_error;
+    /** Reusable type mismatch error. */
+    std::shared_ptr<class error> m_type_mismatch_error;
     /** Data stack used for storing values in this context. */
     container_type m_data;
     /** Container for words associated with this context. */
     class dictionary m_dictionary;
+    /** Modules bound as namespaces in this context. */
+    namespace_container_type m_namespaces;
+    /** Version of the namespaces, or 0 if none have been bound. */
+    unsigned long m_namespace_version;
+    /** Generation of the modules bound as namespaces. */
+    unsigned long m_module_generation;
+    /** Modules of the quotes which are currently being executed. */
+    std::vector<std::shared_ptr<object>> m_module_scopes;
 #if PLORTH_ENABLE_FILE_SYSTEM_MODULES
     /** Optional filename of the context, when executed as module. */
     std::u32string m_filename;
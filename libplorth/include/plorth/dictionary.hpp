@@ -68,6 +68,17 @@ namespace plorth
       return m_words.size();
     }
 
+    /**
+     * Returns version of the dictionary, which changes whenever words are
+     * inserted into it. Versions are unique across all dictionaries, so
+     * that a lookup result cached for one dictionary is never mistaken to be
+     * valid for another one.
+     */
+    inline unsigned long version() const
+    {
+      return m_version;
+    }
+
     /**
      * Returns words from the dictionary as iterable vector.
      */
@@ -96,6 +107,8 @@ namespace plorth
   private:
     /** Container for the words in the dictionary. */
     container_type m_words;
+    /** Current version of the dictionary. */
+    unsigned long m_version;
   };
 }
 
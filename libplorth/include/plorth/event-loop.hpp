@@ -0,0 +1,170 @@
+/*
+ * Copyright (c) 2017-2018, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef PLORTH_EVENT_LOOP_HPP_GUARD
+#define PLORTH_EVENT_LOOP_HPP_GUARD
+
+#include <plorth/value-file.hpp>
+#include <plorth/value-quote.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <unordered_map>
+
+namespace plorth
+{
+  /**
+   * Readiness based event loop owned by the runtime. Files in non-blocking
+   * mode, such as pipes and Unix domain sockets, are watched with epoll and
+   * quotes registered for them are called once they become readable or
+   * writable. Quotes can also be scheduled to be called after a delay. All
+   * of the callbacks are called in the thread which runs the loop.
+   */
+  class event_loop
+  {
+  public:
+    using clock = std::chrono::steady_clock;
+
+    /**
+     * Enumeration of events which can be watched for.
+     */
+    enum class event
+    {
+      readable,
+      writable
+    };
+
+    /**
+     * Constructs new event loop. The epoll instance is created once the loop
+     * is run for the first time.
+     */
+    explicit event_loop();
+
+    ~event_loop();
+
+    event_loop(const event_loop&) = delete;
+    event_loop(event_loop&&) = delete;
+    void operator=(const event_loop&) = delete;
+    void operator=(event_loop&&) = delete;
+
+    /**
+     * Returns boolean flag indicating whether the event loop is currently
+     * being run.
+     */
+    inline bool is_running() const
+    {
+      return m_running;
+    }
+
+    /**
+     * Registers quote to be called with the file whenever given event occurs
+     * on it. Previously registered quote for the same event is replaced.
+     * Null pointer as the quote stops watching for the event.
+     */
+    void watch(const std::shared_ptr<file>& f,
+               enum event event,
+               const std::shared_ptr<quote>& callback);
+
+    /**
+     * Stops watching the file for any events. Pending output of the file is
+     * still written once the file becomes writable.
+     */
+    void unwatch(const std::shared_ptr<file>& f);
+
+    /**
+     * Makes the event loop write pending output of given non-blocking file
+     * once the file becomes writable.
+     */
+    void flush_later(const std::shared_ptr<file>& f);
+
+    /**
+     * Schedules quote to be called once given amount of time has passed.
+     */
+    void set_timeout(const clock::duration& delay,
+                     const std::shared_ptr<quote>& callback);
+
+    /**
+     * Runs the event loop until there are no more files to watch or timers
+     * to wait for, or until one of the callbacks fails.
+     *
+     * \param ctx Execution context in which the callbacks are called.
+     * \return    Boolean flag indicating whether the loop finished without
+     *            errors. If not, the error has been set to the context.
+     */
+    bool run(const std::shared_ptr<context>& ctx);
+
+  private:
+    /**
+     * File watched by the event loop and the quotes registered for it.
+     */
+    struct watcher
+    {
+      /** The watched file. */
+      std::shared_ptr<class file> file;
+      /** Quote called when the file becomes readable. */
+      std::shared_ptr<quote> on_readable;
+      /** Quote called when the file becomes writable. */
+      std::shared_ptr<quote> on_writable;
+      /** Events which the file has been registered with epoll for. */
+      std::uint32_t registered;
+    };
+
+    /**
+     * Returns watcher entry for given file, creating it if necessary.
+     */
+    watcher& entry(const std::shared_ptr<file>& f);
+
+    /**
+     * Removes entries of files which have been closed or which no longer
+     * have anything to watch for, and updates epoll registrations of the
+     * remaining ones.
+     */
+    bool sync(const std::shared_ptr<context>& ctx);
+
+    /**
+     * Calls quotes of timers which have expired.
+     */
+    bool run_timers(const std::shared_ptr<context>& ctx);
+
+    /**
+     * Returns the number of milliseconds until the next timer expires, or -1
+     * if there are no timers.
+     */
+    int next_timeout() const;
+
+  private:
+    /** File descriptor of the epoll instance, or -1 if not yet created. */
+    int m_epoll_fd;
+    /** Whether the loop is currently being run. */
+    bool m_running;
+    /** Watched files, keyed by their file descriptors. */
+    std::unordered_map<int, watcher> m_watchers;
+    /** Scheduled quotes, ordered by their expiration times. */
+    std::multimap<clock::time_point, std::shared_ptr<quote>> m_timers;
+  };
+}
+
+#endif /* !PLORTH_EVENT_LOOP_HPP_GUARD */
@@ -51,7 +51,12 @@ namespace plorth
         /** End of input was encountered. */
         eof = -1,
         /** Unicode decoding error was encountered. */
-        failure = 0
+        failure = 0,
+        /**
+         * Input is in non-blocking mode and nothing more could be read
+         * without blocking.
+         */
+        would_block = 2
       };
 
       /**
@@ -82,6 +87,19 @@ namespace plorth
         std::u32string& output,
         size_type& read
       ) = 0;
+
+      /**
+       * Reads single line from the input and places it into the string given
+       * as argument. The line separator, either "\n" or "\r\n", is not
+       * included in the output. Default implementation reads the input one
+       * character at a time; inputs which are able to read entire lines at
+       * once should override it.
+       *
+       * \param output Where the read Unicode characters will be placed into.
+       * \return       Result of the read operation. End of input is returned
+       *               only when there was nothing left to be read.
+       */
+      virtual result read_line(std::u32string& output);
     };
   }
 }
@@ -28,6 +28,8 @@
 
 #include <plorth/value-object.hpp>
 
+#include <unordered_map>
+
 namespace plorth
 {
   namespace module
@@ -39,6 +41,12 @@ namespace plorth
     class manager : public memory::managed
     {
     public:
+      /** Container for source code of modules, keyed by path. */
+      using file_container_type = std::unordered_map<
+        std::u32string,
+        std::u32string
+      >;
+
       /** File extension used for external modules by default. */
       static const std::u32string default_module_file_extension;
 
@@ -51,11 +59,45 @@ namespace plorth
        *                              from.
        * \param module_file_extension File extension used to recognize modules
        *                              from other files.
+       * \param watch                 Whether the file system should be
+       *                              watched for changes, so that cached
+       *                              results of path resolution can be
+       *                              discarded when files are added or
+       *                              removed. Useful for long running
+       *                              processes. Only supported on platforms
+       *                              which have inotify.
        */
       static std::shared_ptr<manager> file_system(
         memory::manager& memory_manager,
         const std::vector<std::u32string>& lookup_paths
           = std::vector<std::u32string>(),
+        const std::u32string& module_file_extension
+          = default_module_file_extension,
+        bool watch = false
+      );
+
+      /**
+       * Returns directories where modules are looked up from by default.
+       * These are listed in the `PLORTHPATH` environment variable, separated
+       * from each other with `:`, or `;` on Windows. If the variable is not
+       * set, the directory where the runtime library has been installed is
+       * used instead.
+       */
+      static std::vector<std::u32string> default_lookup_paths();
+
+      /**
+       * Constructs module manager which loads modules from source code held
+       * in memory instead of file system. Useful for embedding the
+       * interpreter and for measuring cost of imports without disk I/O.
+       *
+       * \param files                 Source code of the modules, keyed by
+       *                              path such as `/lib/util.plorth`.
+       * \param module_file_extension File extension which may be omitted
+       *                              when importing the modules.
+       */
+      static std::shared_ptr<manager> virtual_file_system(
+        memory::manager& memory_manager,
+        const file_container_type& files,
         const std::u32string& module_file_extension
           = default_module_file_extension
       );
@@ -79,6 +121,95 @@ namespace plorth
         const std::shared_ptr<context>& ctx,
         const std::u32string& path
       ) = 0;
+
+      /**
+       * Prepares modules from given paths, and modules which they import, to
+       * be imported later. Source code of the modules is read and parsed
+       * ahead of time, possibly in parallel, but the modules are executed
+       * only when they are actually imported.
+       *
+       * Preloading is only an optimization, so modules which cannot be
+       * preloaded are silently ignored. Errors will be reported once such
+       * modules are imported.
+       *
+       * \param ctx   Execution context where the modules will be imported
+       *              into. Used for resolving relative paths.
+       * \param paths Paths of the modules to preload.
+       * \return      Number of modules which were preloaded.
+       */
+      virtual std::size_t preload(
+        const std::shared_ptr<context>& ctx,
+        const std::vector<std::u32string>& paths
+      );
+
+      /**
+       * Discards parsed source code of module from given path, which has
+       * been preloaded but will not be imported, such as the main program
+       * which is preloaded only so that modules it imports are preloaded as
+       * well.
+       *
+       * \param ctx  Execution context used for resolving relative path.
+       * \param path Path of the module.
+       */
+      virtual void discard_preloaded(const std::shared_ptr<context>& ctx,
+                                     const std::u32string& path);
+
+      /**
+       * Reloads imported modules whose source code has changed since they
+       * were imported, and modules which import them. This requires the
+       * module manager to know about the changes. File system module manager
+       * watches for them when it has been constructed with watching enabled,
+       * and virtual file system module manager is told about them with
+       * write_file().
+       *
+       * New versions of the modules are loaded completely before they
+       * replace the old ones in the module cache, so code which is already
+       * running keeps using the versions it started with. If a module fails
+       * to load, it's previous version is kept and the error is placed into
+       * the given context.
+       *
+       * This must be called from the thread which executes the programs,
+       * between executions, such as when a long running process is idle.
+       *
+       * \param ctx Execution context used for executing the new versions of
+       *            the modules and for reporting errors.
+       * \return    Number of modules which were reloaded.
+       */
+      virtual std::size_t reload(const std::shared_ptr<context>& ctx);
+
+      /**
+       * Replaces source code of a module held in memory by module manager
+       * constructed with virtual_file_system(). If the module has been
+       * imported, it and modules which import it are reloaded on next call
+       * to reload().
+       *
+       * \param path   Path of the module, such as `/lib/util.plorth`.
+       * \param source New source code of the module.
+       * \return       Boolean flag which tells whether the module manager
+       *               holds source code of modules in memory or not.
+       */
+      virtual bool write_file(const std::u32string& path,
+                              const std::u32string& source);
+
+      /**
+       * Returns the number of times modules have been reloaded. Namespaces
+       * bound to modules are updated to the new versions of the modules when
+       * this changes.
+       */
+      inline unsigned long generation() const
+      {
+        return m_generation;
+      }
+
+    protected:
+      /**
+       * Constructs new module manager.
+       */
+      explicit manager();
+
+    protected:
+      /** Number of times modules have been reloaded. */
+      unsigned long m_generation;
     };
   }
 }
@@ -31,14 +31,20 @@
 #include <plorth/value.hpp>
 #include <plorth/value-array.hpp>
 #include <plorth/value-boolean.hpp>
+#include <plorth/value-bytes.hpp>
 #include <plorth/value-error.hpp>
+#include <plorth/value-file.hpp>
 #include <plorth/value-number.hpp>
 #include <plorth/value-object.hpp>
 #include <plorth/value-quote.hpp>
+#include <plorth/value-stream.hpp>
 #include <plorth/value-string.hpp>
+#include <plorth/value-string-builder.hpp>
 #include <plorth/value-word.hpp>
 
+#include <plorth/stack-effect.hpp>
 #include <plorth/runtime.hpp>
 #include <plorth/context.hpp>
+#include <plorth/event-loop.hpp>
 
 #endif /* !PLORTH_PLORTH_HPP_GUARD */
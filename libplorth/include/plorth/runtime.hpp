@@ -30,19 +30,120 @@
 #include <plorth/io-input.hpp>
 #include <plorth/io-output.hpp>
 #include <plorth/module.hpp>
+#include <plorth/position.hpp>
 #include <plorth/value-array.hpp>
 #include <plorth/value-boolean.hpp>
+#include <plorth/value-bytes.hpp>
 #include <plorth/value-number.hpp>
 #include <plorth/value-string.hpp>
 
+#if PLORTH_ENABLE_CHARACTER_CACHE && PLORTH_ENABLE_MUTEXES
+# include <mutex>
+#endif
+
 namespace plorth
 {
+  class event_loop;
+
   class runtime : public memory::managed
   {
   public:
-    using prototype_definition = std::vector<
-      std::pair<const char32_t*, quote::callback>
-    >;
+    /**
+     * Definition of a native word.
+     */
+    struct word_definition
+    {
+      /** Name of the word. */
+      const char32_t* name;
+      /** C++ function which implements the word. */
+      quote::callback callback;
+      /**
+       * Static stack effect of the word in notation described in
+       * stack_effect, or null pointer if the effect depends on runtime
+       * values, such as words which call quotes.
+       */
+      const char32_t* stack_effect;
+      /**
+       * Optional variant of the C++ function which does not check the values
+       * it takes from the stack. It is called instead of the checked one
+       * when types of the values have been verified against the stack effect
+       * by the caller.
+       */
+      quote::native_function unchecked;
+    };
+    using prototype_definition = std::vector<word_definition>;
+
+    /**
+     * Counters collected by the runtime while executing scripts.
+     */
+    struct statistics
+    {
+      /**
+       * Operand types observed by an arithmetic or comparison call site,
+       * collected when site profiling has been enabled.
+       */
+      struct site_profile
+      {
+        /** Name of the word called by the site. */
+        std::u32string word;
+        /** Whether position of the site in source code is known. */
+        bool has_position;
+        /** Position of the site in source code. */
+        struct position position;
+        /** Number of executions with two integers as operands. */
+        std::size_t integers;
+        /** Number of executions with real numbers as operands. */
+        std::size_t reals;
+        /** Number of executions with two strings as operands. */
+        std::size_t strings;
+        /** Number of executions with two arrays as operands. */
+        std::size_t arrays;
+        /** Number of executions with any other operands. */
+        std::size_t others;
+
+        /**
+         * Returns total number of executions of the site.
+         */
+        inline std::size_t total() const
+        {
+          return integers + reals + strings + arrays + others;
+        }
+      };
+
+      /** Number of objects constructed by modifying another object. */
+      std::size_t object_updates;
+      /** Sum of layer depths of objects constructed by modifications. */
+      std::size_t object_depth_total;
+      /** Number of times when layered objects have been compacted. */
+      std::size_t object_compactions;
+#if PLORTH_ENABLE_JIT
+      /** Number of quotes translated into machine code. */
+      std::size_t jit_compilations;
+      /** Number of quotes whose machine code has been discarded. */
+      std::size_t jit_deoptimizations;
+#endif
+      /** Number of call sites where a word has been inlined. */
+      std::size_t inlined_words;
+      /**
+       * Number of call sites which call unchecked variant of a native word.
+       */
+      std::size_t unchecked_sites;
+      /** Whether operand types of call sites should be profiled. */
+      bool profile_sites;
+      /** Profiles of the call sites executed so far. */
+      std::vector<std::shared_ptr<site_profile>> site_profiles;
+
+      /**
+       * Returns average layer depth of objects constructed by modifying
+       * another object.
+       */
+      inline double average_object_depth() const
+      {
+        return object_updates > 0
+          ? static_cast<double>(object_depth_total) / object_updates
+          : 0.0;
+      }
+    };
 #if PLORTH_ENABLE_SYMBOL_CACHE
     using symbol_cache = std::unordered_map<
       std::u32string,
@@ -168,6 +269,66 @@ namespace plorth
       return m_arguments;
     }
 
+#if PLORTH_ENABLE_JIT
+    /**
+     * Returns flag which tells whether frequently called quotes are
+     * translated into machine code.
+     */
+    inline bool& jit_enabled()
+    {
+      return m_jit_enabled;
+    }
+
+    /**
+     * Returns flag which tells whether frequently called quotes are
+     * translated into machine code.
+     */
+    inline bool jit_enabled() const
+    {
+      return m_jit_enabled;
+    }
+#endif
+
+#if PLORTH_ENABLE_EVENT_LOOP
+    /**
+     * Returns the event loop of the runtime, creating it if necessary.
+     */
+    class event_loop& event_loop();
+#endif
+
+    /**
+     * Returns counters collected by the runtime while executing scripts.
+     */
+    inline struct statistics& statistics()
+    {
+      return m_statistics;
+    }
+
+    /**
+     * Returns counters collected by the runtime while executing scripts.
+     */
+    inline const struct statistics& statistics() const
+    {
+      return m_statistics;
+    }
+
+    /**
+     * Looks up word with name of given symbol from the built-in prototype of
+     * given value type. Words of all built-in prototypes are stored in a
+     * single table keyed by the hash code of the symbol, so that a symbol
+     * which is not contained in any of the prototypes, such as name of a
+     * global word, is rejected with a single probe.
+     *
+     * \param type   Type of the value whose prototype is searched.
+     * \param symbol Symbol which names the word.
+     * \param slot   Where the found word will be placed into.
+     * \return       Boolean flag which tells whether the prototype contains
+     *               the word or not.
+     */
+    bool prototype_word(enum value::type type,
+                        const class symbol& symbol,
+                        std::shared_ptr<class value>& slot) const;
+
     /**
      * Reads Unicode code points from the input of the interpreter and places
      * them in the string given as argument.
@@ -190,6 +351,13 @@ namespace plorth
      */
     void print(const std::u32string& str) const;
 
+    /**
+     * Outputs contents of given string value into the output of the
+     * interpreter. The string is written in chunks, so that it's contents
+     * never need to be constructed in memory all at once.
+     */
+    void print(const std::shared_ptr<class string>& str) const;
+
     /**
      * Imports module using runtime's module manager and insert all of it's
      * exported words into dictionary of given execution context.
@@ -206,6 +374,26 @@ namespace plorth
       const std::u32string& path
     );
 
+    /**
+     * Imports module using runtime's module manager and binds it as a
+     * namespace in given execution context. Exported words of the module are
+     * not copied anywhere, but looked up from the module when qualified
+     * symbols such as `ns:word` are executed.
+     *
+     * \param context Execution context where the namespace will be bound
+     *                to, and where any errors thrown during the module import
+     *                will be placed.
+     * \param path    Path to the module to which will be imported.
+     * \param ns      Name of the namespace.
+     * \return        Boolean flag telling whether the import was successful or
+     *                whether some kind of error occurred.
+     */
+    bool import(
+      const std::shared_ptr<class context>& context,
+      const std::u32string& path,
+      const std::u32string& ns
+    );
+
     /**
      * Outputs system specific new line into the output of the interpreter.
      */
@@ -252,6 +440,17 @@ namespace plorth
     std::shared_ptr<class array> array(array::const_pointer elements,
                                        array::size_type size);
 
+    /**
+     * Constructs byte sequence by copying given bytes into memory allocated
+     * from the memory manager.
+     *
+     * \param data   Bytes to construct the byte sequence from.
+     * \param length Number of bytes in the sequence.
+     * \return       Reference to the created byte sequence.
+     */
+    std::shared_ptr<class bytes> bytes(bytes::const_pointer data,
+                                       bytes::size_type length);
+
     /**
      * Constructs object value from given properties.
      *
@@ -280,6 +479,27 @@ namespace plorth
     std::shared_ptr<class string> string(string::const_pointer chars,
                                          string::size_type length);
 
+    /**
+     * Constructs string value which takes ownership of given array of Unicode
+     * code points, allocated with new[]. Short strings are copied instead
+     * and the array is released immediately.
+     *
+     * \param chars  Array of Unicode characters to construct the string from.
+     * \param length Number of characters in the string.
+     * \return       Reference to the created string value.
+     */
+    std::shared_ptr<class string> adopt_string(string::pointer chars,
+                                               string::size_type length);
+
+    /**
+     * Constructs string value which consists of single Unicode character.
+     * Strings of commonly used characters are shared.
+     *
+     * \param c Unicode character to construct the string from.
+     * \return  Reference to the created string value.
+     */
+    std::shared_ptr<class string> character(string::value_type c);
+
     /**
      * Constructs symbol from given identifier string.
      *
@@ -301,9 +521,32 @@ namespace plorth
     );
 
     /**
-     * Constructs native quote from given C++ callback.
+     * Constructs compiled quote from given sequence of values, which executes
+     * the values with given native code instead of interpreting them.
+     *
+     * \param values Values which the quote consists of.
+     * \param code   Native code generated from the values.
+     * \return       Reference to the created quote.
      */
-    std::shared_ptr<quote> native_quote(quote::callback callback);
+    std::shared_ptr<quote> compiled_quote(
+      const std::vector<std::shared_ptr<value>>& values,
+      quote::native_code code
+    );
+
+    /**
+     * Constructs native quote from given C++ callback.
+     *
+     * \param callback     C++ function which implements the quote.
+     * \param stack_effect Optional static stack effect of the quote, in
+     *                     notation described in stack_effect.
+     * \param unchecked    Optional variant of the function which does not
+     *                     check the values it takes from the stack.
+     */
+    std::shared_ptr<quote> native_quote(
+      quote::callback callback,
+      const char32_t* stack_effect = nullptr,
+      quote::native_function unchecked = nullptr
+    );
 
     /**
      * Constructs word from given string and quote.
@@ -331,6 +574,30 @@ namespace plorth
       return std::shared_ptr<T>(new (*m_memory_manager) T(args...));
     }
 
+    /**
+     * Returns shared instance of empty array.
+     */
+    inline const std::shared_ptr<class array>& empty_array() const
+    {
+      return m_empty_array;
+    }
+
+    /**
+     * Returns shared instance of empty object.
+     */
+    inline const std::shared_ptr<class object>& empty_object() const
+    {
+      return m_empty_object;
+    }
+
+    /**
+     * Returns shared instance of empty string.
+     */
+    inline const std::shared_ptr<class string>& empty_string() const
+    {
+      return m_empty_string;
+    }
+
     /**
      * Returns shared instance of true boolean value.
      */
@@ -372,6 +639,14 @@ namespace plorth
       return m_boolean_prototype;
     }
 
+    /**
+     * Returns prototype for byte sequences.
+     */
+    inline const std::shared_ptr<class object>& bytes_prototype() const
+    {
+      return m_bytes_prototype;
+    }
+
     /**
      * Returns prototype for error values.
      */
@@ -380,6 +655,14 @@ namespace plorth
       return m_error_prototype;
     }
 
+    /**
+     * Returns prototype for files.
+     */
+    inline const std::shared_ptr<class object>& file_prototype() const
+    {
+      return m_file_prototype;
+    }
+
     /**
      * Returns prototype for number values.
      */
@@ -404,6 +687,14 @@ namespace plorth
       return m_quote_prototype;
     }
 
+    /**
+     * Returns prototype for streams.
+     */
+    inline const std::shared_ptr<class object>& stream_prototype() const
+    {
+      return m_stream_prototype;
+    }
+
     /**
      * Returns prototype for string values.
      */
@@ -412,6 +703,14 @@ namespace plorth
       return m_string_prototype;
     }
 
+    /**
+     * Returns prototype for string builders.
+     */
+    inline const std::shared_ptr<class object>& string_builder_prototype() const
+    {
+      return m_string_builder_prototype;
+    }
+
     /**
      * Returns prototype for symbols.
      */
@@ -437,6 +736,39 @@ namespace plorth
      */
     explicit runtime(memory::manager* memory_manager);
 
+  private:
+    /**
+     * Entry in the table of words of the built-in prototypes.
+     */
+    struct method_entry
+    {
+      /** Hash code of the name. */
+      std::size_t hash;
+      /** Name of the words. */
+      std::u32string name;
+      /** Types of values whose prototype contains word with the name. */
+      unsigned int types;
+      /** Words with the name, indexed by value type. */
+      std::shared_ptr<class value> words[
+        static_cast<std::size_t>(value::type::stream) + 1
+      ];
+    };
+
+    /**
+     * Constructs the table of words of the built-in prototypes, once all of
+     * the prototypes have been constructed.
+     */
+    void build_method_table();
+
+    /**
+     * Imports module using runtime's module manager, placing an error into
+     * given context if the import fails.
+     */
+    std::shared_ptr<class object> import_module(
+      const std::shared_ptr<class context>& context,
+      const std::u32string& path
+    );
+
   private:
     /** Memory manager associated with this runtime. */
     memory::manager* m_memory_manager;
@@ -452,33 +784,80 @@ namespace plorth
     std::shared_ptr<class boolean> m_true_value;
     /** Shared instance of false boolean value. */
     std::shared_ptr<class boolean> m_false_value;
+    /** Shared instance of empty array. */
+    std::shared_ptr<class array> m_empty_array;
+    /** Shared instance of empty object. */
+    std::shared_ptr<class object> m_empty_object;
+    /** Shared instance of empty string. */
+    std::shared_ptr<class string> m_empty_string;
     /** Prototype for array values. */
     std::shared_ptr<class object> m_array_prototype;
     /** Prototype for boolean values. */
     std::shared_ptr<class object> m_boolean_prototype;
+    /** Prototype for byte sequences. */
+    std::shared_ptr<class object> m_bytes_prototype;
     /** Prototype for error values. */
     std::shared_ptr<class object> m_error_prototype;
+    /** Prototype for files. */
+    std::shared_ptr<class object> m_file_prototype;
     /** Prototype for number values. */
     std::shared_ptr<class object> m_number_prototype;
     /** Prototype for objects. */
     std::shared_ptr<class object> m_object_prototype;
     /** Prototype for quotes. */
     std::shared_ptr<class object> m_quote_prototype;
+    /** Prototype for streams. */
+    std::shared_ptr<class object> m_stream_prototype;
     /** Prototype for string values. */
     std::shared_ptr<class object> m_string_prototype;
+    /** Prototype for string builders. */
+    std::shared_ptr<class object> m_string_builder_prototype;
     /** Prototype for symbol values. */
     std::shared_ptr<class object> m_symbol_prototype;
     /** Prototype for words. */
     std::shared_ptr<class object> m_word_prototype;
+    /** Words of the built-in prototypes, grouped by name. */
+    std::vector<method_entry> m_methods;
+    /**
+     * Open addressing hash table of indexes in the list of words above,
+     * offset by one so that zero marks an unused slot.
+     */
+    std::vector<std::uint32_t> m_method_index;
     /** List of command line arguments given for the interpreter. */
     std::vector<std::u32string> m_arguments;
+    /** Counters collected while executing scripts. */
+    struct statistics m_statistics;
+#if PLORTH_ENABLE_EVENT_LOOP
+    /** Event loop used for non-blocking I/O, created on demand. */
+    std::shared_ptr<class event_loop> m_event_loop;
+#endif
+#if PLORTH_ENABLE_JIT
+    /** Whether frequently called quotes are translated into machine code. */
+    bool m_jit_enabled;
+#endif
 #if PLORTH_ENABLE_SYMBOL_CACHE
     /** Cache for symbols used by the runtime. */
     symbol_cache m_symbol_cache;
 #endif
 #if PLORTH_ENABLE_INTEGER_CACHE
     /** Cache for commonly used integer numbers. */
-    std::shared_ptr<class number> m_integer_cache[256];
+    std::shared_ptr<class number> m_integer_cache[
+      PLORTH_INTEGER_CACHE_MAX - PLORTH_INTEGER_CACHE_MIN + 1
+    ];
+#endif
+#if PLORTH_ENABLE_CHARACTER_CACHE
+    /**
+     * Cache for single character strings, divided into pages of 256
+     * characters. First page (Latin-1) is populated when the runtime is
+     * constructed, rest of the pages are allocated on demand.
+     */
+    std::unique_ptr<std::shared_ptr<class string>[]> m_character_cache[
+      (PLORTH_CHARACTER_CACHE_MAX >> 8) + 1
+    ];
+# if PLORTH_ENABLE_MUTEXES
+    /** Used to implement thread safety in lazily allocated cache pages. */
+    std::mutex m_character_cache_mutex;
+# endif
 #endif
   };
 }
@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2017-2018, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef PLORTH_STACK_EFFECT_HPP_GUARD
+#define PLORTH_STACK_EFFECT_HPP_GUARD
+
+#include <plorth/value.hpp>
+
+#include <vector>
+
+namespace plorth
+{
+  class quote;
+  class runtime;
+  class dictionary;
+
+  /**
+   * Static description of values which a word takes from the top of the
+   * stack and gives back, written in the same notation as in Forth, such as
+   * `number number -- number` or `a b -- b a`.
+   *
+   * Each value in the notation is either name of a type, multiple type names
+   * separated with `|`, or a label. Labeled inputs match values of any type
+   * and when a label is used in the outputs, the output is the same value as
+   * the labeled input. Inputs and outputs are listed from the deepest value
+   * to the top-most one.
+   */
+  class stack_effect
+  {
+  public:
+    /** Set of value types as a bit mask, indexed by value type. */
+    using type_set = unsigned int;
+
+    /** Type set which matches values of any type. */
+    static const type_set any;
+
+    /**
+     * Single value given by a word.
+     */
+    struct output
+    {
+      /** Possible types of the value. */
+      type_set types;
+      /** Index of the input which is given back, or -1 if none. */
+      int input;
+    };
+
+    /**
+     * Parses stack effect from given notation.
+     *
+     * \param notation Stack effect notation to parse.
+     * \param result   Where the parsed stack effect will be assigned to.
+     * \return         Boolean flag which tells whether the notation was
+     *                 valid or not.
+     */
+    static bool parse(const char32_t* notation, stack_effect& result);
+
+    /**
+     * Returns type set which contains only given type.
+     */
+    static inline type_set type_of(enum value::type type)
+    {
+      return 1u << static_cast<unsigned int>(type);
+    }
+
+    /**
+     * Returns types of the values taken by the word, deepest first.
+     */
+    inline const std::vector<type_set>& inputs() const
+    {
+      return m_inputs;
+    }
+
+    /**
+     * Returns values given by the word, deepest first.
+     */
+    inline const std::vector<output>& outputs() const
+    {
+      return m_outputs;
+    }
+
+    std::u32string to_string() const;
+
+  private:
+    /** Types of the values taken by the word. */
+    std::vector<type_set> m_inputs;
+    /** Values given by the word. */
+    std::vector<output> m_outputs;
+  };
+
+  /**
+   * Result of simulating execution of compiled quote with static stack
+   * effects of the words which it consists of.
+   */
+  struct stack_analysis
+  {
+    /**
+     * Symbol which was proven to resolve into word of a prototype, because
+     * type of the top-most value of the stack is known at that point.
+     */
+    struct site
+    {
+      /** Index of the symbol in the quote. */
+      std::size_t index;
+      /** Type of the top-most value of the stack. */
+      enum value::type type;
+      /** Word which the symbol resolves into. */
+      std::shared_ptr<class quote> quote;
+      /**
+       * Whether all values taken by the word were known to be of the types
+       * listed in its stack effect, not just the top-most one.
+       */
+      bool proven;
+    };
+
+    /** Symbols which resolve into words of prototypes. */
+    std::vector<site> sites;
+    /**
+     * Index of the value which is proven to underflow the stack, or -1 if
+     * no such value was found.
+     */
+    long underflow;
+
+    /**
+     * Simulates execution of sequence of compiled values. Simulation stops
+     * at first value whose effect cannot be determined statically.
+     *
+     * \param runtime    Runtime used for resolving words.
+     * \param values     Values to simulate.
+     * \param stack      Types of the values on the stack when the simulation
+     *                   begins, top-most last.
+     * \param complete   Whether the stack given above is the whole stack,
+     *                   or if there might be values of unknown type below
+     *                   it.
+     * \param dictionary Optional dictionary of the context where the values
+     *                   will be executed in. If omitted, words from the
+     *                   context are not taken into account.
+     */
+    static stack_analysis analyze(
+      const class runtime& runtime,
+      const std::vector<std::shared_ptr<value>>& values,
+      const std::vector<stack_effect::type_set>& stack,
+      bool complete,
+      const class dictionary* dictionary = nullptr
+    );
+  };
+}
+
+#endif /* !PLORTH_STACK_EFFECT_HPP_GUARD */
@@ -50,21 +50,54 @@ namespace plorth
     /**
      * Returns the number of elements in the array.
      */
-    virtual size_type size() const = 0;
+    inline size_type size() const
+    {
+      return m_size;
+    }
 
     /**
-     * Returns element of the array from given index.
+     * Returns element of the array from given index. Elements of arrays
+     * stored in contiguous memory are read directly, without a virtual call.
      */
-    virtual const_reference at(size_type offset) const = 0;
+    inline const_reference at(size_type offset) const
+    {
+      return m_data ? m_data[offset] : element(offset);
+    }
 
-    inline enum type type() const
+    /**
+     * Returns pointer to the elements of the array if they are stored in
+     * contiguous memory, or null pointer if they are not.
+     */
+    inline const_pointer data() const
     {
-      return type::array;
+      return m_data;
     }
 
     bool equals(const std::shared_ptr<value>& that) const;
     std::u32string to_string() const;
     std::u32string to_source() const;
+
+  protected:
+    /**
+     * Constructs new array.
+     *
+     * \param size Number of elements in the array.
+     * \param data Pointer to the elements of the array, if they are stored in
+     *             contiguous memory.
+     */
+    explicit array(size_type size, const_pointer data = nullptr);
+
+    /**
+     * Returns element from given index of array which is not stored in
+     * contiguous memory.
+     */
+    virtual const_reference element(size_type offset) const;
+
+  private:
+    /** Number of elements in the array. */
+    const size_type m_size;
+    /** Elements of the array, if stored in contiguous memory. */
+    const const_pointer m_data;
   };
 
   /**
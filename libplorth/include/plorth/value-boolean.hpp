@@ -40,11 +40,6 @@ namespace plorth
       return m_value;
     }
 
-    inline enum type type() const
-    {
-      return type::boolean;
-    }
-
     bool equals(const std::shared_ptr<class value>& that) const;
     std::u32string to_string() const;
     std::u32string to_source() const;
@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2017-2018, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef PLORTH_VALUE_BYTES_HPP_GUARD
+#define PLORTH_VALUE_BYTES_HPP_GUARD
+
+#include <plorth/value.hpp>
+
+namespace plorth
+{
+  /**
+   * Immutable sequence of bytes. Unlike strings, contents of byte sequences
+   * are not decoded in any way, so they can hold binary data or text in any
+   * encoding. Bytes are stored in contiguous memory, which is either
+   * allocated from the memory pool or mapped from a file, and slices share
+   * the memory of the sequence they were taken from.
+   */
+  class bytes : public value
+  {
+  public:
+    using size_type = std::size_t;
+    using value_type = unsigned char;
+    using const_pointer = const value_type*;
+
+    /**
+     * Layout of integer number stored in a byte sequence, used by the words
+     * which pack integers into bytes and unpack them from bytes.
+     */
+    struct integer_layout
+    {
+      /** Number of bytes used by the integer. */
+      size_type size;
+      /** Whether the integer is signed or not. */
+      bool is_signed;
+      /** Whether the integer is stored in little endian byte order. */
+      bool little_endian;
+
+      /**
+       * Parses integer layout from format such as "u8", "i16le" or "u64be".
+       *
+       * \param input  Format to parse.
+       * \param output Where the parsed layout will be placed into.
+       * \return       Boolean flag indicating whether the format is valid.
+       */
+      static bool parse(const std::u32string& input, integer_layout& output);
+    };
+
+    /**
+     * Returns number of bytes in the sequence.
+     */
+    inline size_type length() const
+    {
+      return m_length;
+    }
+
+    /**
+     * Returns pointer to the contents of the sequence.
+     */
+    inline const_pointer data() const
+    {
+      return m_data;
+    }
+
+    /**
+     * Returns byte from specified offset of the sequence.
+     */
+    inline value_type at(size_type offset) const
+    {
+      return m_data[offset];
+    }
+
+    /**
+     * Returns portion of byte sequence. Short portions are copied so that
+     * they do not keep possibly large original sequence alive, longer ones
+     * share the memory of the original sequence.
+     *
+     * \param runtime Runtime used for constructing the byte sequence.
+     * \param input   Byte sequence to take the portion from.
+     * \param offset  Offset of the first byte in the portion.
+     * \param length  Number of bytes in the portion.
+     * \return        Reference to the portion.
+     */
+    static std::shared_ptr<bytes> slice(class runtime& runtime,
+                                        const std::shared_ptr<bytes>& input,
+                                        size_type offset,
+                                        size_type length);
+
+    /**
+     * Decodes contents of byte sequence as UTF-8 encoded text. Sequences
+     * consisting of ASCII characters only are not copied; the resulting
+     * string reads it's characters directly from the byte sequence.
+     *
+     * \param runtime Runtime used for constructing the string value.
+     * \param input   Byte sequence to decode.
+     * \return        Reference to the decoded string, or null pointer if the
+     *                byte sequence is not valid UTF-8.
+     */
+    static std::shared_ptr<class string> decode(
+      class runtime& runtime,
+      const std::shared_ptr<bytes>& input
+    );
+
+    bool equals(const std::shared_ptr<class value>& that) const;
+    std::u32string to_string() const;
+    std::u32string to_source() const;
+
+  protected:
+    /**
+     * Constructs new byte sequence.
+     *
+     * \param data   Pointer to the contents of the sequence.
+     * \param length Number of bytes in the sequence.
+     */
+    explicit bytes(const_pointer data, size_type length);
+
+  private:
+    /** Contents of the sequence. */
+    const const_pointer m_data;
+    /** Number of bytes in the sequence. */
+    const size_type m_length;
+  };
+}
+
+#endif /* !PLORTH_VALUE_BYTES_HPP_GUARD */
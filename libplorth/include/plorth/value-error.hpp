@@ -68,7 +68,37 @@ namespace plorth
       const struct position* position = nullptr
     );
 
-    ~error();
+    /**
+     * Constructs new error instance from string literal. The message is not
+     * copied until it's requested, so it must remain valid for the lifetime
+     * of the error.
+     *
+     * \param code     Error code
+     * \param message  Textual description of the error
+     * \param position Optional position in source code where the error
+     *                 occurred.
+     */
+    explicit error(
+      enum code code,
+      const char32_t* message,
+      const struct position* position = nullptr
+    );
+
+    /**
+     * Constructs new type error which tells that value of given type was
+     * encountered when value of another type was expected. The message is
+     * formatted only when it's requested.
+     *
+     * \param expected Type of value which was expected.
+     * \param actual   Type of value which was encountered instead.
+     * \param position Optional position in source code where the error
+     *                 occurred.
+     */
+    explicit error(
+      enum value::type expected,
+      enum value::type actual,
+      const struct position* position = nullptr
+    );
 
     inline enum code code() const
     {
@@ -85,10 +115,11 @@ namespace plorth
      */
     static std::u32string code_description(enum code code);
 
-    inline const std::u32string& message() const
-    {
-      return m_message;
-    }
+    /**
+     * Returns textual description of the error. The description is formatted
+     * when it's requested for the first time.
+     */
+    const std::u32string& message() const;
 
     /**
      * Returns position in the source code where the error occurred or null
@@ -96,12 +127,7 @@ namespace plorth
      */
     inline const struct position* position() const
     {
-      return m_position;
-    }
-
-    inline enum type type() const
-    {
-      return type::error;
+      return m_has_position ? &m_position : nullptr;
     }
 
     bool equals(const std::shared_ptr<value>& that) const;
@@ -109,12 +135,53 @@ namespace plorth
     std::u32string to_source() const;
 
   private:
+    friend class context;
+
+    /**
+     * Enumeration of different sources where the message of the error is
+     * formatted from.
+     */
+    enum class payload
+    {
+      /** Message has been given or already formatted. */
+      message,
+      /** Message is a string literal. */
+      literal,
+      /** Message is formatted from expected and actual value type. */
+      type_mismatch
+    };
+
+    /**
+     * Replaces position of an error which is not referenced anywhere else,
+     * so that the error can be reused instead of allocating a new one.
+     */
+    void reset(const struct position* position);
+
+    /**
+     * Replaces types and position of a type mismatch error which is not
+     * referenced anywhere else, so that the error can be reused instead of
+     * allocating a new one.
+     */
+    void reset(enum value::type expected,
+               enum value::type actual,
+               const struct position* position);
+
     /** Error code. */
     const enum code m_code;
-    /** Textual description of the error. */
-    const std::u32string m_message;
+    /** Where the message of the error is formatted from. */
+    mutable enum payload m_payload;
+    /** Textual description of the error, once it has been formatted. */
+    mutable std::u32string m_message;
+    /** String literal used as the message. */
+    const char32_t* m_literal;
+    /** Expected value type of type mismatch error. */
+    enum value::type m_expected_type;
+    /** Actual value type of type mismatch error. */
+    enum value::type m_actual_type;
+    /** Whether the error has position in source code. */
+    bool m_has_position;
     /** Optional position in source code. */
-    struct position* m_position;
+    struct position m_position;
   };
 
   std::ostream& operator<<(std::ostream&, enum error::code);
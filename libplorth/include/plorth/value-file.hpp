@@ -0,0 +1,366 @@
+/*
+ * Copyright (c) 2017-2018, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef PLORTH_VALUE_FILE_HPP_GUARD
+#define PLORTH_VALUE_FILE_HPP_GUARD
+
+#include <plorth/io-input.hpp>
+#include <plorth/value-bytes.hpp>
+#include <plorth/value-string.hpp>
+
+namespace plorth
+{
+  /**
+   * Value which represents file opened either for reading or for writing.
+   * Reads and writes go through an internal buffer, so that the file
+   * descriptor is accessed only once per buffer instead of once per
+   * character. Contents of the file are expected to be UTF-8 encoded.
+   */
+  class file : public value
+  {
+  public:
+    using size_type = string::size_type;
+
+    /**
+     * Enumeration of different modes the file can be opened in.
+     */
+    enum class mode
+    {
+      read,
+      write,
+      read_write
+    };
+
+    /** Size of the internal buffer of the file, in bytes. */
+    static const std::size_t buffer_size = 65536;
+
+    /**
+     * Constructs new file value which takes ownership of given file
+     * descriptor.
+     *
+     * \param fd           File descriptor of the opened file.
+     * \param mode         Mode which the file has been opened in.
+     * \param path         Path of the file.
+     * \param non_blocking Whether the file descriptor is in non-blocking
+     *                     mode, in which case output which cannot be
+     *                     written immediately is kept in a pending buffer.
+     */
+    explicit file(int fd,
+                  enum mode mode,
+                  const std::u32string& path,
+                  bool non_blocking = false);
+
+    ~file();
+
+    /**
+     * Opens file from given path. If the file cannot be opened, I/O error is
+     * set to the context and null pointer is returned.
+     *
+     * \param ctx  Execution context.
+     * \param path Path of the file to open.
+     * \param mode Whether the file is opened for reading or for writing.
+     *             Files opened for writing are created if they do not exist
+     *             and truncated if they do.
+     * \return     Reference to the opened file, or null pointer if the file
+     *             could not be opened.
+     */
+    static std::shared_ptr<file> open(const std::shared_ptr<context>& ctx,
+                                      const std::u32string& path,
+                                      enum mode mode);
+
+    /**
+     * Reads entire contents of file from given path into a byte sequence.
+     * Regular files are mapped into memory and the byte sequence reads it's
+     * contents directly from the mapping. Files which cannot be mapped, such
+     * as pipes, are read in chunks instead. If the file cannot be read, I/O
+     * error is set to the context and null pointer is returned.
+     *
+     * \param ctx  Execution context.
+     * \param path Path of the file to read.
+     * \return     Contents of the file, or null pointer if the file could not
+     *             be read.
+     */
+    static std::shared_ptr<bytes> slurp_bytes(
+      const std::shared_ptr<context>& ctx,
+      const std::u32string& path
+    );
+
+    /**
+     * Reads entire contents of file from given path and decodes it as UTF-8
+     * encoded text. If the contents consist of ASCII characters only, the
+     * resulting string reads it's characters directly from the memory
+     * mapping without copying them. If the file cannot be read or decoded,
+     * I/O error is set to the context and null pointer is returned.
+     *
+     * \param ctx  Execution context.
+     * \param path Path of the file to read.
+     * \return     Contents of the file, or null pointer if the file could not
+     *             be read.
+     */
+    static std::shared_ptr<string> slurp(const std::shared_ptr<context>& ctx,
+                                         const std::u32string& path);
+
+    /**
+     * Creates a pipe in non-blocking mode.
+     *
+     * \param ctx       Execution context.
+     * \param read_end  Where the end of the pipe which is read from will be
+     *                  placed into.
+     * \param write_end Where the end of the pipe which is written into will
+     *                  be placed into.
+     * \return          Boolean flag indicating whether the pipe was created.
+     *                  If not, I/O error is set to the context.
+     */
+    static bool pipe(const std::shared_ptr<context>& ctx,
+                     std::shared_ptr<file>& read_end,
+                     std::shared_ptr<file>& write_end);
+
+    /**
+     * Connects to Unix domain socket in given path. The connection is in
+     * non-blocking mode. If the connection cannot be established, I/O error
+     * is set to the context and null pointer is returned.
+     */
+    static std::shared_ptr<file> connect(const std::shared_ptr<context>& ctx,
+                                         const std::u32string& path);
+
+    /**
+     * Creates Unix domain socket which listens for connections in given
+     * path. The socket is in non-blocking mode. If the socket cannot be
+     * created, I/O error is set to the context and null pointer is returned.
+     */
+    static std::shared_ptr<file> listen(const std::shared_ptr<context>& ctx,
+                                        const std::u32string& path);
+
+    /**
+     * Returns file descriptor of the file, or -1 if the file has been closed.
+     */
+    inline int fd() const
+    {
+      return m_fd;
+    }
+
+    /**
+     * Returns the mode which the file has been opened in.
+     */
+    inline enum mode mode() const
+    {
+      return m_mode;
+    }
+
+    /**
+     * Returns path of the file.
+     */
+    inline const std::u32string& path() const
+    {
+      return m_path;
+    }
+
+    /**
+     * Returns boolean flag indicating whether the file is still open.
+     */
+    inline bool is_open() const
+    {
+      return m_fd >= 0;
+    }
+
+    /**
+     * Returns boolean flag indicating whether the file can be read from.
+     */
+    inline bool is_readable() const
+    {
+      return is_open() && m_mode != mode::write;
+    }
+
+    /**
+     * Returns boolean flag indicating whether the file can be written into.
+     */
+    inline bool is_writable() const
+    {
+      return is_open() && m_mode != mode::read;
+    }
+
+    /**
+     * Returns boolean flag indicating whether the file is in non-blocking
+     * mode.
+     */
+    inline bool is_non_blocking() const
+    {
+      return m_non_blocking;
+    }
+
+    /**
+     * Returns boolean flag indicating whether the file is in non-blocking
+     * mode and has output which has not yet been written into it.
+     */
+    inline bool has_pending_output() const
+    {
+      return !m_pending.empty();
+    }
+
+    /**
+     * Reads single line from the file. The line separator, either "\n" or
+     * "\r\n", is not included in the output.
+     *
+     * \param output Where the read Unicode characters will be placed into.
+     * \return       Result of the read operation. End of file is returned
+     *               only when there was nothing left to be read. If the file
+     *               is in non-blocking mode and the rest of the line is not
+     *               yet available, the part of the line read so far is kept
+     *               in the file for the next call and
+     *               io::input::result::would_block is returned.
+     */
+    io::input::result read_line(std::u32string& output);
+
+    /**
+     * Reads given number of Unicode characters from the file.
+     *
+     * \param size   Number of Unicode characters to be read.
+     * \param output Where the read Unicode characters will be placed into.
+     * \param read   Where the amount of read Unicode characters will be
+     *               placed into.
+     * \return       Result of the read operation. End of file is returned
+     *               when there was less than given amount of characters left
+     *               to be read. Files in non-blocking mode return
+     *               io::input::result::would_block when the rest of the
+     *               characters are not yet available.
+     */
+    io::input::result read_chunk(size_type size,
+                                 std::u32string& output,
+                                 size_type& read);
+
+    /**
+     * Reads whatever input is currently available from the file, without
+     * blocking if the file is in non-blocking mode.
+     *
+     * \param output Where the read bytes will be placed into. Left empty if
+     *               the file is in non-blocking mode and there is no input
+     *               available.
+     * \return       Result of the read operation.
+     */
+    io::input::result read_bytes(std::string& output);
+
+    /**
+     * Waits until the file has input available to be read. Does nothing
+     * unless the file is in non-blocking mode.
+     *
+     * \return Boolean flag indicating whether the wait was successful.
+     */
+    bool wait_readable();
+
+    /**
+     * Accepts pending connection from listening socket.
+     *
+     * \param ctx  Execution context.
+     * \param slot Where the accepted connection will be placed into. Left
+     *             empty if there are no pending connections.
+     * \return     Boolean flag indicating whether the operation was
+     *             successful. If not, I/O error is set to the context.
+     */
+    bool accept(const std::shared_ptr<context>& ctx,
+                std::shared_ptr<file>& slot);
+
+    /**
+     * Encodes contents of given string as UTF-8 and writes it into the file.
+     *
+     * \return Boolean flag indicating whether the write was successful.
+     */
+    bool write(const std::shared_ptr<string>& str);
+
+    /**
+     * Writes contents of given byte sequence into the file as they are.
+     *
+     * \return Boolean flag indicating whether the write was successful.
+     */
+    bool write(const std::shared_ptr<bytes>& b);
+
+    /**
+     * Writes contents of the internal buffer into the file. Files in
+     * non-blocking mode write as much of their pending output as they can
+     * without blocking.
+     *
+     * \return Boolean flag indicating whether the write was successful.
+     */
+    bool flush();
+
+    /**
+     * Flushes the internal buffer and closes the file. Does nothing if the
+     * file has already been closed.
+     *
+     * \return Boolean flag indicating whether the file was successfully
+     *         flushed and closed.
+     */
+    bool close();
+
+    bool equals(const std::shared_ptr<value>& that) const;
+    std::u32string to_string() const;
+    std::u32string to_source() const;
+
+  private:
+    /**
+     * Decodes single Unicode code point from the file.
+     */
+    io::input::result get(char32_t& c);
+
+    /**
+     * Reads more input into the internal buffer.
+     *
+     * \return Number of bytes read, zero on end of file and negative value on
+     *         error.
+     */
+    long fill();
+
+    /**
+     * Appends given bytes into the pending output of non-blocking file and
+     * attempts to write them.
+     */
+    bool write_pending(const char* data, std::size_t length);
+
+  private:
+    /** File descriptor of the file, or -1 if the file has been closed. */
+    int m_fd;
+    /** Mode which the file has been opened in. */
+    const enum mode m_mode;
+    /** Path of the file. */
+    const std::u32string m_path;
+    /** Internal buffer used for reading or writing. */
+    unsigned char* m_buffer;
+    /** Offset of the next unread byte in the buffer. */
+    std::size_t m_offset;
+    /** Number of bytes stored in the buffer. */
+    std::size_t m_length;
+    /** Whether the file descriptor is in non-blocking mode. */
+    const bool m_non_blocking;
+    /** Whether the file descriptor refers to a socket. */
+    bool m_socket;
+    /** Output of non-blocking file which has not yet been written. */
+    std::string m_pending;
+    /** Incomplete line read from non-blocking file. */
+    std::u32string m_partial_line;
+    /** Incomplete UTF-8 sequence read from non-blocking file. */
+    std::string m_partial_sequence;
+  };
+}
+
+#endif /* !PLORTH_VALUE_FILE_HPP_GUARD */
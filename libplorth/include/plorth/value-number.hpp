@@ -55,9 +55,13 @@ namespace plorth
     };
 
     /**
-     * Returns type of the number.
+     * Returns type of the number. The type is stored in the number itself, so
+     * this does not require a virtual call.
      */
-    virtual enum number_type number_type() const = 0;
+    inline enum number_type number_type() const
+    {
+      return m_number_type;
+    }
 
     /**
      * Tests whether this number is of specific type.
@@ -77,15 +81,28 @@ namespace plorth
      */
     virtual real_type as_real() const = 0;
 
-    inline enum type type() const
-    {
-      return type::number;
-    }
-
     bool equals(const std::shared_ptr<class value>& that) const;
     std::u32string to_string() const;
     std::u32string to_source() const;
+
+  protected:
+    /**
+     * Constructs new number.
+     *
+     * \param number_type Type of the number.
+     */
+    explicit number(enum number_type number_type);
+
+  private:
+    /** Type of the number. */
+    const enum number_type m_number_type;
   };
+
+  /**
+   * Tests whether given string is a number literal, which the interpreter
+   * converts into number when no word of the same name exists.
+   */
+  bool is_number(const std::u32string& input);
 }
 
 #endif /* !PLORTH_VALUE_NUMBER_HPP_GUARD */
@@ -26,6 +26,7 @@
 #ifndef PLORTH_VALUE_OBJECT_HPP_GUARD
 #define PLORTH_VALUE_OBJECT_HPP_GUARD
 
+#include <functional>
 #include <utility>
 #include <vector>
 
@@ -46,6 +47,44 @@ namespace plorth
     using key_type = std::u32string;
     using mapped_type = std::shared_ptr<value>;
     using value_type = std::pair<key_type, mapped_type>;
+    /**
+     * Callback used for visiting properties of an object. Iteration is
+     * stopped when the callback returns false.
+     */
+    using visitor = std::function<bool(const key_type&, const mapped_type&)>;
+
+    /**
+     * Enumeration of different ways how properties of an object can be
+     * stored.
+     */
+    enum class layout
+    {
+      /** Properties are stored in a single hash table. */
+      flat = 0,
+      /** Object consists of single modification over another object. */
+      layered = 1,
+      /** Properties are stored in a hash array mapped trie. */
+      trie = 2
+    };
+
+    /**
+     * Returns the storage layout of the object. The layout is stored in the
+     * object itself, so this does not require a virtual call.
+     */
+    inline enum layout layout() const
+    {
+      return m_layout;
+    }
+
+    /**
+     * Returns the number of layers which have to be traversed before reaching
+     * the object which actually stores the properties. This is zero for
+     * objects which are not layered.
+     */
+    inline size_type depth() const
+    {
+      return m_depth;
+    }
 
     /**
      * Tests whether the object has property with given name, including
@@ -108,32 +147,57 @@ namespace plorth
      */
     virtual size_type size() const = 0;
 
+    /**
+     * Invokes given callback for each property which the object has, without
+     * constructing a list of the properties first. This does not include
+     * inherited properties.
+     *
+     * \param callback Callback to invoke for each property.
+     * \return         False if the iteration was stopped by the callback,
+     *                 true otherwise.
+     */
+    virtual bool for_each(const visitor& callback) const = 0;
+
     /**
      * Returns names of the properties which the object has. This does not
      * include inherited properties.
      */
-    virtual std::vector<key_type> keys() const = 0;
+    std::vector<key_type> keys() const;
 
     /**
      * Returns values of the properties which the object has. This does not
      * include inherited properties.
      */
-    virtual std::vector<mapped_type> values() const = 0;
+    std::vector<mapped_type> values() const;
 
     /**
      * Returns each property which the object has. This does not include
      * inherited properties.
      */
-    virtual std::vector<value_type> entries() const = 0;
-
-    inline enum type type() const
-    {
-      return type::object;
-    }
+    std::vector<value_type> entries() const;
 
     bool equals(const std::shared_ptr<value>& that) const;
     std::u32string to_string() const;
     std::u32string to_source() const;
+
+  protected:
+    /**
+     * Constructs new object.
+     *
+     * \param layout Storage layout of the object.
+     * \param depth  Number of layers between the object and it's actual
+     *               storage.
+     */
+    explicit object(enum layout layout = layout::flat, size_type depth = 0)
+      : value(type::object)
+      , m_layout(layout)
+      , m_depth(depth) {}
+
+  private:
+    /** Storage layout of the object. */
+    const enum layout m_layout;
+    /** Number of layers between this object and it's actual storage. */
+    const size_type m_depth;
   };
 }
 
@@ -26,7 +26,7 @@
 #ifndef PLORTH_VALUE_QUOTE_HPP_GUARD
 #define PLORTH_VALUE_QUOTE_HPP_GUARD
 
-#include <plorth/value.hpp>
+#include <plorth/stack-effect.hpp>
 
 #include <functional>
 
@@ -42,6 +42,19 @@ namespace plorth
     /** Signature of C++ function that can be used as quote. */
     using callback = std::function<void(const std::shared_ptr<context>&)>;
 
+    /** Signature of plain C++ function that can be used as quote. */
+    using native_function = void(*)(const std::shared_ptr<context>&);
+
+    /**
+     * Signature of native function which has been generated from the values
+     * of compiled quote, and which is called with those values instead of
+     * interpreting them.
+     */
+    using native_code = bool(*)(
+      const std::shared_ptr<context>&,
+      const std::vector<std::shared_ptr<value>>&
+    );
+
     /**
      * Enumeration for different supported quote types.
      */
@@ -61,9 +74,13 @@ namespace plorth
     virtual bool call(const std::shared_ptr<context>& ctx) const = 0;
 
     /**
-     * Returns type of the quote.
+     * Returns type of the quote. The type is stored in the quote itself, so
+     * this does not require a virtual call.
      */
-    virtual enum quote_type quote_type() const = 0;
+    inline enum quote_type quote_type() const
+    {
+      return m_quote_type;
+    }
 
     /**
      * Tests whether the quote is of given type.
@@ -73,12 +90,80 @@ namespace plorth
       return quote_type() == t;
     }
 
-    inline enum type type() const
+    /**
+     * Returns static stack effect of the quote, or null pointer if the effect
+     * cannot be determined without executing the quote.
+     */
+    virtual const class stack_effect* stack_effect() const
     {
-      return type::quote;
+      return nullptr;
+    }
+
+    /**
+     * Returns the C++ function which implements native quote, or null pointer
+     * if the quote is compiled, or implemented with something else than a
+     * plain function.
+     */
+    virtual native_function function() const
+    {
+      return nullptr;
+    }
+
+    /**
+     * Returns variant of the native function which does not check the values
+     * it takes from the stack, or null pointer if the quote has no such
+     * variant. Callers must verify that the stack matches the stack effect
+     * of the quote before calling it.
+     */
+    virtual native_function unchecked_function() const
+    {
+      return nullptr;
+    }
+
+    /**
+     * Returns the values which compiled quote consists of, or null pointer if
+     * the quote is native.
+     */
+    virtual const std::vector<std::shared_ptr<value>>* values() const
+    {
+      return nullptr;
+    }
+
+    /**
+     * Binds compiled quote, and compiled quotes nested inside it, into the
+     * module it was defined in. While values of the quote are being executed,
+     * symbols are resolved from words of the module before dictionaries of
+     * the context. Native quotes are not affected.
+     *
+     * \param module Module which the quote belongs to.
+     */
+    virtual void bind_module(const std::shared_ptr<class object>&) {}
+
+    /**
+     * Tests whether the quote has been bound into a module with
+     * bind_module(), in which case it's values cannot be executed outside of
+     * the module without changing what their symbols refer to.
+     */
+    virtual bool bound() const
+    {
+      return false;
     }
 
     std::u32string to_source() const;
+
+  protected:
+    /**
+     * Constructs new quote.
+     *
+     * \param quote_type Type of the quote.
+     */
+    explicit quote(enum quote_type quote_type)
+      : value(type::quote)
+      , m_quote_type(quote_type) {}
+
+  private:
+    /** Type of the quote. */
+    const enum quote_type m_quote_type;
   };
 }
 
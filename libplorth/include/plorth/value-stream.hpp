@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2017-2018, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef PLORTH_VALUE_STREAM_HPP_GUARD
+#define PLORTH_VALUE_STREAM_HPP_GUARD
+
+#include <plorth/io-input.hpp>
+#include <plorth/value.hpp>
+
+namespace plorth
+{
+  /**
+   * Lazy sequence of values, which are produced one at a time as the stream
+   * is being consumed. Unlike arrays, streams do not hold their values in
+   * memory, so they can be used for processing input which does not fit in
+   * memory. Streams can be consumed only once.
+   */
+  class stream : public value
+  {
+  public:
+    /**
+     * Represents results of retrieving the next value from a stream.
+     */
+    enum class result
+    {
+      /** Next value was retrieved from the stream. */
+      ok,
+      /** There are no more values in the stream. */
+      end,
+      /** An error was encountered and set to the execution context. */
+      error
+    };
+
+    /**
+     * Retrieves next value from the stream.
+     *
+     * \param ctx  Execution context used for running quotes and for
+     *             reporting errors.
+     * \param slot Where the retrieved value will be placed into.
+     * \return     Result of the operation.
+     */
+    virtual result next(const std::shared_ptr<context>& ctx,
+                        std::shared_ptr<value>& slot) = 0;
+
+    /**
+     * Constructs stream which produces lines read from given input, without
+     * the line separators. Same buffer is used for reading each line.
+     */
+    static std::shared_ptr<stream> lines(
+      class runtime& runtime,
+      const std::shared_ptr<io::input>& input
+    );
+
+    /**
+     * Constructs stream which produces lines read from given file, without
+     * the line separators. Same buffer is used for reading each line.
+     */
+    static std::shared_ptr<stream> lines(
+      class runtime& runtime,
+      const std::shared_ptr<class file>& input
+    );
+
+    /**
+     * Constructs stream which applies given quote to each value of another
+     * stream as they are retrieved.
+     */
+    static std::shared_ptr<stream> map(
+      class runtime& runtime,
+      const std::shared_ptr<stream>& source,
+      const std::shared_ptr<class quote>& quote
+    );
+
+    /**
+     * Constructs stream which skips values of another stream that do not
+     * satisfy given testing quote.
+     */
+    static std::shared_ptr<stream> filter(
+      class runtime& runtime,
+      const std::shared_ptr<stream>& source,
+      const std::shared_ptr<class quote>& quote
+    );
+
+    bool equals(const std::shared_ptr<class value>& that) const;
+    std::u32string to_string() const;
+    std::u32string to_source() const;
+
+  protected:
+    explicit stream()
+      : value(type::stream) {}
+  };
+}
+
+#endif /* !PLORTH_VALUE_STREAM_HPP_GUARD */
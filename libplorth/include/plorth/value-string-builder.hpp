@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2017-2018, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef PLORTH_VALUE_STRING_BUILDER_HPP_GUARD
+#define PLORTH_VALUE_STRING_BUILDER_HPP_GUARD
+
+#include <plorth/value-number.hpp>
+#include <plorth/value-string.hpp>
+
+namespace plorth
+{
+  /**
+   * Mutable value which is used for constructing strings incrementally.
+   * Characters are appended into a single growing buffer, which is handed
+   * over to a string value when the builder is converted into string.
+   */
+  class string_builder : public value
+  {
+  public:
+    using size_type = string::size_type;
+    using value_type = string::value_type;
+
+    /**
+     * Constructs new empty string builder.
+     */
+    explicit string_builder();
+
+    ~string_builder();
+
+    /**
+     * Returns number of characters in the builder.
+     */
+    inline size_type length() const
+    {
+      return m_length;
+    }
+
+    /**
+     * Appends single Unicode code point into the builder.
+     */
+    void append(value_type c);
+
+    /**
+     * Appends given array of Unicode code points into the builder.
+     */
+    void append(const value_type* chars, size_type length);
+
+    /**
+     * Appends contents of given string into the builder.
+     */
+    void append(const std::shared_ptr<string>& str);
+
+    /**
+     * Appends textual representation of given number into the builder.
+     */
+    void append(const std::shared_ptr<number>& num);
+
+    /**
+     * Converts contents of the builder into string value. Buffer of the
+     * builder is given to the string without copying it. If more characters
+     * are appended into the builder afterwards, contents of the string are
+     * copied into a new buffer first.
+     *
+     * \param runtime Runtime used for constructing the string value.
+     * \return        Reference to the string value.
+     */
+    std::shared_ptr<string> freeze(class runtime& runtime);
+
+    bool equals(const std::shared_ptr<value>& that) const;
+    std::u32string to_string() const;
+    std::u32string to_source() const;
+
+  private:
+    /**
+     * Ensures that the buffer has room for given amount of additional
+     * characters.
+     */
+    void reserve(size_type additional);
+
+  private:
+    /** Buffer where the characters are stored. */
+    value_type* m_chars;
+    /** Number of characters in the builder. */
+    size_type m_length;
+    /** Number of characters the buffer has room for. */
+    size_type m_capacity;
+    /** String which shares it's contents with the builder, if any. */
+    std::shared_ptr<string> m_frozen;
+  };
+}
+
+#endif /* !PLORTH_VALUE_STRING_BUILDER_HPP_GUARD */
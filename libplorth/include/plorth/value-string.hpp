@@ -52,21 +52,66 @@ namespace plorth
     /**
      * Returns length of the string.
      */
-    virtual size_type length() const = 0;
+    inline size_type length() const
+    {
+      return m_length;
+    }
 
     /**
-     * Returns Unicode code point from specified offset of the string.
+     * Returns Unicode code point from specified offset of the string. Code
+     * points of strings stored in contiguous memory are read directly,
+     * without a virtual call.
      */
-    virtual value_type at(size_type offset) const = 0;
+    inline value_type at(size_type offset) const
+    {
+      return m_data ? m_data[offset] : element(offset);
+    }
 
-    enum type type() const
+    /**
+     * Returns pointer to the Unicode code points of the string if they are
+     * stored in contiguous memory, or null pointer if they are not.
+     */
+    inline const_pointer data() const
     {
-      return type::string;
+      return m_data;
     }
 
+    /**
+     * Copies range of Unicode code points from the string into given buffer.
+     * This allows strings which are not stored in contiguous memory to be
+     * processed in chunks, without constructing the entire string.
+     *
+     * \param offset Offset of the first code point to copy.
+     * \param count  Number of code points to copy.
+     * \param output Buffer where the code points will be copied into.
+     */
+    virtual void copy(size_type offset, size_type count, pointer output) const;
+
     bool equals(const std::shared_ptr<class value>& that) const;
     std::u32string to_string() const;
     std::u32string to_source() const;
+
+  protected:
+    /**
+     * Constructs new string.
+     *
+     * \param length Length of the string.
+     * \param data   Pointer to the Unicode code points of the string, if they
+     *               are stored in contiguous memory.
+     */
+    explicit string(size_type length, const_pointer data = nullptr);
+
+    /**
+     * Returns Unicode code point from specified offset of string which is not
+     * stored in contiguous memory.
+     */
+    virtual value_type element(size_type offset) const;
+
+  private:
+    /** Length of the string. */
+    const size_type m_length;
+    /** Unicode code points of the string, if stored in contiguous memory. */
+    const const_pointer m_data;
   };
 
   /**
@@ -34,6 +34,9 @@
 
 namespace plorth
 {
+  class object;
+  class quote;
+
   /**
    * Symbol represents identifier in Plorth source code.
    */
@@ -78,10 +81,30 @@ namespace plorth
      */
     std::size_t hash() const;
 
-    inline enum type type() const
-    {
-      return type::symbol;
-    }
+    /**
+     * Looks up word from the inline cache of the symbol, which is used when
+     * the symbol is resolved from a namespace.
+     *
+     * \param version Version of the namespaces where the symbol is being
+     *                resolved from.
+     * \param slot    Where the cached word will be placed into. Null if the
+     *                symbol was cached as unresolvable.
+     * \param module  Where the module which the word belongs to will be
+     *                placed into.
+     * \return        Boolean flag which tells whether the cache contained an
+     *                entry for given namespace version or not.
+     */
+    bool cached_word(unsigned long version,
+                     std::shared_ptr<quote>& slot,
+                     std::shared_ptr<object>& module) const;
+
+    /**
+     * Stores word resolved from namespaces of given version, and the module
+     * which it belongs to, into the inline cache of the symbol.
+     */
+    void cache_word(unsigned long version,
+                    const std::shared_ptr<quote>& quote,
+                    const std::shared_ptr<object>& module) const;
 
     bool equals(const std::shared_ptr<value>& that) const;
     std::u32string to_string() const;
@@ -94,6 +117,12 @@ namespace plorth
     struct position* m_position;
     /** Cached hash code of the symbol. */
     std::size_t m_hash;
+    /** Namespace version of the cached word, or 0 if none. */
+    mutable unsigned long m_cache_version;
+    /** Word which the symbol was last resolved into from namespaces. */
+    mutable std::shared_ptr<quote> m_cache_word;
+    /** Module of the cached word. */
+    mutable std::shared_ptr<object> m_cache_module;
 #if PLORTH_ENABLE_MUTEXES
     /** Used to implement thread safety in hash calculation. */
     std::mutex m_mutex;
@@ -62,11 +62,6 @@ namespace plorth
       return m_quote;
     }
 
-    inline enum type type() const
-    {
-      return type::word;
-    }
-
     bool equals(const std::shared_ptr<value>& that) const;
     std::u32string to_string() const;
     std::u32string to_source() const;
@@ -64,13 +64,25 @@ namespace plorth
       /** Words. */
       word = 8,
       /** Errors. */
-      error = 9
+      error = 9,
+      /** String builders. */
+      string_builder = 10,
+      /** Files. */
+      file = 11,
+      /** Byte sequences. */
+      bytes = 12,
+      /** Streams. */
+      stream = 13
     };
 
     /**
-     * Returns type of the value.
+     * Returns type of the value. The type is stored in the value itself, so
+     * this does not require a virtual call.
      */
-    virtual enum type type() const = 0;
+    inline enum type type() const
+    {
+      return m_type;
+    }
 
     /**
      * Returns textual description of type of the value.
@@ -153,6 +165,18 @@ namespace plorth
      * value would look like in source code.
      */
     virtual std::u32string to_source() const = 0;
+
+  protected:
+    /**
+     * Constructs new value.
+     *
+     * \param type Type of the value.
+     */
+    explicit value(enum type type);
+
+  private:
+    /** Type of the value. */
+    const enum type m_type;
   };
 
   bool operator==(const std::shared_ptr<value>&, const std::shared_ptr<value>&);
@@ -40,7 +40,6 @@ namespace plorth
   {
     class parser parser(source, filename, line, column);
     std::vector<std::shared_ptr<token>> result;
-    std::vector<std::shared_ptr<value>> values;
 
     if (!parser.parse(result))
     {
@@ -54,8 +53,18 @@ namespace plorth
 
       return std::shared_ptr<quote>();
     }
-    values.reserve(result.size());
-    for (const auto& token : result)
+
+    return compile(result);
+  }
+
+  std::shared_ptr<quote> context::compile(
+    const std::vector<std::shared_ptr<token>>& tokens
+  )
+  {
+    std::vector<std::shared_ptr<value>> values;
+
+    values.reserve(tokens.size());
+    for (const auto& token : tokens)
     {
       values.push_back(compile_token(m_runtime, token));
     }
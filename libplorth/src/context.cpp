@@ -28,6 +28,8 @@
 
 #include "./utils.hpp"
 
+#include <atomic>
+
 namespace plorth
 {
   std::shared_ptr<context> context::make(
@@ -39,18 +41,182 @@ namespace plorth
     ));
   }
 
+  /**
+   * Source of namespace versions. Versions are unique across all contexts,
+   * so that a symbol cached in one context is never mistaken to be valid in
+   * another one.
+   */
+  static std::atomic<unsigned long> namespace_version_counter(0);
+
   context::context(const std::shared_ptr<class runtime>& runtime)
-    : m_runtime(runtime) {}
+    : m_runtime(runtime)
+    , m_namespace_version(0)
+    , m_module_generation(0) {}
+
+  void context::bind_namespace(const std::u32string& name,
+                               const std::u32string& path,
+                               const std::shared_ptr<object>& module)
+  {
+    const auto& module_manager = m_runtime->module_manager();
+
+    m_namespaces[name] = { path, module };
+    m_namespace_version = ++namespace_version_counter;
+    if (module_manager)
+    {
+      m_module_generation = module_manager->generation();
+    }
+  }
+
+  void context::refresh_namespaces()
+  {
+    const auto& module_manager = m_runtime->module_manager();
+    const auto importer = make(m_runtime);
+
+#if PLORTH_ENABLE_FILE_SYSTEM_MODULES
+    importer->filename(m_filename);
+#endif
+    for (auto& entry : m_namespaces)
+    {
+      // Modules which cannot be imported anymore keep their old version.
+      if (const auto module = module_manager->import_module(
+        importer,
+        entry.second.path
+      ))
+      {
+        entry.second.module = module;
+      }
+    }
+    m_namespace_version = ++namespace_version_counter;
+    m_module_generation = module_manager->generation();
+  }
+
+  std::shared_ptr<quote> context::resolve_qualified(
+    const std::shared_ptr<class symbol>& symbol,
+    std::shared_ptr<object>& module
+  )
+  {
+    std::shared_ptr<quote> result;
+    std::u32string::size_type separator;
+    namespace_container_type::const_iterator ns;
+    std::shared_ptr<value> slot;
+
+    if (!m_namespace_version)
+    {
+      return result;
+    }
+    else if (m_runtime->module_manager()
+             && m_runtime->module_manager()->generation()
+               != m_module_generation)
+    {
+      refresh_namespaces();
+    }
+    if (symbol->cached_word(m_namespace_version, result, module))
+    {
+      return result;
+    }
+
+    const auto& id = symbol->id();
+
+    separator = id.find(':');
+    if (separator != std::u32string::npos
+        && separator > 0
+        && separator + 1 < id.length()
+        && (ns = m_namespaces.find(id.substr(0, separator)))
+          != std::end(m_namespaces)
+        && ns->second.module
+        && ns->second.module->own_property(id.substr(separator + 1), slot)
+        && value::is(slot, value::type::quote))
+    {
+      result = std::static_pointer_cast<quote>(slot);
+      module = ns->second.module;
+    }
+    symbol->cache_word(m_namespace_version, result, module);
+
+    return result;
+  }
+
+  std::shared_ptr<quote> context::resolve_scoped(
+    const std::shared_ptr<class symbol>& symbol
+  ) const
+  {
+    const auto module = module_scope();
+    std::shared_ptr<value> slot;
+
+    if (module
+        && module->own_property(symbol->id(), slot)
+        && value::is(slot, value::type::quote))
+    {
+      return std::static_pointer_cast<quote>(slot);
+    }
+
+    return std::shared_ptr<quote>();
+  }
+
+  const struct position* context::error_position(
+    const struct position* position
+  ) const
+  {
+    if (!position && (m_position.filename.empty() || m_position.line > 0))
+    {
+      return &m_position;
+    }
+
+    return position;
+  }
 
   void context::error(enum error::code code,
                       const std::u32string& message,
                       const struct position* position)
   {
-    if (!position && (m_position.filename.empty() || m_position.line > 0))
+    m_error = m_runtime->value<class error>(
+      code,
+      message,
+      error_position(position)
+    );
+  }
+
+  void context::error(enum error::code code,
+                      const char32_t* message,
+                      const struct position* position)
+  {
+    m_error = m_runtime->value<class error>(
+      code,
+      message,
+      error_position(position)
+    );
+  }
+
+  void context::stack_underflow()
+  {
+    // Errors are usually discarded soon after they have been caught, so the
+    // previous instance can be reused when nothing else refers to it.
+    if (m_stack_underflow_error && m_stack_underflow_error.use_count() == 1)
+    {
+      m_stack_underflow_error->reset(error_position(nullptr));
+    } else {
+      m_stack_underflow_error = m_runtime->value<class error>(
+        error::code::range,
+        U"Stack underflow.",
+        error_position(nullptr)
+      );
+    }
+    m_error = m_stack_underflow_error;
+  }
+
+  void context::type_mismatch(enum value::type expected,
+                              enum value::type actual)
+  {
+    if (m_type_mismatch_error && m_type_mismatch_error.use_count() == 1)
     {
-      position = &m_position;
+      m_type_mismatch_error->reset(expected, actual, error_position(nullptr));
+    } else {
+      m_type_mismatch_error = m_runtime->value<class error>(
+        expected,
+        actual,
+        error_position(nullptr)
+      );
     }
-    m_error = m_runtime->value<class error>(code, message, position);
+    m_error = m_type_mismatch_error;
   }
 
   void context::push_null()
@@ -129,7 +295,7 @@ namespace plorth
 
       return true;
     }
-    error(error::code::range, U"Stack underflow.");
+    stack_underflow();
 
     return false;
   }
@@ -142,14 +308,7 @@ namespace plorth
 
       if (!value::is(value, type))
       {
-        error(
-          error::code::type,
-          U"Expected " +
-          value::type_description(type) +
-          U", got " +
-          value::type_description(value ? value->type() : value::type::null) +
-          U" instead."
-        );
+        type_mismatch(type, value ? value->type() : value::type::null);
 
         return false;
       }
@@ -157,7 +316,7 @@ namespace plorth
 
       return true;
     }
-    error(error::code::range, U"Stack underflow.");
+    stack_underflow();
 
     return false;
   }
@@ -171,7 +330,7 @@ namespace plorth
 
       return true;
     }
-    error(error::code::range, U"Stack underflow.");
+    stack_underflow();
 
     return false;
   }
@@ -183,14 +342,7 @@ namespace plorth
       slot = m_data.back();
       if (!value::is(slot, type))
       {
-        error(
-          error::code::type,
-          U"Expected " +
-          value::type_description(type) +
-          U", got " +
-          value::type_description(slot ? slot->type() : value::type::null) +
-          U" instead."
-        );
+        type_mismatch(type, slot ? slot->type() : value::type::null);
 
         return false;
       }
@@ -198,7 +350,7 @@ namespace plorth
 
       return true;
     }
-    error(error::code::range, U"Stack underflow.");
+    stack_underflow();
 
     return false;
   }
@@ -25,16 +25,26 @@
  */
 #include <plorth/dictionary.hpp>
 
+#include <atomic>
+
 namespace plorth
 {
-  dictionary::dictionary() {}
+  /**
+   * Counter used for generating versions of dictionaries.
+   */
+  static std::atomic<unsigned long> version_counter(0);
+
+  dictionary::dictionary()
+    : m_version(++version_counter) {}
 
   dictionary::dictionary(const dictionary& that)
-    : m_words(that.m_words) {}
+    : m_words(that.m_words)
+    , m_version(++version_counter) {}
 
   dictionary& dictionary::operator=(const dictionary& that)
   {
     m_words = that.m_words;
+    m_version = ++version_counter;
 
     return *this;
   }
@@ -74,5 +84,6 @@ namespace plorth
   void dictionary::insert(const value_type& word)
   {
     m_words[word->symbol()->id()] = word;
+    m_version = ++version_counter;
   }
 }
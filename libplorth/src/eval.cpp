@@ -112,15 +112,21 @@ namespace plorth
     std::vector<object::value_type> properties;
 
     properties.reserve(obj->size());
-    for (const auto& property : obj->entries())
+    if (!obj->for_each([&](const object::key_type& key,
+                           const object::mapped_type& property_value)
     {
       std::shared_ptr<value> value_slot;
 
-      if (property.second && !value::eval(ctx, property.second, value_slot))
+      if (property_value && !value::eval(ctx, property_value, value_slot))
       {
         return false;
       }
-      properties.push_back({ property.first, value_slot });
+      properties.push_back({ key, value_slot });
+
+      return true;
+    }))
+    {
+      return false;
     }
     slot = ctx->runtime()->object(properties);
 
@@ -0,0 +1,339 @@
+/*
+ * Copyright (c) 2017-2018, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <plorth/context.hpp>
+#include <plorth/event-loop.hpp>
+#include <plorth/unicode.hpp>
+#if PLORTH_ENABLE_EVENT_LOOP
+# include <cerrno>
+# include <climits>
+# include <cstring>
+# include <sys/epoll.h>
+# include <unistd.h>
+#endif
+
+namespace plorth
+{
+#if PLORTH_ENABLE_EVENT_LOOP
+  namespace
+  {
+    /** Maximum number of events retrieved with single call to epoll. */
+    static const int max_events = 64;
+
+    static std::u32string describe_error(const char32_t* message)
+    {
+      return message + utf8_decode(std::strerror(errno));
+    }
+  }
+
+  event_loop::event_loop()
+    : m_epoll_fd(-1)
+    , m_running(false) {}
+
+  event_loop::~event_loop()
+  {
+    if (m_epoll_fd >= 0)
+    {
+      ::close(m_epoll_fd);
+    }
+  }
+
+  void event_loop::watch(const std::shared_ptr<file>& f,
+                         enum event event,
+                         const std::shared_ptr<quote>& callback)
+  {
+    auto& w = entry(f);
+
+    if (event == event::readable)
+    {
+      w.on_readable = callback;
+    } else {
+      w.on_writable = callback;
+    }
+  }
+
+  void event_loop::unwatch(const std::shared_ptr<file>& f)
+  {
+    const auto it = m_watchers.find(f->fd());
+
+    if (it != std::end(m_watchers) && it->second.file == f)
+    {
+      it->second.on_readable.reset();
+      it->second.on_writable.reset();
+    }
+  }
+
+  void event_loop::flush_later(const std::shared_ptr<file>& f)
+  {
+    entry(f);
+  }
+
+  void event_loop::set_timeout(const clock::duration& delay,
+                               const std::shared_ptr<quote>& callback)
+  {
+    m_timers.emplace(clock::now() + delay, callback);
+  }
+
+  bool event_loop::run(const std::shared_ptr<context>& ctx)
+  {
+    struct epoll_event events[max_events];
+    bool result = true;
+
+    if (m_running)
+    {
+      ctx->error(error::code::unknown, U"Event loop is already running.");
+
+      return false;
+    }
+    if (m_epoll_fd < 0 && (m_epoll_fd = ::epoll_create1(EPOLL_CLOEXEC)) < 0)
+    {
+      ctx->error(
+        error::code::io,
+        describe_error(U"Unable to create event loop: ")
+      );
+
+      return false;
+    }
+    m_running = true;
+    while (result)
+    {
+      int count;
+
+      if (!run_timers(ctx) || !sync(ctx))
+      {
+        result = false;
+        break;
+      }
+      else if (m_watchers.empty() && m_timers.empty())
+      {
+        break;
+      }
+      count = ::epoll_wait(m_epoll_fd, events, max_events, next_timeout());
+      if (count < 0)
+      {
+        if (errno == EINTR)
+        {
+          continue;
+        }
+        ctx->error(error::code::io, describe_error(U"Unable to wait: "));
+        result = false;
+        break;
+      }
+      for (int i = 0; i < count && result; ++i)
+      {
+        const auto fd = events[i].data.fd;
+        const auto flags = events[i].events;
+        auto it = m_watchers.find(fd);
+        std::shared_ptr<file> f;
+
+        // Entry might have been removed or replaced by a callback called
+        // earlier during this iteration.
+        if (it == std::end(m_watchers)
+            || !(f = it->second.file)->is_open()
+            || f->fd() != fd)
+        {
+          continue;
+        }
+        if ((flags & (EPOLLOUT | EPOLLERR | EPOLLHUP))
+            && f->has_pending_output())
+        {
+          // Failed writes discard the pending output, after which the
+          // error is noticed by the callbacks when they use the file.
+          f->flush();
+        }
+        if ((flags & (EPOLLIN | EPOLLERR | EPOLLHUP)) && it->second.on_readable)
+        {
+          const auto callback = it->second.on_readable;
+
+          ctx->push(f);
+          if (!callback->call(ctx))
+          {
+            result = false;
+            break;
+          }
+          it = m_watchers.find(fd);
+          if (it == std::end(m_watchers) || it->second.file != f)
+          {
+            continue;
+          }
+        }
+        if ((flags & (EPOLLOUT | EPOLLERR | EPOLLHUP))
+            && it->second.on_writable
+            && f->is_open()
+            && !f->has_pending_output())
+        {
+          const auto callback = it->second.on_writable;
+
+          ctx->push(f);
+          if (!callback->call(ctx))
+          {
+            result = false;
+          }
+        }
+      }
+    }
+    m_running = false;
+
+    return result;
+  }
+
+  event_loop::watcher& event_loop::entry(const std::shared_ptr<file>& f)
+  {
+    auto& w = m_watchers[f->fd()];
+
+    if (w.file != f)
+    {
+      // File descriptor of a closed file has been reused by another file.
+      // Closing the descriptor has already removed it from epoll.
+      w.file = f;
+      w.on_readable.reset();
+      w.on_writable.reset();
+      w.registered = 0;
+    }
+
+    return w;
+  }
+
+  bool event_loop::sync(const std::shared_ptr<context>& ctx)
+  {
+    for (auto it = std::begin(m_watchers); it != std::end(m_watchers);)
+    {
+      const auto fd = it->first;
+      auto& w = it->second;
+      std::uint32_t wanted = 0;
+      struct epoll_event ev;
+      int op;
+
+      if (!w.file->is_open() || w.file->fd() != fd)
+      {
+        it = m_watchers.erase(it);
+        continue;
+      }
+      if (w.on_readable)
+      {
+        wanted |= EPOLLIN;
+      }
+      if (w.on_writable || w.file->has_pending_output())
+      {
+        wanted |= EPOLLOUT;
+      }
+      if (!wanted)
+      {
+        if (w.registered)
+        {
+          ::epoll_ctl(m_epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+        }
+        it = m_watchers.erase(it);
+        continue;
+      }
+      else if (wanted == w.registered)
+      {
+        ++it;
+        continue;
+      }
+      std::memset(&ev, 0, sizeof(ev));
+      ev.events = wanted;
+      ev.data.fd = fd;
+      op = w.registered ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+      // Registration might be out of sync if the file descriptor has been
+      // closed and reused, in which case the other operation is attempted.
+      if (::epoll_ctl(m_epoll_fd, op, fd, &ev) != 0
+          && ((errno != EEXIST && errno != ENOENT)
+              || ::epoll_ctl(
+                m_epoll_fd,
+                op == EPOLL_CTL_ADD ? EPOLL_CTL_MOD : EPOLL_CTL_ADD,
+                fd,
+                &ev
+              ) != 0))
+      {
+        ctx->error(error::code::io, describe_error(U"Unable to watch file: "));
+
+        return false;
+      }
+      w.registered = wanted;
+      ++it;
+    }
+
+    return true;
+  }
+
+  bool event_loop::run_timers(const std::shared_ptr<context>& ctx)
+  {
+    const auto now = clock::now();
+
+    // Timers scheduled by the callbacks expire after the current time, so
+    // that they are called only on the next iteration of the loop.
+    while (!m_timers.empty() && m_timers.begin()->first <= now)
+    {
+      const auto callback = m_timers.begin()->second;
+
+      m_timers.erase(m_timers.begin());
+      if (!callback->call(ctx))
+      {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  int event_loop::next_timeout() const
+  {
+    clock::duration remaining;
+    std::chrono::milliseconds milliseconds;
+
+    if (m_timers.empty())
+    {
+      return -1;
+    }
+    remaining = m_timers.begin()->first - clock::now();
+    if (remaining <= clock::duration::zero())
+    {
+      return 0;
+    }
+    milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(
+      remaining
+    );
+    if (milliseconds < remaining)
+    {
+      ++milliseconds;
+    }
+
+    return milliseconds.count() > INT_MAX
+      ? INT_MAX
+      : static_cast<int>(milliseconds.count());
+  }
+
+  class event_loop& runtime::event_loop()
+  {
+    if (!m_event_loop)
+    {
+      m_event_loop = std::make_shared<class event_loop>();
+    }
+
+    return *m_event_loop;
+  }
+#endif
+}
@@ -85,16 +85,35 @@ namespace plorth
       ctx->position() = *position;
     }
 
-    // Look for prototype of the current item.
+    // Look for prototype of the current item. Built-in prototypes cannot be
+    // modified, so their words are looked up from the method table of the
+    // runtime. Only objects have to be searched through their prototype
+    // chain, unless they inherit directly from the object prototype.
     {
       const auto& stack = ctx->data();
 
       if (!stack.empty() && stack.back())
       {
-        const auto prototype = stack.back()->prototype(ctx->runtime());
+        const auto& runtime = ctx->runtime();
+        const auto& top = stack.back();
         std::shared_ptr<value> val;
+        bool found;
 
-        if (prototype && prototype->property(ctx->runtime(), id, val))
+        if (top->is(value::type::object))
+        {
+          const auto prototype = top->prototype(runtime);
+
+          if (prototype.get() == runtime->object_prototype().get())
+          {
+            found = runtime->prototype_word(value::type::object, *sym, val);
+          } else {
+            found = prototype && prototype->property(runtime, id, val);
+          }
+        } else {
+          found = runtime->prototype_word(top->type(), *sym, val);
+        }
+
+        if (found)
         {
           if (value::is(val, value::type::quote))
           {
@@ -107,15 +126,29 @@ namespace plorth
       }
     }
 
+    // Look for a word from the module which the quote being executed was
+    // defined in, so that words of a module can call each other.
+    if (auto quote = ctx->resolve_scoped(sym))
+    {
+      return quote->call(ctx);
+    }
+
     // Look for a word from dictionary of current context.
     if (auto word = ctx->dictionary().find(sym))
     {
       return word->quote()->call(ctx);
     }
 
-    // TODO: If not found, see if it's a "fully qualified" name, e.g. a name
-    // with a namespace name, colon and a word - Such as "num:+", and then look
-    // for that from the specified namespace.
+    // Look for a qualified name, such as "math:range", from the modules
+    // bound as namespaces in current context.
+    {
+      std::shared_ptr<object> module;
+
+      if (auto quote = ctx->resolve_qualified(sym, module))
+      {
+        return quote->call(ctx);
+      }
+    }
 
     // Look from global dictionary.
     if (auto word = ctx->runtime()->dictionary().find(sym))
@@ -24,6 +24,9 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 #include <plorth/context.hpp>
+#include <plorth/event-loop.hpp>
+#include <plorth/value-file.hpp>
+#include <plorth/value-stream.hpp>
 
 #include <cmath>
 #include <chrono>
@@ -443,6 +446,40 @@ namespace plorth
     type_test(ctx, value::type::boolean);
   }
 
+  /**
+   * Word: file?
+   *
+   * Takes:
+   * - any
+   *
+   * Gives:
+   * - any
+   * - boolean
+   *
+   * Returns true if the topmost value of the stack is a file.
+   */
+  static void w_is_file(const std::shared_ptr<context>& ctx)
+  {
+    type_test(ctx, value::type::file);
+  }
+
+  /**
+   * Word: bytes?
+   *
+   * Takes:
+   * - any
+   *
+   * Gives:
+   * - any
+   * - boolean
+   *
+   * Returns true if the topmost value of the stack is a byte sequence.
+   */
+  static void w_is_bytes(const std::shared_ptr<context>& ctx)
+  {
+    type_test(ctx, value::type::bytes);
+  }
+
   /**
    * Word: error?
    *
@@ -581,6 +618,40 @@ namespace plorth
     }
   }
 
+  /**
+   * Word: stream?
+   *
+   * Takes:
+   * - any
+   *
+   * Gives:
+   * - any
+   * - boolean
+   *
+   * Returns true if the topmost value of the stack is a stream.
+   */
+  static void w_is_stream(const std::shared_ptr<context>& ctx)
+  {
+    type_test(ctx, value::type::stream);
+  }
+
+  /**
+   * Word: string-builder?
+   *
+   * Takes:
+   * - any
+   *
+   * Gives:
+   * - any
+   * - boolean
+   *
+   * Returns true if the topmost value of the stack is a string builder.
+   */
+  static void w_is_string_builder(const std::shared_ptr<context>& ctx)
+  {
+    type_test(ctx, value::type::string_builder);
+  }
+
   /**
    * Word: symbol?
    *
@@ -1177,6 +1248,30 @@ namespace plorth
     }
   }
 
+  /**
+   * Word: import-as
+   *
+   * Takes:
+   * - string
+   * - string
+   *
+   * Imports module from given path and binds it as a namespace with the
+   * given name in this execution context. Words exported by the module can
+   * then be executed by prefixing them with the namespace name and a colon,
+   * such as `range:new`. Words are looked up from the module only when they
+   * are used.
+   */
+  static void w_import_as(const std::shared_ptr<context>& ctx)
+  {
+    std::shared_ptr<string> ns;
+    std::shared_ptr<string> path;
+
+    if (ctx->pop_string(ns) && ctx->pop_string(path))
+    {
+      ctx->runtime()->import(ctx, path->to_string(), ns->to_string());
+    }
+  }
+
   /**
    * Word: args
    *
@@ -1231,10 +1326,7 @@ namespace plorth
       {
         message = std::static_pointer_cast<string>(val)->to_string();
       } else {
-        ctx->error(
-          error::code::type,
-          U"Expected string, got " + val->type_description() + U" instead."
-        );
+        ctx->type_mismatch(value::type::string, val->type());
         return;
       }
     }
@@ -1389,6 +1481,27 @@ namespace plorth
     }
   }
 
+  /**
+   * Word: input-lines
+   *
+   * Gives:
+   * - stream
+   *
+   * Returns a stream which reads lines from standard input stream, one line
+   * at a time. Line separators are not included in the lines. Processing the
+   * stream with for-each, map and filter uses constant amount of memory
+   * regardless of the size of the input.
+   *
+   *     input-lines ( "ERROR" swap starts-with? nip ) swap filter
+   *     ( println ) swap for-each
+   */
+  static void w_input_lines(const std::shared_ptr<context>& ctx)
+  {
+    const auto& runtime = ctx->runtime();
+
+    ctx->push(stream::lines(*runtime, runtime->input()));
+  }
+
   /**
    * Word: print
    *
@@ -1401,8 +1514,14 @@ namespace plorth
   {
     std::shared_ptr<value> val;
 
-    if (ctx->pop(val) && val)
+    if (!ctx->pop(val) || !val)
+    {
+      return;
+    }
+    else if (val->is(value::type::string))
     {
+      ctx->runtime()->print(std::static_pointer_cast<string>(val));
+    } else {
       ctx->runtime()->print(val->to_string());
     }
   }
@@ -1423,7 +1542,11 @@ namespace plorth
 
     if (ctx->pop(val))
     {
-      if (val)
+      if (value::is(val, value::type::string))
+      {
+        runtime->print(std::static_pointer_cast<string>(val));
+      }
+      else if (val)
       {
         runtime->print(val->to_string());
       }
@@ -1458,6 +1581,263 @@ namespace plorth
     }
   }
 
+  static void open_file(const std::shared_ptr<context>& ctx,
+                        enum file::mode mode)
+  {
+    std::shared_ptr<string> path;
+
+    if (ctx->pop_string(path))
+    {
+      const auto f = file::open(ctx, path->to_string(), mode);
+
+      if (f)
+      {
+        ctx->push(f);
+      }
+    }
+  }
+
+  /**
+   * Word: open-read
+   *
+   * Takes:
+   * - string
+   *
+   * Gives:
+   * - file
+   *
+   * Opens file from given path for reading. I/O error will be thrown if the
+   * file cannot be opened.
+   *
+   *     "input.txt" open-read read-line nip
+   */
+  static void w_open_read(const std::shared_ptr<context>& ctx)
+  {
+    open_file(ctx, file::mode::read);
+  }
+
+  /**
+   * Word: open-write
+   *
+   * Takes:
+   * - string
+   *
+   * Gives:
+   * - file
+   *
+   * Opens file from given path for writing. The file is created if it does
+   * not exist and truncated if it does. I/O error will be thrown if the file
+   * cannot be opened.
+   *
+   *     "output.txt" open-write "foo\n" swap write close
+   */
+  static void w_open_write(const std::shared_ptr<context>& ctx)
+  {
+    open_file(ctx, file::mode::write);
+  }
+
+  /**
+   * Word: slurp
+   *
+   * Takes:
+   * - string
+   *
+   * Gives:
+   * - string
+   *
+   * Reads entire contents of file from given path, decodes it as UTF-8
+   * encoded text and returns result. Regular files are mapped into memory,
+   * and contents of files consisting of ASCII characters only are not copied
+   * at all. I/O error will be thrown if the file cannot be read.
+   */
+  static void w_slurp(const std::shared_ptr<context>& ctx)
+  {
+    std::shared_ptr<string> path;
+
+    if (ctx->pop_string(path))
+    {
+      const auto contents = file::slurp(ctx, path->to_string());
+
+      if (contents)
+      {
+        ctx->push(contents);
+      }
+    }
+  }
+
+  /**
+   * Word: slurp-bytes
+   *
+   * Takes:
+   * - string
+   *
+   * Gives:
+   * - bytes
+   *
+   * Reads entire contents of file from given path and returns them as a
+   * byte sequence, without decoding them. Regular files are mapped into
+   * memory instead of being copied. I/O error will be thrown if the file
+   * cannot be read.
+   */
+  static void w_slurp_bytes(const std::shared_ptr<context>& ctx)
+  {
+    std::shared_ptr<string> path;
+
+    if (ctx->pop_string(path))
+    {
+      const auto contents = file::slurp_bytes(ctx, path->to_string());
+
+      if (contents)
+      {
+        ctx->push(contents);
+      }
+    }
+  }
+
+  /**
+   * Word: pipe
+   *
+   * Gives:
+   * - file
+   * - file
+   *
+   * Creates a pipe in non-blocking mode. End of the pipe which is read from
+   * is placed below the end which is written into.
+   *
+   *     pipe "foo" swap write close read-bytes
+   */
+  static void w_pipe(const std::shared_ptr<context>& ctx)
+  {
+    std::shared_ptr<file> read_end;
+    std::shared_ptr<file> write_end;
+
+    if (file::pipe(ctx, read_end, write_end))
+    {
+      ctx->push(read_end);
+      ctx->push(write_end);
+    }
+  }
+
+  static void socket_file(const std::shared_ptr<context>& ctx, bool listen)
+  {
+    std::shared_ptr<string> path;
+
+    if (ctx->pop_string(path))
+    {
+      const auto f = listen
+        ? file::listen(ctx, path->to_string())
+        : file::connect(ctx, path->to_string());
+
+      if (f)
+      {
+        ctx->push(f);
+      }
+    }
+  }
+
+  /**
+   * Word: unix-connect
+   *
+   * Takes:
+   * - string
+   *
+   * Gives:
+   * - file
+   *
+   * Connects to Unix domain socket in given path. The connection is in
+   * non-blocking mode and can be both read from and written into. I/O error
+   * will be thrown if the connection cannot be established.
+   *
+   *     "/tmp/app.sock" unix-connect "ping\n" swap write
+   */
+  static void w_unix_connect(const std::shared_ptr<context>& ctx)
+  {
+    socket_file(ctx, false);
+  }
+
+  /**
+   * Word: unix-listen
+   *
+   * Takes:
+   * - string
+   *
+   * Gives:
+   * - file
+   *
+   * Creates Unix domain socket which listens for connections in given path.
+   * Socket left behind in the same path is removed first. Connections are
+   * accepted from the socket with `accept`, once the event loop reports it
+   * readable.
+   *
+   *     "/tmp/app.sock" unix-listen ( accept nip close ) swap on-readable
+   */
+  static void w_unix_listen(const std::shared_ptr<context>& ctx)
+  {
+    socket_file(ctx, true);
+  }
+
+  /**
+   * Word: set-timeout
+   *
+   * Takes:
+   * - quote
+   * - number
+   *
+   * Schedules quote to be called by the event loop once given number of
+   * milliseconds has passed. The delay may be at most 2147483647
+   * milliseconds, which is a little less than 25 days.
+   *
+   *     ( "done" println ) 100 set-timeout run-event-loop
+   */
+  static void w_set_timeout(const std::shared_ptr<context>& ctx)
+  {
+#if PLORTH_ENABLE_EVENT_LOOP
+    // Converting much larger delays into the clock of the event loop would
+    // overflow it.
+    static const double max_milliseconds = 2147483647.0;
+    std::shared_ptr<number> delay;
+    std::shared_ptr<quote> callback;
+
+    if (ctx->pop_number(delay) && ctx->pop_quote(callback))
+    {
+      const auto milliseconds = delay->as_real();
+
+      if (milliseconds < 0
+          || milliseconds > max_milliseconds
+          || !std::isfinite(milliseconds))
+      {
+        ctx->error(error::code::range, U"Invalid timeout.");
+        return;
+      }
+      ctx->runtime()->event_loop().set_timeout(
+        std::chrono::duration_cast<event_loop::clock::duration>(
+          std::chrono::duration<double, std::milli>(milliseconds)
+        ),
+        callback
+      );
+    }
+#else
+    ctx->error(error::code::io, U"Event loop has been disabled.");
+#endif
+  }
+
+  /**
+   * Word: run-event-loop
+   *
+   * Runs the event loop, calling quotes registered with `on-readable`,
+   * `on-writable` and `set-timeout` as the files become ready and the
+   * timers expire. Returns once there are no more files to watch or timers
+   * to wait for. Error thrown by one of the quotes stops the event loop.
+   */
+  static void w_run_event_loop(const std::shared_ptr<context>& ctx)
+  {
+#if PLORTH_ENABLE_EVENT_LOOP
+    ctx->runtime()->event_loop().run(ctx);
+#else
+    ctx->error(error::code::io, U"Event loop has been disabled.");
+#endif
+  }
+
   /**
    * Word: now
    *
@@ -1527,89 +1907,106 @@ namespace plorth
       return
       {
         // Constants.
-        { U"null", w_null },
-        { U"true", w_true },
-        { U"false", w_false },
-        { U"e", w_e },
-        { U"pi", w_pi },
-        { U"inf", w_inf },
-        { U"-inf", w_minus_inf },
-        { U"nan", w_nan },
+        { U"null", w_null, U"-- null" },
+        { U"true", w_true, U"-- boolean" },
+        { U"false", w_false, U"-- boolean" },
+        { U"e", w_e, U"-- number" },
+        { U"pi", w_pi, U"-- number" },
+        { U"inf", w_inf, U"-- number" },
+        { U"-inf", w_minus_inf, U"-- number" },
+        { U"nan", w_nan, U"-- number" },
 
         // Stack manipulation.
-        { U"nop", w_nop },
-        { U"clear", w_clear },
-        { U"depth", w_depth },
-        { U"drop", w_drop },
-        { U"2drop", w_drop2 },
-        { U"dup", w_dup },
-        { U"2dup", w_dup2 },
-        { U"nip", w_nip },
-        { U"over", w_over },
-        { U"rot", w_rot },
-        { U"swap", w_swap },
-        { U"tuck", w_tuck },
+        { U"nop", w_nop, U"--" },
+        { U"clear", w_clear, nullptr },
+        { U"depth", w_depth, U"-- number" },
+        { U"drop", w_drop, U"a --" },
+        { U"2drop", w_drop2, U"a b --" },
+        { U"dup", w_dup, U"a -- a a" },
+        { U"2dup", w_dup2, U"a b -- a b a b" },
+        { U"nip", w_nip, U"a b -- b" },
+        { U"over", w_over, U"a b -- a b a" },
+        { U"rot", w_rot, U"a b c -- b c a" },
+        { U"swap", w_swap, U"a b -- b a" },
+        { U"tuck", w_tuck, U"a b -- b a b" },
 
         // Value types.
-        { U"array?", w_is_array },
-        { U"boolean?", w_is_boolean },
-        { U"error?", w_is_error },
-        { U"null?", w_is_null },
-        { U"number?", w_is_number },
-        { U"object?", w_is_object },
-        { U"quote?", w_is_quote },
-        { U"string?", w_is_string },
-        { U"symbol?", w_is_symbol },
-        { U"word?", w_is_word },
+        { U"array?", w_is_array, U"a -- a boolean" },
+        { U"boolean?", w_is_boolean, U"a -- a boolean" },
+        { U"bytes?", w_is_bytes, U"a -- a boolean" },
+        { U"error?", w_is_error, U"a -- a boolean" },
+        { U"file?", w_is_file, U"a -- a boolean" },
+        { U"null?", w_is_null, U"a -- a boolean" },
+        { U"number?", w_is_number, U"a -- a boolean" },
+        { U"object?", w_is_object, U"a -- a boolean" },
+        { U"quote?", w_is_quote, U"a -- a boolean" },
+        { U"stream?", w_is_stream, U"a -- a boolean" },
+        { U"string?", w_is_string, U"a -- a boolean" },
+        { U"string-builder?", w_is_string_builder, U"a -- a boolean" },
+        { U"symbol?", w_is_symbol, U"a -- a boolean" },
+        { U"word?", w_is_word, U"a -- a boolean" },
         { U"typeof" , w_typeof },
-        { U"instance-of?", w_is_instance_of },
-        { U"proto", w_proto },
+        { U"instance-of?", w_is_instance_of, U"a object -- a boolean" },
+        { U"proto", w_proto, U"a -- a object|null" },
 
         // Conversions.
-        { U">boolean", w_to_boolean },
-        { U">string", w_to_string },
-        { U">source", w_to_source },
+        { U">boolean", w_to_boolean, U"any -- boolean" },
+        { U">string", w_to_string, U"any -- string" },
+        { U">source", w_to_source, U"any -- string" },
 
         // Constructors.
-        { U"1array", w_1array },
-        { U"2array", w_2array },
-        { U"narray", w_narray },
+        { U"1array", w_1array, U"any -- array" },
+        { U"2array", w_2array, U"any any -- array" },
+        { U"narray", w_narray, nullptr },
 
         // Logic.
-        { U"if", w_if },
-        { U"if-else", w_if_else },
-        { U"while", w_while },
-        { U"try", w_try },
-        { U"try-else", w_try_else },
+        { U"if", w_if, nullptr },
+        { U"if-else", w_if_else, nullptr },
+        { U"while", w_while, nullptr },
+        { U"try", w_try, nullptr },
+        { U"try-else", w_try_else, nullptr },
 
         // Interpreter related.
-        { U"compile", w_compile },
-        { U"globals", w_globals },
-        { U"locals", w_locals },
-        { U"const", w_const },
-        { U"import", w_import },
-        { U"args", w_args },
-        { U"version", w_version },
+        { U"compile", w_compile, U"string -- quote" },
+        { U"globals", w_globals, U"-- object" },
+        { U"locals", w_locals, U"-- object" },
+        { U"const", w_const, nullptr },
+        { U"import", w_import, nullptr },
+        { U"import-as", w_import_as, U"string string --" },
+        { U"args", w_args, U"-- array" },
+        { U"version", w_version, U"-- string" },
 
         // Different types of errors.
-        { U"type-error", w_type_error },
-        { U"value-error", w_value_error },
-        { U"range-error", w_range_error },
-        { U"unknown-error", w_unknown_error },
+        { U"type-error", w_type_error, U"string|null -- error" },
+        { U"value-error", w_value_error, U"string|null -- error" },
+        { U"range-error", w_range_error, U"string|null -- error" },
+        { U"unknown-error", w_unknown_error, U"string|null -- error" },
 
         // I/O related.
-        { U"read", w_read },
-        { U"nread", w_nread },
-        { U"print", w_print },
-        { U"println", w_println },
-        { U"emit", w_emit },
+        { U"read", w_read, U"-- string|null" },
+        { U"nread", w_nread, U"number -- string|null" },
+        { U"input-lines", w_input_lines, U"-- stream" },
+        { U"print", w_print, U"any --" },
+        { U"println", w_println, U"any --" },
+        { U"emit", w_emit, U"number --" },
+        { U"open-read", w_open_read, U"string -- file" },
+        { U"open-write", w_open_write, U"string -- file" },
+        { U"slurp", w_slurp, U"string -- string" },
+        { U"slurp-bytes", w_slurp_bytes, U"string -- bytes" },
+
+        // Event loop.
+        { U"pipe", w_pipe, U"-- file file" },
+        { U"unix-connect", w_unix_connect, U"string -- file" },
+        { U"unix-listen", w_unix_listen, U"string -- file" },
+        { U"set-timeout", w_set_timeout, U"quote number --" },
+        { U"run-event-loop", w_run_event_loop, nullptr },
 
         // Random utilities.
-        { U"now", w_now },
+        { U"now", w_now, U"-- number" },
 
         // Global operators.
-        { U"=", w_eq },
-        { U"!=", w_ne },
+        { U"=", w_eq, U"any any -- boolean" },
+        { U"!=", w_ne, U"any any -- boolean" },
       };
     }
   }
@@ -0,0 +1,239 @@
+/*
+ * Copyright (c) 2017-2018, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "./inliner.hpp"
+
+namespace plorth
+{
+  namespace inliner
+  {
+    /**
+     * Tests whether given values refer to a word with given name, either
+     * directly or from quotes contained in them.
+     */
+    static bool refers_to(const std::vector<std::shared_ptr<value>>& values,
+                          const std::u32string& id)
+    {
+      for (const auto& value : values)
+      {
+        if (value::is(value, value::type::symbol))
+        {
+          if (!std::static_pointer_cast<symbol>(value)->id().compare(id))
+          {
+            return true;
+          }
+        }
+        else if (value::is(value, value::type::quote))
+        {
+          const auto nested = std::static_pointer_cast<quote>(value)->values();
+
+          if (nested && refers_to(*nested, id))
+          {
+            return true;
+          }
+        }
+      }
+
+      return false;
+    }
+
+    /**
+     * Returns values of given word if it can be inlined, or null pointer if
+     * it cannot be. Words of modules are not inlined, as symbols in them
+     * would be resolved from the caller instead of the module.
+     */
+    static const std::vector<std::shared_ptr<value>>* inlinable_values(
+      const std::shared_ptr<word>& word
+    )
+    {
+      const auto& quote = word->quote();
+      const auto values = quote->values();
+
+      if (!values
+          || values->empty()
+          || values->size() > max_word_size
+          || quote->bound())
+      {
+        return nullptr;
+      }
+      for (const auto& value : *values)
+      {
+        if (value::is(value, value::type::word))
+        {
+          return nullptr;
+        }
+      }
+      if (refers_to(*values, word->symbol()->id()))
+      {
+        return nullptr;
+      }
+
+      return values;
+    }
+
+    static stack_effect::type_set prototypes_of(
+      const std::shared_ptr<class runtime>& runtime,
+      const std::u32string& id
+    )
+    {
+      const struct
+      {
+        enum value::type type;
+        const std::shared_ptr<object>& prototype;
+      } prototypes[] =
+      {
+        { value::type::boolean, runtime->boolean_prototype() },
+        { value::type::number, runtime->number_prototype() },
+        { value::type::string, runtime->string_prototype() },
+        { value::type::array, runtime->array_prototype() },
+        { value::type::symbol, runtime->symbol_prototype() },
+        { value::type::quote, runtime->quote_prototype() },
+        { value::type::word, runtime->word_prototype() },
+        { value::type::error, runtime->error_prototype() },
+        { value::type::string_builder, runtime->string_builder_prototype() },
+        { value::type::file, runtime->file_prototype() },
+        { value::type::bytes, runtime->bytes_prototype() },
+        { value::type::stream, runtime->stream_prototype() }
+      };
+      stack_effect::type_set result = 0;
+
+      for (const auto& entry : prototypes)
+      {
+        if (entry.prototype->has_own_property(id))
+        {
+          result |= stack_effect::type_of(entry.type);
+        }
+      }
+
+      return result;
+    }
+
+    static void expand(const std::shared_ptr<context>& ctx,
+                       const std::vector<std::shared_ptr<value>>& values,
+                       std::vector<std::shared_ptr<value>>& result,
+                       std::vector<guard>& guards,
+                       std::size_t depth)
+    {
+      const auto& dictionary = ctx->dictionary();
+
+      for (const auto& value : values)
+      {
+        std::shared_ptr<class word> word;
+        const std::vector<std::shared_ptr<class value>>* inlined;
+
+        if (depth >= max_depth
+            || !value::is(value, value::type::symbol)
+            || !(word = dictionary.find(std::static_pointer_cast<symbol>(value)))
+            || !(inlined = inlinable_values(word)))
+        {
+          result.push_back(value);
+          continue;
+        }
+
+        const auto index = guards.size();
+        guard g;
+
+        g.index = result.size();
+        g.symbol = value;
+        g.quote = word->quote();
+        g.prototypes = prototypes_of(
+          ctx->runtime(),
+          std::static_pointer_cast<symbol>(value)->id()
+        );
+        g.dictionary_version = dictionary.version();
+        guards.push_back(g);
+        expand(ctx, *inlined, result, guards, depth + 1);
+        guards[index].size = result.size() - guards[index].index;
+      }
+    }
+
+    bool expand(const std::shared_ptr<context>& ctx,
+                const std::vector<std::shared_ptr<value>>& values,
+                std::vector<std::shared_ptr<value>>& result,
+                std::vector<guard>& guards)
+    {
+      result.clear();
+      guards.clear();
+      expand(ctx, values, result, guards, 0);
+
+      return !guards.empty();
+    }
+
+    bool enter(const std::shared_ptr<context>& ctx, guard& g)
+    {
+      const auto& stack = ctx->data();
+      const auto& dictionary = ctx->dictionary();
+      const auto sym = static_cast<const symbol*>(g.symbol.get());
+
+      // Words of prototypes are looked up first by the interpreter.
+      if (!stack.empty() && stack.back())
+      {
+        const auto& top = stack.back();
+
+        if (top->is(value::type::object))
+        {
+          const auto& runtime = ctx->runtime();
+          const auto prototype = top->prototype(runtime);
+          std::shared_ptr<value> slot;
+
+          if (prototype && prototype->property(runtime, sym->id(), slot))
+          {
+            return false;
+          }
+        }
+        else if (g.prototypes & stack_effect::type_of(top->type()))
+        {
+          return false;
+        }
+      }
+
+      // Followed by words of the module whose word is being executed.
+      if (ctx->module_scope())
+      {
+        return false;
+      }
+
+      // Words of the context dictionary may have been redefined since the
+      // word was inlined.
+      if (g.dictionary_version != dictionary.version())
+      {
+        const auto word = dictionary.find(sym->id());
+
+        if (!word || word->quote().get() != g.quote.get())
+        {
+          return false;
+        }
+        g.dictionary_version = dictionary.version();
+      }
+
+      if (const auto position = sym->position())
+      {
+        ctx->position() = *position;
+      }
+
+      return true;
+    }
+  }
+}
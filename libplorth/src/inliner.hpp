@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2017-2018, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef PLORTH_INLINER_HPP_GUARD
+#define PLORTH_INLINER_HPP_GUARD
+
+#include <plorth/context.hpp>
+
+namespace plorth
+{
+  namespace inliner
+  {
+    /** Maximum number of values in words which are inlined. */
+    static const std::size_t max_word_size = 8;
+
+    /** Maximum depth of words inlined into values of other inlined words. */
+    static const std::size_t max_depth = 3;
+
+    /**
+     * Word which has been inlined into values of a compiled quote. Values of
+     * the word are executed in place of the symbol, as long as the symbol
+     * would still be resolved into the same word.
+     */
+    struct guard
+    {
+      /** Index of the first inlined value. */
+      std::size_t index;
+      /** Number of inlined values, including values of nested words. */
+      std::size_t size;
+      /** Symbol which was replaced with values of the word. */
+      std::shared_ptr<value> symbol;
+      /** Quote of the inlined word. */
+      std::shared_ptr<class quote> quote;
+      /** Types of values whose prototypes contain word with same name. */
+      stack_effect::type_set prototypes;
+      /** Version of the dictionary where the word was last found from. */
+      unsigned long dictionary_version;
+    };
+
+    /**
+     * Replaces symbols which refer to short, non-recursive words of the
+     * context dictionary with values of the words. Words referred to from the
+     * inlined values are inlined as well, up to the maximum depth. Guards of
+     * such words are placed after the guard of the word containing them.
+     *
+     * \param ctx    Scripting context whose dictionary is used for resolving
+     *               the words.
+     * \param values Values of a compiled quote.
+     * \param result Where the values, with words inlined, are placed into.
+     * \param guards Where the inlined words are placed into.
+     * \return       Boolean flag which tells whether any words were inlined
+     *               or not.
+     */
+    bool expand(const std::shared_ptr<context>& ctx,
+                const std::vector<std::shared_ptr<value>>& values,
+                std::vector<std::shared_ptr<value>>& result,
+                std::vector<guard>& guards);
+
+    /**
+     * Tests whether the symbol of an inlined word would still be resolved
+     * into the same word by the interpreter. If it would, source code
+     * position of the context is updated as if the word was called.
+     */
+    bool enter(const std::shared_ptr<context>& ctx, guard& guard);
+  }
+}
+
+#endif /* !PLORTH_INLINER_HPP_GUARD */
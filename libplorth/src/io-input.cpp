@@ -24,15 +24,80 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 #include <plorth/io-input.hpp>
+#if PLORTH_ENABLE_STANDARD_IO && PLORTH_ENABLE_FILE_IO
+# include <plorth/context.hpp>
+# include <plorth/value-file.hpp>
+# include <unistd.h>
+#endif
 
 namespace plorth
 {
   namespace
   {
-#if PLORTH_ENABLE_STANDARD_IO
+#if PLORTH_ENABLE_STANDARD_IO && PLORTH_ENABLE_FILE_IO
+    /**
+     * Standard input which reads the file descriptor of the standard input
+     * stream with the same buffered reader which is used by files, instead
+     * of going through C++ streams.
+     */
     class standard_input : public io::input
     {
     public:
+      explicit standard_input(memory::manager& memory_manager)
+        : m_file(new (memory_manager) file(
+            ::dup(STDIN_FILENO),
+            file::mode::read,
+            U"<stdin>"
+          )) {}
+
+      result read(size_type size, std::u32string& output, size_type& read)
+      {
+        size_type chunk_read;
+        result status;
+
+        if (!m_file->is_open())
+        {
+          read = 0;
+
+          return result::eof;
+        }
+        else if (size)
+        {
+          return m_file->read_chunk(size, output, read);
+        }
+
+        // Read everything until the end of input.
+        read = 0;
+        do
+        {
+          status = m_file->read_chunk(file::buffer_size, output, chunk_read);
+          read += chunk_read;
+        }
+        while (status == result::ok);
+
+        return status;
+      }
+
+      result read_line(std::u32string& output)
+      {
+        if (!m_file->is_open())
+        {
+          return result::eof;
+        }
+
+        return m_file->read_line(output);
+      }
+
+    private:
+      /** Duplicate of the standard input file descriptor. */
+      const std::shared_ptr<file> m_file;
+    };
+#elif PLORTH_ENABLE_STANDARD_IO
+    class standard_input : public io::input
+    {
+    public:
+      explicit standard_input(memory::manager&) {}
+
       result read(size_type size, std::u32string& output, size_type& read)
       {
         const bool infinite = !size;
@@ -77,6 +142,25 @@ namespace plorth
 
         return result::ok;
       }
+
+      result read_line(std::u32string& output)
+      {
+        // Entire line is extracted from the stream at once, into a buffer
+        // which is reused between the calls.
+        if (!std::getline(std::cin, m_buffer))
+        {
+          return result::eof;
+        }
+        if (!m_buffer.empty() && m_buffer.back() == '\r')
+        {
+          m_buffer.pop_back();
+        }
+
+        return utf8_decode_test(m_buffer, output) ? result::ok : result::failure;
+      }
+
+    private:
+      std::string m_buffer;
     };
 #endif
 
@@ -94,10 +178,43 @@ namespace plorth
 
   namespace io
   {
+    input::result input::read_line(std::u32string& output)
+    {
+      bool consumed = false;
+      std::u32string c;
+      size_type read;
+
+      for (;;)
+      {
+        if (this->read(1, c, read) == result::failure)
+        {
+          return result::failure;
+        }
+        else if (!read)
+        {
+          return consumed ? result::ok : result::eof;
+        }
+        consumed = true;
+        if (c[0] == '\n')
+        {
+          if (!output.empty() && output.back() == '\r')
+          {
+            output.pop_back();
+          }
+
+          return result::ok;
+        }
+        output.append(c);
+        c.clear();
+      }
+    }
+
     std::shared_ptr<input> input::standard(memory::manager& memory_manager)
     {
 #if PLORTH_ENABLE_STANDARD_IO
-      return std::shared_ptr<input>(new (memory_manager) standard_input());
+      return std::shared_ptr<input>(
+        new (memory_manager) standard_input(memory_manager)
+      );
 #else
       return dummy(memory_manager);
 #endif
@@ -0,0 +1,755 @@
+/*
+ * Copyright (c) 2017-2018, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "./jit.hpp"
+
+#if PLORTH_ENABLE_JIT
+#if !defined(__x86_64__) || defined(_WIN32)
+# error "JIT compiler is only available on x86-64 System V platforms."
+#endif
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+
+#include "./utils.hpp"
+
+namespace plorth
+{
+  namespace jit
+  {
+    /**
+     * Each value of the quote is executed by a stub, which is called from the
+     * machine code with the context and a site which describes the value.
+     */
+    using stub = bool(*)(const std::shared_ptr<context>&, site*);
+
+    /** Maximum number of values taken by words inlined as stack shuffles. */
+    static const std::size_t max_shuffle_inputs = 4;
+
+    struct site
+    {
+      /** Machine code which the site belongs to. */
+      code* owner;
+      /** Value of the quote executed by the site. */
+      std::shared_ptr<class value> value;
+      /** Word which the symbol was resolved into, if any. */
+      std::shared_ptr<class quote> quote;
+      /** C++ function implementing the word, if it's a native word. */
+      quote::native_function function;
+      /** Type of the top-most value for words resolved from prototypes. */
+      enum value::type type;
+      /**
+       * Types of values whose prototypes contain word with the same name as
+       * the symbol, for words resolved from the global dictionary.
+       */
+      stack_effect::type_set prototypes;
+      /** Number which the symbol was resolved into, if any. */
+      std::shared_ptr<class number> number;
+    };
+
+    code::code(void* memory,
+               std::size_t size,
+               std::vector<std::unique_ptr<site>>&& sites)
+      : m_memory(memory)
+      , m_size(size)
+      , m_sites(std::move(sites))
+      , m_failures(0)
+    {
+      for (const auto& site : m_sites)
+      {
+        site->owner = this;
+      }
+    }
+
+    code::~code()
+    {
+      ::munmap(m_memory, m_size);
+    }
+
+    static inline void enter(const std::shared_ptr<context>& ctx,
+                             const site* s)
+    {
+      if (const auto position = std::static_pointer_cast<symbol>(
+        s->value
+      )->position())
+      {
+        ctx->position() = *position;
+      }
+    }
+
+    /**
+     * Executes the value with the interpreter after a guard has failed.
+     */
+    static bool deoptimize(const std::shared_ptr<context>& ctx, site* s)
+    {
+      if (s->owner->fail())
+      {
+        ++ctx->runtime()->statistics().jit_deoptimizations;
+      }
+
+      return value::exec(ctx, s->value);
+    }
+
+    static inline bool top_is(const std::shared_ptr<context>& ctx,
+                              enum value::type type)
+    {
+      const auto& stack = ctx->data();
+
+      return !stack.empty() && value::is(stack.back(), type);
+    }
+
+    static inline bool is_int(const std::shared_ptr<value>& value)
+    {
+      return value::is(value, value::type::number)
+        && std::static_pointer_cast<number>(value)->is(
+          number::number_type::integer
+        );
+    }
+
+    static inline number::int_type as_int(const std::shared_ptr<value>& value)
+    {
+      return std::static_pointer_cast<number>(value)->as_int();
+    }
+
+    /**
+     * Tests whether the symbol would be resolved from the global dictionary
+     * by the interpreter, in the current state of the context.
+     */
+    static bool resolves_globally(const std::shared_ptr<context>& ctx,
+                                  const site* s)
+    {
+      const auto& stack = ctx->data();
+      const auto sym = std::static_pointer_cast<symbol>(s->value);
+
+      if (!stack.empty() && stack.back())
+      {
+        const auto& top = stack.back();
+
+        if (top->is(value::type::object))
+        {
+          const auto& runtime = ctx->runtime();
+          const auto prototype = top->prototype(runtime);
+          std::shared_ptr<value> slot;
+
+          if (prototype && prototype->property(runtime, sym->id(), slot))
+          {
+            return false;
+          }
+        }
+        else if (s->prototypes & stack_effect::type_of(top->type()))
+        {
+          return false;
+        }
+      }
+
+      return !ctx->module_scope() && !ctx->dictionary().find(sym);
+    }
+
+    static bool stub_push(const std::shared_ptr<context>& ctx, site* s)
+    {
+      ctx->push(s->value);
+
+      return true;
+    }
+
+    static bool stub_define(const std::shared_ptr<context>& ctx, site* s)
+    {
+      ctx->dictionary().insert(std::static_pointer_cast<word>(s->value));
+
+      return true;
+    }
+
+    static bool stub_exec(const std::shared_ptr<context>& ctx, site* s)
+    {
+      return value::exec(ctx, s->value);
+    }
+
+    static bool stub_prototype(const std::shared_ptr<context>& ctx, site* s)
+    {
+      if (!top_is(ctx, s->type))
+      {
+        return deoptimize(ctx, s);
+      }
+      enter(ctx, s);
+
+      return s->quote->call(ctx);
+    }
+
+    static bool stub_prototype_native(const std::shared_ptr<context>& ctx,
+                                      site* s)
+    {
+      if (!top_is(ctx, s->type))
+      {
+        return deoptimize(ctx, s);
+      }
+      enter(ctx, s);
+      s->function(ctx);
+
+      return !ctx->error();
+    }
+
+    /**
+     * Performs arithmetic on two integers without going through the number
+     * prototype, unless the operation overflows or the values are something
+     * else than integers.
+     */
+    template<bool (*Operation)(number::int_type,
+                               number::int_type,
+                               number::int_type*)>
+    static bool stub_int_arithmetic(const std::shared_ptr<context>& ctx,
+                                    site* s)
+    {
+      auto& stack = ctx->data();
+      const auto size = stack.size();
+      number::int_type result;
+
+      if (size < 2
+          || !is_int(stack[size - 1])
+          || !is_int(stack[size - 2])
+          || !Operation(as_int(stack[size - 2]), as_int(stack[size - 1]), &result))
+      {
+        return stub_prototype_native(ctx, s);
+      }
+      enter(ctx, s);
+      stack.pop_back();
+      stack.pop_back();
+      ctx->push_int(result);
+
+      return true;
+    }
+
+    template<class Comparison>
+    static bool stub_int_comparison(const std::shared_ptr<context>& ctx,
+                                    site* s)
+    {
+      auto& stack = ctx->data();
+      const auto size = stack.size();
+      bool result;
+
+      if (size < 2 || !is_int(stack[size - 1]) || !is_int(stack[size - 2]))
+      {
+        return stub_prototype_native(ctx, s);
+      }
+      enter(ctx, s);
+      result = Comparison()(as_int(stack[size - 2]), as_int(stack[size - 1]));
+      stack.pop_back();
+      stack.pop_back();
+      ctx->push_boolean(result);
+
+      return true;
+    }
+
+    static bool int_add(number::int_type a,
+                        number::int_type b,
+                        number::int_type* result)
+    {
+      return !__builtin_add_overflow(a, b, result);
+    }
+
+    static bool int_sub(number::int_type a,
+                        number::int_type b,
+                        number::int_type* result)
+    {
+      return !__builtin_sub_overflow(a, b, result);
+    }
+
+    static bool int_mul(number::int_type a,
+                        number::int_type b,
+                        number::int_type* result)
+    {
+      return !__builtin_mul_overflow(a, b, result);
+    }
+
+    static bool stub_global(const std::shared_ptr<context>& ctx, site* s)
+    {
+      if (!resolves_globally(ctx, s))
+      {
+        return deoptimize(ctx, s);
+      }
+      enter(ctx, s);
+
+      return s->quote->call(ctx);
+    }
+
+    static bool stub_global_native(const std::shared_ptr<context>& ctx,
+                                   site* s)
+    {
+      if (!resolves_globally(ctx, s))
+      {
+        return deoptimize(ctx, s);
+      }
+      enter(ctx, s);
+      s->function(ctx);
+
+      return !ctx->error();
+    }
+
+    /**
+     * Rearranges values on top of the stack according to the stack effect of
+     * a word such as `swap` or `rot`, instead of calling the word.
+     */
+    static bool stub_shuffle(const std::shared_ptr<context>& ctx, site* s)
+    {
+      auto& stack = ctx->data();
+      const auto effect = s->quote->stack_effect();
+      const auto count = effect->inputs().size();
+      std::shared_ptr<value> taken[max_shuffle_inputs];
+      std::size_t base;
+
+      if (stack.size() < count || !resolves_globally(ctx, s))
+      {
+        return deoptimize(ctx, s);
+      }
+      enter(ctx, s);
+      base = stack.size() - count;
+      for (std::size_t i = 0; i < count; ++i)
+      {
+        taken[i] = std::move(stack[base + i]);
+      }
+      stack.resize(base);
+      for (const auto& output : effect->outputs())
+      {
+        stack.push_back(taken[output.input]);
+      }
+
+      return true;
+    }
+
+    static bool stub_number(const std::shared_ptr<context>& ctx, site* s)
+    {
+      if (!resolves_globally(ctx, s))
+      {
+        return deoptimize(ctx, s);
+      }
+      enter(ctx, s);
+      ctx->push(s->number);
+
+      return true;
+    }
+
+    static std::shared_ptr<object> prototype_of(
+      const std::shared_ptr<runtime>& runtime,
+      enum value::type type
+    )
+    {
+      switch (type)
+      {
+        case value::type::boolean:
+          return runtime->boolean_prototype();
+
+        case value::type::number:
+          return runtime->number_prototype();
+
+        case value::type::string:
+          return runtime->string_prototype();
+
+        case value::type::array:
+          return runtime->array_prototype();
+
+        case value::type::symbol:
+          return runtime->symbol_prototype();
+
+        case value::type::quote:
+          return runtime->quote_prototype();
+
+        case value::type::word:
+          return runtime->word_prototype();
+
+        case value::type::error:
+          return runtime->error_prototype();
+
+        case value::type::string_builder:
+          return runtime->string_builder_prototype();
+
+        case value::type::file:
+          return runtime->file_prototype();
+
+        case value::type::bytes:
+          return runtime->bytes_prototype();
+
+        case value::type::stream:
+          return runtime->stream_prototype();
+
+        default:
+          return runtime->object_prototype();
+      }
+    }
+
+    /**
+     * Tests whether given word of the global dictionary only rearranges
+     * values on the stack. Stack effects do not tell whether words have side
+     * effects, so the words are recognized by their names.
+     */
+    static bool is_shuffle(const std::u32string& id, const stack_effect* effect)
+    {
+      static const char32_t* shuffles[] =
+      {
+        U"drop",
+        U"2drop",
+        U"dup",
+        U"2dup",
+        U"nip",
+        U"over",
+        U"rot",
+        U"swap",
+        U"tuck"
+      };
+
+      if (!effect || effect->inputs().size() > max_shuffle_inputs)
+      {
+        return false;
+      }
+      for (const auto shuffle : shuffles)
+      {
+        if (!id.compare(shuffle))
+        {
+          return true;
+        }
+      }
+
+      return false;
+    }
+
+    /**
+     * Selects stub for symbol which was resolved into word of a prototype by
+     * the static analysis.
+     */
+    static stub prototype_stub(const std::shared_ptr<runtime>& runtime,
+                               const site& s)
+    {
+      static const struct
+      {
+        const char32_t* id;
+        stub function;
+      } integer_stubs[] =
+      {
+        { U"+", stub_int_arithmetic<int_add> },
+        { U"-", stub_int_arithmetic<int_sub> },
+        { U"*", stub_int_arithmetic<int_mul> },
+        { U"<", stub_int_comparison<std::less<number::int_type>> },
+        { U">", stub_int_comparison<std::greater<number::int_type>> },
+        { U"<=", stub_int_comparison<std::less_equal<number::int_type>> },
+        { U">=", stub_int_comparison<std::greater_equal<number::int_type>> }
+      };
+
+      if (!s.function)
+      {
+        return stub_prototype;
+      }
+      if (s.type == value::type::number)
+      {
+        for (const auto& entry : integer_stubs)
+        {
+          std::shared_ptr<value> slot;
+
+          if (runtime->number_prototype()->own_property(entry.id, slot)
+              && slot == s.quote)
+          {
+            return entry.function;
+          }
+        }
+      }
+
+      return stub_prototype_native;
+    }
+
+    /**
+     * Selects stub for symbol which was not resolved by the static analysis.
+     * Words from the global dictionary and numbers are resolved here, and
+     * guarded against words of the context and prototypes which would be
+     * resolved by the interpreter first.
+     */
+    static stub symbol_stub(const std::shared_ptr<runtime>& runtime, site& s)
+    {
+      static const enum value::type prototype_types[] =
+      {
+        value::type::boolean,
+        value::type::number,
+        value::type::string,
+        value::type::array,
+        value::type::symbol,
+        value::type::quote,
+        value::type::word,
+        value::type::error,
+        value::type::string_builder,
+        value::type::file,
+        value::type::bytes,
+        value::type::stream
+      };
+      const auto& id = std::static_pointer_cast<symbol>(s.value)->id();
+
+      // Qualified names are resolved from namespaces, which may be rebound.
+      if (id.find(':') != std::u32string::npos)
+      {
+        return stub_exec;
+      }
+
+      s.prototypes = 0;
+      for (const auto type : prototype_types)
+      {
+        if (prototype_of(runtime, type)->has_own_property(id))
+        {
+          s.prototypes |= stack_effect::type_of(type);
+        }
+      }
+
+      if (const auto word = runtime->dictionary().find(id))
+      {
+        s.quote = word->quote();
+        s.function = s.quote->function();
+        if (is_shuffle(id, s.quote->stack_effect()))
+        {
+          return stub_shuffle;
+        }
+
+        return s.function ? stub_global_native : stub_global;
+      }
+      else if (is_number(id))
+      {
+        s.number = runtime->number(id);
+
+        return stub_number;
+      }
+
+      return stub_exec;
+    }
+
+    /**
+     * Minimal x86-64 assembler for the instructions used by the machine code.
+     * The code keeps pointer to the context in `rbx` and calls stub of each
+     * value in sequence, returning false as soon as one of them fails.
+     */
+    class assembler
+    {
+    public:
+      void prologue()
+      {
+        // push rbx
+        // mov rbx, rdi
+        emit({ 0x53, 0x48, 0x89, 0xfb });
+      }
+
+      void call(stub function, site* s)
+      {
+        // mov rdi, rbx
+        emit({ 0x48, 0x89, 0xdf });
+        // mov rsi, s
+        emit({ 0x48, 0xbe });
+        emit_pointer(reinterpret_cast<std::uintptr_t>(s));
+        // mov rax, function
+        emit({ 0x48, 0xb8 });
+        emit_pointer(reinterpret_cast<std::uintptr_t>(function));
+        // call rax
+        // test al, al
+        // jz failure
+        emit({ 0xff, 0xd0, 0x84, 0xc0, 0x0f, 0x84 });
+        m_failure_jumps.push_back(m_bytes.size());
+        emit({ 0x00, 0x00, 0x00, 0x00 });
+      }
+
+      void epilogue()
+      {
+        std::size_t failure;
+
+        // mov eax, 1
+        // pop rbx
+        // ret
+        emit({ 0xb8, 0x01, 0x00, 0x00, 0x00, 0x5b, 0xc3 });
+        failure = m_bytes.size();
+        // xor eax, eax
+        // pop rbx
+        // ret
+        emit({ 0x31, 0xc0, 0x5b, 0xc3 });
+
+        for (const auto offset : m_failure_jumps)
+        {
+          const auto relative = static_cast<std::int32_t>(
+            failure - (offset + 4)
+          );
+
+          std::memcpy(&m_bytes[offset], &relative, sizeof(relative));
+        }
+      }
+
+      inline const std::vector<unsigned char>& bytes() const
+      {
+        return m_bytes;
+      }
+
+    private:
+      void emit(std::initializer_list<unsigned char> bytes)
+      {
+        m_bytes.insert(std::end(m_bytes), bytes);
+      }
+
+      void emit_pointer(std::uintptr_t pointer)
+      {
+        for (int i = 0; i < 8; ++i)
+        {
+          m_bytes.push_back(static_cast<unsigned char>(pointer >> (i * 8)));
+        }
+      }
+
+    private:
+      std::vector<unsigned char> m_bytes;
+      /** Offsets of jumps to the failure exit which need to be patched. */
+      std::vector<std::size_t> m_failure_jumps;
+    };
+
+    /**
+     * Appends machine code into map file which is read by `perf`, so that it
+     * can symbolize frames of the machine code.
+     */
+    static void write_perf_map(const void* memory,
+                               std::size_t size,
+                               const std::vector<std::shared_ptr<value>>& values)
+    {
+      char filename[64];
+      std::FILE* file;
+      std::string name = "plorth quote";
+
+      for (const auto& value : values)
+      {
+        const struct position* position;
+
+        if (value::is(value, value::type::symbol)
+            && (position = std::static_pointer_cast<symbol>(value)->position()))
+        {
+          name += " at " + utf8_encode(position->filename)
+            + ":" + std::to_string(position->line)
+            + ":" + std::to_string(position->column);
+          break;
+        }
+      }
+
+      std::snprintf(
+        filename,
+        sizeof(filename),
+        "/tmp/perf-%ld.map",
+        static_cast<long>(::getpid())
+      );
+      if ((file = std::fopen(filename, "a")))
+      {
+        std::fprintf(
+          file,
+          "%lx %lx %s\n",
+          static_cast<unsigned long>(reinterpret_cast<std::uintptr_t>(memory)),
+          static_cast<unsigned long>(size),
+          name.c_str()
+        );
+        std::fclose(file);
+      }
+    }
+
+    std::unique_ptr<code> compile(
+      const std::shared_ptr<runtime>& runtime,
+      const std::vector<std::shared_ptr<value>>& values,
+      const std::vector<stack_analysis::site>& sites
+    )
+    {
+      std::vector<std::unique_ptr<site>> compiled_sites;
+      auto analyzed = std::begin(sites);
+      assembler assembler;
+      void* memory;
+      std::size_t size;
+
+      assembler.prologue();
+      for (std::size_t i = 0; i < values.size(); ++i)
+      {
+        std::unique_ptr<site> s(new site());
+        stub function;
+
+        s->value = values[i];
+        if (analyzed != std::end(sites) && analyzed->index == i)
+        {
+          s->type = analyzed->type;
+          s->quote = analyzed->quote;
+          s->function = s->quote->function();
+          function = prototype_stub(runtime, *s);
+          ++analyzed;
+        }
+        else if (!s->value)
+        {
+          function = stub_push;
+        } else {
+          switch (s->value->type())
+          {
+            case value::type::word:
+              function = stub_define;
+              break;
+
+            case value::type::symbol:
+              function = symbol_stub(runtime, *s);
+              break;
+
+            case value::type::array:
+            case value::type::object:
+              function = stub_exec;
+              break;
+
+            default:
+              function = stub_push;
+              break;
+          }
+        }
+        assembler.call(function, s.get());
+        compiled_sites.push_back(std::move(s));
+      }
+      assembler.epilogue();
+
+      size = assembler.bytes().size();
+      memory = ::mmap(
+        nullptr,
+        size,
+        PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS,
+        -1,
+        0
+      );
+      if (memory == MAP_FAILED)
+      {
+        return std::unique_ptr<code>();
+      }
+      std::memcpy(memory, assembler.bytes().data(), size);
+      if (::mprotect(memory, size, PROT_READ | PROT_EXEC))
+      {
+        ::munmap(memory, size);
+
+        return std::unique_ptr<code>();
+      }
+      write_perf_map(memory, size, values);
+
+      return std::unique_ptr<code>(
+        new code(memory, size, std::move(compiled_sites))
+      );
+    }
+  }
+}
+#endif
@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2017-2018, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef PLORTH_JIT_HPP_GUARD
+#define PLORTH_JIT_HPP_GUARD
+
+#include <plorth/context.hpp>
+
+#if PLORTH_ENABLE_JIT
+namespace plorth
+{
+  namespace jit
+  {
+    /**
+     * Number of calls after which compiled quote is translated into machine
+     * code.
+     */
+    static const unsigned int compile_threshold = 50;
+
+    /**
+     * Number of failed guards after which machine code of a quote is
+     * discarded, and the quote is interpreted again.
+     */
+    static const unsigned int deoptimization_threshold = 100;
+
+    struct site;
+
+    /**
+     * Machine code translated from values of a compiled quote.
+     */
+    class code
+    {
+    public:
+      explicit code(void* memory,
+                    std::size_t size,
+                    std::vector<std::unique_ptr<site>>&& sites);
+      ~code();
+
+      code(const code&) = delete;
+      code& operator=(const code&) = delete;
+
+      /**
+       * Returns entry point of the machine code.
+       */
+      inline quote::native_code entry() const
+      {
+        return reinterpret_cast<quote::native_code>(m_memory);
+      }
+
+      /**
+       * Tests whether the machine code can still be used, or whether it has
+       * been deoptimized because too many guards have failed.
+       */
+      inline bool valid() const
+      {
+        return m_failures < deoptimization_threshold;
+      }
+
+      /**
+       * Records failed guard and tells whether the code was deoptimized
+       * because of it.
+       */
+      inline bool fail()
+      {
+        return ++m_failures == deoptimization_threshold;
+      }
+
+    private:
+      void* m_memory;
+      const std::size_t m_size;
+      const std::vector<std::unique_ptr<site>> m_sites;
+      unsigned int m_failures;
+    };
+
+    /**
+     * Translates values of compiled quote into machine code.
+     *
+     * \param runtime Runtime used for resolving words.
+     * \param values  Values of the compiled quote.
+     * \param sites   Symbols which were resolved into words of prototypes by
+     *                static analysis of the values.
+     * \return        Translated machine code, or null pointer if executable
+     *                memory could not be allocated.
+     */
+    std::unique_ptr<code> compile(
+      const std::shared_ptr<runtime>& runtime,
+      const std::vector<std::shared_ptr<value>>& values,
+      const std::vector<stack_analysis::site>& sites
+    );
+  }
+}
+#endif
+
+#endif /* !PLORTH_JIT_HPP_GUARD */
@@ -26,8 +26,15 @@
 #include <plorth/context.hpp>
 #include <plorth/module.hpp>
 #if PLORTH_ENABLE_FILE_SYSTEM_MODULES
+# include <plorth/parser.hpp>
 # include <climits>
+# include <deque>
 # include <fstream>
+# if PLORTH_ENABLE_THREADS
+#  include <condition_variable>
+#  include <mutex>
+#  include <thread>
+# endif
 # if HAVE_SYS_TYPES_H
 #  include <sys/types.h>
 # endif
@@ -37,17 +44,24 @@
 # if HAVE_UNISTD_H
 #  include <unistd.h>
 # endif
+# if HAVE_SYS_INOTIFY_H
+#  include <sys/inotify.h>
+# endif
 #endif
 
 #include <algorithm>
+#include <cstdlib>
 #include <cstring>
+#include <unordered_set>
 
 #include "./utils.hpp"
 
 namespace plorth
 {
-  bool runtime::import(const std::shared_ptr<class context>& context,
-                       const std::u32string& path)
+  std::shared_ptr<class object> runtime::import_module(
+    const std::shared_ptr<class context>& context,
+    const std::u32string& path
+  )
   {
     std::shared_ptr<class object> module;
 
@@ -57,7 +71,7 @@ namespace plorth
     {
       context->error(error::code::import, U"Modules have been disabled.");
 
-      return false;
+      return module;
     }
 
     // Do not attempt to import empty paths.
@@ -65,37 +79,75 @@ namespace plorth
     {
       context->error(error::code::import, U"Empty import path.");
 
-      return false;
+      return module;
+    }
+
+    if (!(module = m_module_manager->import_module(context, path))
+        && !context->error())
+    {
+      context->error(
+        error::code::import,
+        U"Unable to import from `" + path + U"`'"
+      );
     }
 
-    if ((module = m_module_manager->import_module(context, path)))
+    return module;
+  }
+
+  bool runtime::import(const std::shared_ptr<class context>& context,
+                       const std::u32string& path)
+  {
+    const auto module = import_module(context, path);
+
+    if (!module)
     {
-      auto& dictionary = context->dictionary();
+      return false;
+    }
+
+    auto& dictionary = context->dictionary();
 
-      // Transfer all exported words from the module into the calling execution
-      // context.
-      for (const auto& property : module->entries())
+    // Transfer all exported words from the module into the calling execution
+    // context.
+    module->for_each([&](const object::key_type& key,
+                         const object::mapped_type& property)
+    {
+      if (value::is(property, value::type::quote))
       {
-        if (value::is(property.second, value::type::quote))
-        {
-          dictionary.insert(word(
-            symbol(property.first),
-            std::static_pointer_cast<quote>(property.second)
-          ));
-        }
+        dictionary.insert(word(
+          symbol(key),
+          std::static_pointer_cast<quote>(property)
+        ));
       }
 
       return true;
+    });
+
+    return true;
+  }
+
+  bool runtime::import(const std::shared_ptr<class context>& context,
+                       const std::u32string& path,
+                       const std::u32string& ns)
+  {
+    std::shared_ptr<class object> module;
+
+    if (ns.empty() || !std::all_of(ns.begin(), ns.end(), unicode_isword))
+    {
+      context->error(error::code::value, U"Invalid namespace name.");
+
+      return false;
     }
-    else if (!context->error())
+
+    if (!(module = import_module(context, path)))
     {
-      context->error(
-        error::code::import,
-        U"Unable to import from `" + path + U"`'"
-      );
+      return false;
     }
 
-    return false;
+    // Words of the module are resolved from the namespace only when they
+    // are being used, so there is no need to copy them anywhere.
+    context->bind_namespace(ns, path, module);
+
+    return true;
   }
 
   namespace module
@@ -107,19 +159,67 @@ namespace plorth
     static const char file_separator = '/';
 # endif
 
-    const std::u32string manager::default_module_file_extension = U".plorth";
-
     static bool is_absolute_path(const std::u32string&);
     static std::u32string dirname(const std::u32string&);
 #endif
 
-    namespace
+    const std::u32string manager::default_module_file_extension = U".plorth";
+
+    /**
+     * Executes compiled module under new execution context and converts local
+     * dictionary of that execution context into an object.
+     *
+     * \param ctx             Execution context used for reporting errors.
+     * \param path            Path of the module.
+     * \param compiled_module Compiled source code of the module.
+     * \return                Local dictionary of the module as an object or
+     *                        null reference if an error occurred.
+     */
+    static std::shared_ptr<object> execute_module(
+      const std::shared_ptr<context>& ctx,
+      const std::u32string& path,
+      const std::shared_ptr<quote>& compiled_module
+    )
     {
+      const auto module_ctx = context::make(ctx->runtime());
+      std::vector<object::value_type> result;
+      std::shared_ptr<object> module;
+
+      // Run the module code inside new execution context.
 #if PLORTH_ENABLE_FILE_SYSTEM_MODULES
+      module_ctx->filename(path);
+#endif
+      if (!compiled_module->call(module_ctx))
+      {
+        if (module_ctx->error())
+        {
+          ctx->error(module_ctx->error());
+        }
+
+        return std::shared_ptr<object>();
+      }
+
+      // Finally convert the module into an object.
+      for (const auto& word : module_ctx->dictionary().words())
+      {
+        result.push_back({ word->symbol()->id(), word->quote() });
+      }
+      module = ctx->runtime()->object(result);
+
+      // Words of the module call each other regardless of the context they
+      // are executed in.
+      compiled_module->bind_module(module);
+
+      return module;
+    }
+
+    namespace
+    {
       /**
-       * Implementation of module manager which loads modules from file system.
+       * Base class for module managers which cache imported modules and
+       * import them again when their source code changes.
        */
-      class file_system_manager : public manager
+      class caching_manager : public manager
       {
       public:
         using module_cache_type = std::unordered_map<
@@ -127,12 +227,221 @@ namespace plorth
           std::shared_ptr<object>
         >;
 
+      protected:
+        /**
+         * Compiles and executes module from given resolved path, and places
+         * it into the module cache if successful.
+         *
+         * \param ctx  Execution context used for executing the module and
+         *             for reporting errors.
+         * \param path Resolved path of the module.
+         * \return     The module, or null reference if it could not be
+         *             imported.
+         */
+        virtual std::shared_ptr<object> import_resolved_path(
+          const std::shared_ptr<context>& ctx,
+          const std::u32string& path
+        ) = 0;
+
+        /**
+         * Called with paths of stale modules after they have been removed
+         * from the module cache, but before they are imported again.
+         */
+        virtual void prepare_reload(const std::vector<std::u32string>&) {}
+
+        /**
+         * Marks module in given path, and all modules which depend on it, to
+         * be reloaded. Modules which have not been imported are ignored.
+         */
+        void mark_stale(const std::u32string& path,
+                        std::unordered_set<std::u32string>& visited)
+        {
+          const auto dependents = m_dependents.find(path);
+
+          if (m_cache.find(path) == std::end(m_cache)
+              || !visited.insert(path).second)
+          {
+            return;
+          }
+          m_stale.insert(path);
+          if (dependents != std::end(m_dependents))
+          {
+            for (const auto& dependent : dependents->second)
+            {
+              mark_stale(dependent, visited);
+            }
+          }
+        }
+
+        /**
+         * Imports modules which have been marked as stale again. See
+         * manager::reload() for details.
+         */
+        std::size_t reload_stale(const std::shared_ptr<context>& ctx)
+        {
+          std::vector<std::u32string> stale;
+          module_cache_type previous;
+          std::size_t reloaded = 0;
+
+          if (m_stale.empty())
+          {
+            return 0;
+          }
+          stale.assign(std::begin(m_stale), std::end(m_stale));
+          m_stale.clear();
+
+          // Remove the stale modules from the cache, so that they are
+          // imported again, but keep the previous versions around in case
+          // the new versions fail to load.
+          for (const auto& path : stale)
+          {
+            const auto entry = m_cache.find(path);
+
+            if (entry != std::end(m_cache))
+            {
+              previous[path] = entry->second;
+              m_cache.erase(entry);
+            }
+          }
+          prepare_reload(stale);
+
+          // Modules which depend on other stale modules import them again
+          // when they are executed, so a module may already have been loaded
+          // by the time it's turn comes.
+          for (const auto& path : stale)
+          {
+            if (m_cache.find(path) == std::end(m_cache)
+                && !import_resolved_path(ctx, path))
+            {
+              break;
+            }
+            ++reloaded;
+          }
+
+          // Restore previous versions of modules which could not be loaded.
+          // Those which were not attempted are retried on next reload.
+          for (const auto& entry : previous)
+          {
+            if (m_cache.find(entry.first) == std::end(m_cache))
+            {
+              m_cache[entry.first] = entry.second;
+              if (reloaded < stale.size() && entry.first != stale[reloaded])
+              {
+                m_stale.insert(entry.first);
+              }
+            } else {
+              m_retired.push_back(entry.second);
+            }
+          }
+
+          if (reloaded > 0)
+          {
+            ++m_generation;
+          }
+
+          return reloaded;
+        }
+
+      protected:
+        /** Cache for already imported modules. */
+        module_cache_type m_cache;
+        /** Modules which import each module. */
+        std::unordered_map<
+          std::u32string,
+          std::unordered_set<std::u32string>
+        > m_dependents;
+        /** Modules which have been changed since they were imported. */
+        std::unordered_set<std::u32string> m_stale;
+        /**
+         * Previous versions of reloaded modules. Quotes refer to the module
+         * they belong to only weakly, so the previous versions are kept for
+         * quotes which were obtained from them before the reload.
+         */
+        std::vector<std::shared_ptr<object>> m_retired;
+      };
+
+#if PLORTH_ENABLE_FILE_SYSTEM_MODULES
+      /**
+       * Implementation of module manager which loads modules from file system.
+       */
+      class file_system_manager : public caching_manager
+      {
+      public:
+        using resolution_cache_type = std::unordered_map<
+          std::u32string,
+          std::u32string
+        >;
+
+      private:
+        /**
+         * Shared state of workers which preload modules.
+         */
+        struct preload_state
+        {
+          /** Resolved paths of modules waiting to be preloaded. */
+          std::deque<std::u32string> queue;
+          /** Resolved paths of all modules encountered so far. */
+          std::unordered_set<std::u32string> seen;
+          /** Tokens parsed from the modules which were preloaded. */
+          std::unordered_map<
+            std::u32string,
+            std::vector<std::shared_ptr<token>>
+          > results;
+          /** Number of workers currently preloading a module. */
+          std::size_t active = 0;
+#if PLORTH_ENABLE_THREADS
+          std::mutex mutex;
+          std::condition_variable condition;
+#endif
+        };
+
+      public:
         explicit file_system_manager(
           const std::vector<std::u32string>& lookup_paths,
-          const std::u32string& module_file_extension
+          const std::u32string& module_file_extension,
+          bool watch
         )
           : m_lookup_paths(lookup_paths)
-          , m_module_file_extension(utf8_encode(module_file_extension)) {}
+          , m_module_file_extension(utf8_encode(module_file_extension))
+#if HAVE_SYS_INOTIFY_H
+          , m_watch_fd(-1)
+#endif
+        {
+#if HAVE_SYS_INOTIFY_H
+          if (watch)
+          {
+            m_watch_fd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+            for (const auto& directory : m_lookup_paths)
+            {
+              watch_directory(utf8_encode(directory));
+            }
+          }
+#else
+          (void) watch;
+#endif
+        }
+
+        ~file_system_manager()
+        {
+#if PLORTH_ENABLE_THREADS
+          {
+            std::lock_guard<std::mutex> lock(m_pool_mutex);
+
+            m_pool_stopping = true;
+          }
+          m_pool_condition.notify_all();
+          for (auto& thread : m_pool)
+          {
+            thread.join();
+          }
+#endif
+#if HAVE_SYS_INOTIFY_H
+          if (m_watch_fd >= 0)
+          {
+            ::close(m_watch_fd);
+          }
+#endif
+        }
 
         std::shared_ptr<object> import_module(
           const std::shared_ptr<context>& ctx,
@@ -144,7 +453,7 @@ namespace plorth
 
           // First see if the given path actually resolves into actual file on
           // the file system.
-          if (!resolve_path(ctx, path, resolved_path))
+          if (!resolve_cached_path(ctx->filename(), path, resolved_path))
           {
             ctx->error(
               error::code::import,
@@ -154,6 +463,15 @@ namespace plorth
             return std::shared_ptr<object>();
           }
 
+#if HAVE_SYS_INOTIFY_H
+          // Keep track of modules importing other modules, so that they can
+          // be reloaded when modules they depend on change.
+          if (m_watch_fd >= 0 && !ctx->filename().empty())
+          {
+            m_dependents[resolved_path].insert(ctx->filename());
+          }
+#endif
+
           // Then look from the module cache whether the module has already
           // been imported before, and use that cached module if such exists.
           cached_module = m_cache.find(resolved_path);
@@ -166,89 +484,315 @@ namespace plorth
           return import_resolved_path(ctx, resolved_path);
         }
 
-      private:
-        /**
-         * Attempts to resolve given arbitrary path into a path that exists in
-         * the file system. If the given path seems to be an absolute path,
-         * then it will be used as is, as long as a file corresponding to that
-         * path exists in the file system. Otherwise, the list of lookup paths
-         * will be iterated and for each directory in the lookup paths tested
-         * whether a file exists under that directory that matches with the
-         * given path.
-         *
-         * \param ctx           Execution context performing the import. This
-         *                      is required for looking up directory where the
-         *                      currently executed program has been read from.
-         * \param path          Path to resolve.
-         * \param resolved_path Where the resolved path will be placed into, if
-         *                      the path was successfully resolved.
-         * \return              Boolean flag telling whether the given path was
-         *                      successfully resolved into a file or not.
-         */
-        bool resolve_path(const std::shared_ptr<context>& ctx,
-                          const std::u32string& path,
-                          std::u32string& resolved_path)
+        std::size_t preload(const std::shared_ptr<context>& ctx,
+                            const std::vector<std::u32string>& paths)
         {
-          auto encoded_path = utf8_encode(path);
-          char buffer[PATH_MAX];
+          preload_state state;
 
-          // If the path is absolute, resolve it into full path and use that
-          // directly.
-          if (is_absolute_path(path))
+          for (const auto& path : paths)
           {
-            const auto dir = utf8_encode(dirname(ctx->filename()));
+            std::u32string resolved_path;
 
-            if (!dir.empty())
+            if (resolve_cached_path(ctx->filename(), path, resolved_path))
             {
-              encoded_path = dir + file_separator + encoded_path;
-            }
-            if (!::realpath(encoded_path.c_str(), buffer))
-            {
-              // Try again with appended file extension.
-              encoded_path += m_module_file_extension;
-              if (!::realpath(encoded_path.c_str(), buffer))
-              {
-                // Give up.
-                return false;
-              }
+              enqueue(state, resolved_path);
             }
+          }
 
-            return resolve_into_file(buffer, resolved_path);
+          return run_preload(state);
+        }
+
+        void discard_preloaded(const std::shared_ptr<context>& ctx,
+                               const std::u32string& path)
+        {
+          std::u32string resolved_path;
+
+          if (resolve_cached_path(ctx->filename(), path, resolved_path))
+          {
+            m_preloaded.erase(resolved_path);
           }
+        }
 
-          // Otherwise go through the module directories and look for a
-          // matching file from each of them.
-          for (const auto& directory : m_lookup_paths)
+#if HAVE_SYS_INOTIFY_H
+        std::size_t reload(const std::shared_ptr<context>& ctx)
+        {
+          poll_watch_events();
+
+          return reload_stale(ctx);
+        }
+#endif
+
+      protected:
+        void prepare_reload(const std::vector<std::u32string>& stale)
+        {
+          preload_state state;
+
+          // Read and parse the new versions in parallel before executing any
+          // of them.
+          for (const auto& path : stale)
           {
-            std::string module_path;
+            m_preloaded.erase(path);
+            enqueue(state, path);
+          }
+          run_preload(state);
+        }
 
-            // Skip empty paths.
-            if (directory.empty() || std::all_of(directory.begin(),
-                                                 directory.end(),
-                                                 unicode_isspace))
-            {
-              continue;
-            }
+      private:
+        /**
+         * Preloads modules which have been placed into the queue of given
+         * state, and modules which they depend on.
+         */
+        std::size_t run_preload(preload_state& state)
+        {
+#if PLORTH_ENABLE_THREADS
+          if (m_pool.empty())
+          {
+            auto thread_count = std::thread::hardware_concurrency();
 
-            module_path = utf8_encode(directory);
-            if (module_path.back() != file_separator)
+            // The calling thread is also used as one of the workers.
+            if (thread_count < 2)
             {
-              module_path += file_separator;
+              thread_count = 2;
             }
-            if (!::realpath(module_path.c_str(), buffer))
+            for (unsigned int i = 1; i < thread_count; ++i)
             {
-              // Unable to locate the directory. Continue to next one.
-              continue;
+              m_pool.emplace_back(&file_system_manager::pool_worker, this);
             }
+          }
+          {
+            std::lock_guard<std::mutex> lock(m_pool_mutex);
 
-            // Append the filename into the module directory path and try
-            // whether that one exists or not.
-            module_path = buffer;
-            if (module_path.back() != file_separator)
+            m_pool_job = &state;
+            ++m_pool_generation;
+          }
+          m_pool_condition.notify_all();
+#endif
+          preload_worker(state);
+#if PLORTH_ENABLE_THREADS
+          {
+            std::unique_lock<std::mutex> lock(m_pool_mutex);
+
+            // Threads which wake up after this no longer see the state, as
+            // it goes out of scope once this method returns.
+            m_pool_condition.wait(lock, [this]()
             {
-              module_path += file_separator;
-            }
-            module_path += encoded_path;
+              return !m_pool_busy;
+            });
+            m_pool_job = nullptr;
+          }
+#endif
+
+          for (auto& entry : state.results)
+          {
+            m_preloaded[entry.first] = std::move(entry.second);
+          }
+
+          return state.results.size();
+        }
+
+        /**
+         * Resolves given path just like resolve_path() does, but uses results
+         * of previous resolutions when the same path has already been
+         * resolved from the same directory. Paths which cannot be resolved
+         * are not cached.
+         *
+         * If watching of the file system has been enabled, all cached results
+         * are discarded whenever files are created, removed or renamed in
+         * directories which contain resolved modules.
+         */
+        bool resolve_cached_path(const std::u32string& filename,
+                                 const std::u32string& path,
+                                 std::u32string& resolved_path)
+        {
+          // Paths which are resolved from the lookup paths do not depend on
+          // the directory of the importing file.
+          const auto key = (is_absolute_path(path) ? dirname(filename) : U"")
+            + U'\0'
+            + path;
+          resolution_cache_type::const_iterator entry;
+
+#if HAVE_SYS_INOTIFY_H
+          poll_watch_events();
+#endif
+          entry = m_resolution_cache.find(key);
+          if (entry != std::end(m_resolution_cache))
+          {
+            resolved_path = entry->second;
+
+            return true;
+          }
+          if (!resolve_path(filename, path, resolved_path))
+          {
+            return false;
+          }
+          m_resolution_cache[key] = resolved_path;
+#if HAVE_SYS_INOTIFY_H
+          watch_directory(utf8_encode(dirname(resolved_path)));
+#endif
+
+          return true;
+        }
+
+#if HAVE_SYS_INOTIFY_H
+        /**
+         * Starts watching given directory for changes, if watching of the
+         * file system has been enabled.
+         */
+        void watch_directory(const std::string& path)
+        {
+          int wd;
+
+          if (m_watch_fd < 0
+              || path.empty()
+              || m_watched.find(path) != std::end(m_watched))
+          {
+            return;
+          }
+          wd = ::inotify_add_watch(
+            m_watch_fd,
+            path.c_str(),
+            IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO
+              | IN_DELETE_SELF | IN_MOVE_SELF | IN_CLOSE_WRITE
+          );
+          if (wd >= 0)
+          {
+            m_watched[path] = wd;
+            m_watched_directories[wd] = path;
+          }
+        }
+
+        /**
+         * Reads pending events from the file system watcher without blocking.
+         * The resolution cache is discarded if files have been added or
+         * removed, and imported modules which have been changed are marked
+         * to be reloaded.
+         */
+        void poll_watch_events()
+        {
+          alignas(struct ::inotify_event) char buffer[4096];
+          bool structure_changed = false;
+          ssize_t length;
+
+          if (m_watch_fd < 0)
+          {
+            return;
+          }
+          while ((length = ::read(m_watch_fd, buffer, sizeof(buffer))) > 0)
+          {
+            for (auto p = buffer; p < buffer + length;)
+            {
+              const auto event = reinterpret_cast<const struct ::inotify_event*>(
+                p
+              );
+              const auto directory = m_watched_directories.find(event->wd);
+
+              p += sizeof(struct ::inotify_event) + event->len;
+              if (event->mask & ~(IN_CLOSE_WRITE | IN_IGNORED))
+              {
+                structure_changed = true;
+              }
+              if (event->len > 0
+                  && directory != std::end(m_watched_directories)
+                  && (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE)))
+              {
+                std::unordered_set<std::u32string> visited;
+
+                mark_stale(
+                  utf8_decode(directory->second + file_separator + event->name),
+                  visited
+                );
+              }
+            }
+          }
+          if (structure_changed)
+          {
+            m_resolution_cache.clear();
+          }
+        }
+#endif
+
+        /**
+         * Attempts to resolve given arbitrary path into a path that exists in
+         * the file system. If the given path seems to be an absolute path,
+         * then it will be used as is, as long as a file corresponding to that
+         * path exists in the file system. Otherwise, the list of lookup paths
+         * will be iterated and for each directory in the lookup paths tested
+         * whether a file exists under that directory that matches with the
+         * given path.
+         *
+         * \param filename      Filename of the program performing the import.
+         *                      This is required for looking up directory
+         *                      where the program has been read from.
+         * \param path          Path to resolve.
+         * \param resolved_path Where the resolved path will be placed into, if
+         *                      the path was successfully resolved.
+         * \return              Boolean flag telling whether the given path was
+         *                      successfully resolved into a file or not.
+         */
+        bool resolve_path(const std::u32string& filename,
+                          const std::u32string& path,
+                          std::u32string& resolved_path) const
+        {
+          auto encoded_path = utf8_encode(path);
+          char buffer[PATH_MAX];
+
+          // If the path is absolute, resolve it into full path and use that
+          // directly.
+          if (is_absolute_path(path))
+          {
+            const auto dir = utf8_encode(dirname(filename));
+
+            if (!dir.empty())
+            {
+              encoded_path = dir + file_separator + encoded_path;
+            }
+            if (!::realpath(encoded_path.c_str(), buffer))
+            {
+              // Try again with appended file extension.
+              encoded_path += m_module_file_extension;
+              if (!::realpath(encoded_path.c_str(), buffer))
+              {
+                // Give up.
+                return false;
+              }
+            }
+
+            return resolve_into_file(buffer, resolved_path);
+          }
+
+          // Otherwise go through the module directories and look for a
+          // matching file from each of them.
+          for (const auto& directory : m_lookup_paths)
+          {
+            std::string module_path;
+
+            // Skip empty paths.
+            if (directory.empty() || std::all_of(directory.begin(),
+                                                 directory.end(),
+                                                 unicode_isspace))
+            {
+              continue;
+            }
+
+            module_path = utf8_encode(directory);
+            if (module_path.back() != file_separator)
+            {
+              module_path += file_separator;
+            }
+            if (!::realpath(module_path.c_str(), buffer))
+            {
+              // Unable to locate the directory. Continue to next one.
+              continue;
+            }
+
+            // Append the filename into the module directory path and try
+            // whether that one exists or not.
+            module_path = buffer;
+            if (module_path.back() != file_separator)
+            {
+              module_path += file_separator;
+            }
+            module_path += encoded_path;
             if (!::realpath(module_path.c_str(), buffer))
             {
               // Try again with appended file extension.
@@ -289,7 +833,7 @@ namespace plorth
          *                      successfully resolved into a file or not.
          */
         bool resolve_into_file(const std::string& path,
-                               std::u32string& resolved_path)
+                               std::u32string& resolved_path) const
         {
           struct ::stat st;
 
@@ -351,81 +895,506 @@ namespace plorth
           const std::u32string& path
         )
         {
-          std::ifstream is(utf8_encode(path));
+          std::ifstream is;
           std::string raw_source;
           std::u32string source;
           std::shared_ptr<quote> compiled_module;
-          std::shared_ptr<context> module_ctx;
-          std::vector<object::value_type> result;
           std::shared_ptr<object> module;
+          const auto preloaded = m_preloaded.find(path);
 
-          if (!is.good())
+          // Use the tokens parsed by preloading, if the module has been
+          // preloaded.
+          if (preloaded != std::end(m_preloaded))
           {
-            ctx->error(
-              error::code::import,
-              U"Unable to import from `" + path + U"'"
+            compiled_module = ctx->compile(preloaded->second);
+            m_preloaded.erase(preloaded);
+          } else {
+            is.open(utf8_encode(path));
+            if (!is.good())
+            {
+              ctx->error(
+                error::code::import,
+                U"Unable to import from `" + path + U"'"
+              );
+
+              return std::shared_ptr<object>();
+            }
+
+            raw_source = std::string(
+              std::istreambuf_iterator<char>(is),
+              std::istreambuf_iterator<char>()
             );
+            is.close();
 
-            return std::shared_ptr<object>();
+            // First decode the source code with UTF-8 character encoding.
+            if (!utf8_decode_test(raw_source, source))
+            {
+              ctx->error(
+                error::code::import,
+                U"Unable to decode source code into UTF-8."
+              );
+
+              return std::shared_ptr<object>();
+            }
+
+            // Then attempt to compile it.
+            if (!(compiled_module = ctx->compile(source, path)))
+            {
+              return std::shared_ptr<object>();
+            }
           }
 
+          if ((module = execute_module(ctx, path, compiled_module)))
+          {
+            m_cache[path] = module;
+          }
+
+          return module;
+        }
+
+      private:
+        /**
+         * Adds module to the queue of modules to be preloaded, unless it has
+         * already been encountered or imported.
+         */
+        void enqueue(preload_state& state, const std::u32string& path) const
+        {
+          if (m_cache.find(path) == std::end(m_cache)
+              && m_preloaded.find(path) == std::end(m_preloaded)
+              && state.seen.insert(path).second)
+          {
+            state.queue.push_back(path);
+          }
+        }
+
+#if PLORTH_ENABLE_THREADS
+        /**
+         * Main loop of threads in the pool, which wait for preloads to be
+         * started and then help with them.
+         */
+        void pool_worker()
+        {
+          unsigned long generation = 0;
+
+          for (;;)
+          {
+            preload_state* job;
+
+            {
+              std::unique_lock<std::mutex> lock(m_pool_mutex);
+
+              m_pool_condition.wait(lock, [this, &generation]()
+              {
+                return m_pool_stopping || m_pool_generation != generation;
+              });
+              if (m_pool_stopping)
+              {
+                return;
+              }
+              generation = m_pool_generation;
+              if (!(job = m_pool_job))
+              {
+                continue;
+              }
+              ++m_pool_busy;
+            }
+            preload_worker(*job);
+            {
+              std::lock_guard<std::mutex> lock(m_pool_mutex);
+
+              --m_pool_busy;
+            }
+            m_pool_condition.notify_all();
+          }
+        }
+#endif
+
+        /**
+         * Takes modules from the queue and preloads them until the queue is
+         * empty and no other worker can add more modules into it.
+         */
+        void preload_worker(preload_state& state) const
+        {
+          for (;;)
+          {
+            std::u32string path;
+            std::vector<std::shared_ptr<token>> tokens;
+            std::vector<std::u32string> dependencies;
+            bool success;
+
+            {
+#if PLORTH_ENABLE_THREADS
+              std::unique_lock<std::mutex> lock(state.mutex);
+
+              state.condition.wait(lock, [&state]()
+              {
+                return !state.queue.empty() || !state.active;
+              });
+#endif
+              if (state.queue.empty())
+              {
+                return;
+              }
+              path = state.queue.front();
+              state.queue.pop_front();
+              ++state.active;
+            }
+
+            if ((success = parse_file(path, tokens)))
+            {
+              scan_dependencies(tokens, dependencies);
+            }
+
+            {
+#if PLORTH_ENABLE_THREADS
+              std::lock_guard<std::mutex> lock(state.mutex);
+#endif
+
+              if (success)
+              {
+                for (const auto& dependency : dependencies)
+                {
+                  std::u32string resolved_path;
+
+                  if (resolve_path(path, dependency, resolved_path))
+                  {
+                    enqueue(state, resolved_path);
+                  }
+                }
+                state.results[path] = std::move(tokens);
+              }
+              --state.active;
+            }
+#if PLORTH_ENABLE_THREADS
+            state.condition.notify_all();
+#endif
+          }
+        }
+
+        /**
+         * Reads, decodes and parses source code of a module without
+         * constructing any values, which allows it to be done outside the
+         * thread which executes the program.
+         */
+        static bool parse_file(const std::u32string& path,
+                               std::vector<std::shared_ptr<token>>& tokens)
+        {
+          std::ifstream is(utf8_encode(path));
+          std::string raw_source;
+          std::u32string source;
+
+          if (!is.good())
+          {
+            return false;
+          }
           raw_source = std::string(
             std::istreambuf_iterator<char>(is),
             std::istreambuf_iterator<char>()
           );
           is.close();
 
-          // First decode the source code with UTF-8 character encoding.
-          if (!utf8_decode_test(raw_source, source))
+          return utf8_decode_test(raw_source, source)
+            && parser(source, path, 1, 1).parse(tokens);
+        }
+
+        /**
+         * Scans parsed source code for literal imports, such as
+         * `"path" import` or `"path" "ns" import-as`, and collects the paths
+         * of the imported modules.
+         */
+        static void scan_dependencies(
+          const std::vector<std::shared_ptr<token>>& tokens,
+          std::vector<std::u32string>& dependencies
+        )
+        {
+          const auto size = tokens.size();
+
+          for (std::size_t i = 0; i < size; ++i)
+          {
+            const auto& token = tokens[i];
+
+            if (token->type() == token::type::quote)
+            {
+              scan_dependencies(
+                std::static_pointer_cast<token::quote>(token)->children(),
+                dependencies
+              );
+            }
+            else if (token->type() == token::type::word)
+            {
+              scan_dependencies(
+                std::static_pointer_cast<token::word>(token)->quote()
+                  ->children(),
+                dependencies
+              );
+            }
+            else if (token->type() == token::type::symbol && i > 0)
+            {
+              const auto& id = std::static_pointer_cast<token::symbol>(
+                token
+              )->id();
+              std::size_t path_index;
+
+              if (!id.compare(U"import"))
+              {
+                path_index = i - 1;
+              }
+              else if (!id.compare(U"import-as") && i > 1)
+              {
+                path_index = i - 2;
+              } else {
+                continue;
+              }
+              if (tokens[path_index]->type() == token::type::string)
+              {
+                dependencies.push_back(std::static_pointer_cast<token::string>(
+                  tokens[path_index]
+                )->value());
+              }
+            }
+          }
+        }
+
+      private:
+        /** List of directories to look for modules. */
+        const std::vector<std::u32string> m_lookup_paths;
+        /** What file extension should be considered to be a module. */
+        const std::string m_module_file_extension;
+        /** Cache for already resolved paths. */
+        resolution_cache_type m_resolution_cache;
+#if HAVE_SYS_INOTIFY_H
+        /** inotify instance used to watch the file system, or -1 if none. */
+        int m_watch_fd;
+        /** Watch descriptors of directories which are being watched. */
+        std::unordered_map<std::string, int> m_watched;
+        /** Directories which are being watched, by watch descriptor. */
+        std::unordered_map<int, std::string> m_watched_directories;
+#endif
+        /** Parsed modules which have been preloaded but not imported yet. */
+        std::unordered_map<
+          std::u32string,
+          std::vector<std::shared_ptr<token>>
+        > m_preloaded;
+#if PLORTH_ENABLE_THREADS
+        /**
+         * Threads which help with preloading. Started on first preload and
+         * kept running until the manager is destroyed.
+         */
+        std::vector<std::thread> m_pool;
+        std::mutex m_pool_mutex;
+        std::condition_variable m_pool_condition;
+        /** Preload the threads in the pool should help with, if any. */
+        preload_state* m_pool_job = nullptr;
+        /** Incremented each time a preload is started. */
+        unsigned long m_pool_generation = 0;
+        /** Number of threads in the pool currently helping with a preload. */
+        std::size_t m_pool_busy = 0;
+        bool m_pool_stopping = false;
+#endif
+      };
+#endif
+
+      /**
+       * Implementation of module manager which loads modules from source code
+       * stored in memory. Paths of the modules use `/` as separator and are
+       * resolved from the root directory, unless they begin with `./` or
+       * `../` in which case they are resolved relative to the importing
+       * module.
+       */
+      class virtual_file_system_manager : public caching_manager
+      {
+      public:
+        explicit virtual_file_system_manager(
+          const file_container_type& files,
+          const std::u32string& module_file_extension
+        )
+          : m_module_file_extension(module_file_extension)
+        {
+          for (const auto& file : files)
+          {
+            m_files[normalize_path(file.first)] = file.second;
+          }
+        }
+
+        std::shared_ptr<object> import_module(
+          const std::shared_ptr<context>& ctx,
+          const std::u32string& path
+        )
+        {
+          file_container_type::const_iterator file;
+          std::u32string resolved_path;
+          std::shared_ptr<object> module;
+
+          if (!resolve_path(ctx, path, file))
           {
             ctx->error(
               error::code::import,
-              U"Unable to decode source code into UTF-8."
+              U"No such file or directory: " + path
             );
 
-            return std::shared_ptr<object>();
+            return module;
           }
+          resolved_path = file->first;
 
-          // Then attempt to compile it.
-          if (!(compiled_module = ctx->compile(source, path)))
+#if PLORTH_ENABLE_FILE_SYSTEM_MODULES
+          // Keep track of modules importing other modules, so that they can
+          // be reloaded when modules they depend on change.
+          if (!ctx->filename().empty())
           {
-            return std::shared_ptr<object>();
+            m_dependents[resolved_path].insert(ctx->filename());
+          }
+#endif
+
+          // Look from the module cache whether the module has already been
+          // imported before.
+          const auto cached_module = m_cache.find(resolved_path);
+
+          if (cached_module != std::end(m_cache))
+          {
+            return cached_module->second;
+          }
+
+          return import_resolved_path(ctx, resolved_path);
+        }
+
+        bool write_file(const std::u32string& path,
+                        const std::u32string& source)
+        {
+          const auto normalized_path = normalize_path(path);
+          std::unordered_set<std::u32string> visited;
+
+          m_files[normalized_path] = source;
+          mark_stale(normalized_path, visited);
+
+          return true;
+        }
+
+        std::size_t reload(const std::shared_ptr<context>& ctx)
+        {
+          return reload_stale(ctx);
+        }
+
+      protected:
+        std::shared_ptr<object> import_resolved_path(
+          const std::shared_ptr<context>& ctx,
+          const std::u32string& path
+        )
+        {
+          const auto file = m_files.find(path);
+          std::shared_ptr<quote> compiled_module;
+          std::shared_ptr<object> module;
+
+          if (file == std::end(m_files))
+          {
+            ctx->error(
+              error::code::import,
+              U"Unable to import from `" + path + U"'"
+            );
+          }
+          else if ((compiled_module = ctx->compile(file->second, path))
+                   && (module = execute_module(ctx, path, compiled_module)))
+          {
+            m_cache[path] = module;
           }
 
-          // Run the module code inside new execution context.
-          module_ctx = context::make(ctx->runtime());
-          module_ctx->filename(path);
-          if (!compiled_module->call(module_ctx))
+          return module;
+        }
+
+      private:
+        /**
+         * Resolves given path into one of the files. The path is tried as it
+         * is, then with module file extension appended and finally as a
+         * directory containing an index file.
+         */
+        bool resolve_path(const std::shared_ptr<context>& ctx,
+                          const std::u32string& path,
+                          file_container_type::const_iterator& file) const
+        {
+          std::u32string full_path = path;
+
+          if (!path.compare(0, 2, U"./") || !path.compare(0, 3, U"../"))
           {
-            if (module_ctx->error())
+            std::u32string directory = U"/";
+#if PLORTH_ENABLE_FILE_SYSTEM_MODULES
+            const auto& filename = ctx->filename();
+            const auto index = filename.find_last_of('/');
+
+            if (index != std::u32string::npos)
             {
-              ctx->error(module_ctx->error());
+              directory = filename.substr(0, index + 1);
             }
+#else
+            (void) ctx;
+#endif
+            full_path = directory + path;
+          }
+          full_path = normalize_path(full_path);
 
-            return std::shared_ptr<object>();
+          for (const auto& candidate : {
+            full_path,
+            full_path + m_module_file_extension,
+            full_path + U"/index" + m_module_file_extension
+          })
+          {
+            if ((file = m_files.find(candidate)) != std::end(m_files))
+            {
+              return true;
+            }
           }
 
-          // Finally convert the module into an object.
-          for (const auto& word : module_ctx->dictionary().words())
+          return false;
+        }
+
+        /**
+         * Converts given path into an absolute path without empty, `.` or
+         * `..` components.
+         */
+        static std::u32string normalize_path(const std::u32string& path)
+        {
+          std::vector<std::u32string> components;
+          std::u32string::size_type start = 0;
+          std::u32string result;
+
+          while (start <= path.length())
           {
-            result.push_back({ word->symbol()->id(), word->quote() });
+            auto end = path.find('/', start);
+
+            if (end == std::u32string::npos)
+            {
+              end = path.length();
+            }
+
+            const auto component = path.substr(start, end - start);
+
+            if (!component.compare(U".."))
+            {
+              if (!components.empty())
+              {
+                components.pop_back();
+              }
+            }
+            else if (!component.empty() && component.compare(U"."))
+            {
+              components.push_back(component);
+            }
+            start = end + 1;
           }
 
-          module = ctx->runtime()->object(result);
-          m_cache[path] = module;
+          for (const auto& component : components)
+          {
+            result += '/';
+            result += component;
+          }
 
-          return module;
+          return result.empty() ? U"/" : result;
         }
 
       private:
-        /** List of directories to look for modules. */
-        const std::vector<std::u32string> m_lookup_paths;
         /** What file extension should be considered to be a module. */
-        const std::string m_module_file_extension;
-        /** Cache for already imported modules. */
-        module_cache_type m_cache;
+        const std::u32string m_module_file_extension;
+        /** Source code of the modules, keyed by normalized path. */
+        file_container_type m_files;
       };
-#endif
 
       /**
        * Implementation of module manager which is unable to load any kind of
@@ -445,19 +1414,104 @@ namespace plorth
     std::shared_ptr<manager> manager::file_system(
       memory::manager& memory_manager,
       const std::vector<std::u32string>& lookup_paths,
-      const std::u32string& module_file_extension
+      const std::u32string& module_file_extension,
+      bool watch
     )
     {
 #if PLORTH_ENABLE_FILE_SYSTEM_MODULES
       return std::shared_ptr<manager>(new (memory_manager) file_system_manager(
         lookup_paths,
-        module_file_extension
+        module_file_extension,
+        watch
       ));
 #else
       return dummy(memory_manager);
 #endif
     }
 
+    std::vector<std::u32string> manager::default_lookup_paths()
+    {
+#if defined(_WIN32)
+      static const char path_separator = ';';
+#else
+      static const char path_separator = ':';
+#endif
+      std::vector<std::u32string> lookup_paths;
+      auto begin = std::getenv("PLORTHPATH");
+      auto end = begin;
+
+      if (end)
+      {
+        for (; *end; ++end)
+        {
+          if (*end != path_separator)
+          {
+            continue;
+          }
+
+          if (end - begin > 0)
+          {
+            lookup_paths.push_back(utf8_decode(
+              std::string(begin, end - begin)
+            ));
+          }
+          begin = end + 1;
+        }
+
+        if (end - begin > 0)
+        {
+          lookup_paths.push_back(utf8_decode(
+            std::string(begin, end - begin)
+          ));
+        }
+      }
+
+#if defined(PLORTH_RUNTIME_LIBRARY_PATH)
+      if (lookup_paths.empty())
+      {
+        lookup_paths.push_back(PLORTH_RUNTIME_LIBRARY_PATH);
+      }
+#endif
+
+      return lookup_paths;
+    }
+
+    std::shared_ptr<manager> manager::virtual_file_system(
+      memory::manager& memory_manager,
+      const file_container_type& files,
+      const std::u32string& module_file_extension
+    )
+    {
+      return std::shared_ptr<manager>(
+        new (memory_manager) virtual_file_system_manager(
+          files,
+          module_file_extension
+        )
+      );
+    }
+
+    manager::manager()
+      : m_generation(0) {}
+
+    std::size_t manager::preload(const std::shared_ptr<context>&,
+                                 const std::vector<std::u32string>&)
+    {
+      return 0;
+    }
+
+    void manager::discard_preloaded(const std::shared_ptr<context>&,
+                                    const std::u32string&) {}
+
+    std::size_t manager::reload(const std::shared_ptr<context>&)
+    {
+      return 0;
+    }
+
+    bool manager::write_file(const std::u32string&, const std::u32string&)
+    {
+      return false;
+    }
+
     std::shared_ptr<manager> manager::dummy(memory::manager& memory_manager)
     {
       return std::shared_ptr<manager>(new (memory_manager) dummy_manager());
@@ -337,6 +337,16 @@ namespace plorth
     do
     {
       buffer.append(1, read());
+
+      // Allow single colon inside a symbol, which separates namespace from
+      // name of the word, such as `math:range`.
+      if (peek(':')
+          && m_pos + 1 < m_end
+          && unicode_isword(*(m_pos + 1))
+          && buffer.find(':') == std::u32string::npos)
+      {
+        buffer.append(1, read());
+      }
     }
     while (!eof() && unicode_isword(peek()));
 
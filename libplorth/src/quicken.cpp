@@ -0,0 +1,470 @@
+/*
+ * Copyright (c) 2017-2018, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "./quicken.hpp"
+
+#include <functional>
+
+namespace plorth
+{
+  namespace quicken
+  {
+    /**
+     * Categories of operand pairs observed by the call sites.
+     */
+    enum class operands
+    {
+      integers,
+      reals,
+      strings,
+      arrays,
+      others
+    };
+
+    static const struct
+    {
+      const char32_t* name;
+      enum operation operation;
+    } operation_names[] =
+    {
+      { U"+", operation::add },
+      { U"-", operation::subtract },
+      { U"*", operation::multiply },
+      { U"<", operation::less_than },
+      { U">", operation::greater_than },
+      { U"<=", operation::less_than_or_equal },
+      { U">=", operation::greater_than_or_equal },
+      { U"=", operation::equal },
+      { U"!=", operation::not_equal }
+    };
+
+    std::vector<site> find(const std::vector<std::shared_ptr<value>>& values)
+    {
+      std::vector<site> sites;
+
+      for (std::size_t i = 0; i < values.size(); ++i)
+      {
+        if (!value::is(values[i], value::type::symbol))
+        {
+          continue;
+        }
+
+        const auto& id = std::static_pointer_cast<symbol>(values[i])->id();
+
+        for (const auto& entry : operation_names)
+        {
+          if (!id.compare(entry.name))
+          {
+            site s;
+
+            s.index = i;
+            s.operation = entry.operation;
+            s.form = form::unobserved;
+            s.function = nullptr;
+            s.dictionary_version = 0;
+            s.shadowed = false;
+            sites.push_back(s);
+            break;
+          }
+        }
+      }
+
+      return sites;
+    }
+
+    static inline bool is_equality(enum operation operation)
+    {
+      return operation == operation::equal
+        || operation == operation::not_equal;
+    }
+
+    static enum operands classify(const std::shared_ptr<value>& a,
+                                  const std::shared_ptr<value>& b)
+    {
+      if (!a || !b || a->type() != b->type())
+      {
+        return operands::others;
+      }
+      switch (a->type())
+      {
+        case value::type::number:
+          if (std::static_pointer_cast<number>(a)->is(number::number_type::integer)
+              && std::static_pointer_cast<number>(b)->is(number::number_type::integer))
+          {
+            return operands::integers;
+          }
+
+          return operands::reals;
+
+        case value::type::string:
+          return operands::strings;
+
+        case value::type::array:
+          return operands::arrays;
+
+        default:
+          return operands::others;
+      }
+    }
+
+    /**
+     * Tests whether the observed operands match the form of the site.
+     */
+    static inline bool matches(enum form form, enum operands operands)
+    {
+      switch (form)
+      {
+        case form::integers:
+          return operands == operands::integers;
+
+        case form::reals:
+          return operands == operands::reals;
+
+        case form::strings:
+          return operands == operands::strings;
+
+        case form::arrays:
+          return operands == operands::arrays;
+
+        default:
+          return false;
+      }
+    }
+
+    static void count(site& s, enum operands operands)
+    {
+      auto& profile = *s.profile;
+
+      switch (operands)
+      {
+        case operands::integers:
+          ++profile.integers;
+          break;
+
+        case operands::reals:
+          ++profile.reals;
+          break;
+
+        case operands::strings:
+          ++profile.strings;
+          break;
+
+        case operands::arrays:
+          ++profile.arrays;
+          break;
+
+        case operands::others:
+          ++profile.others;
+          break;
+      }
+    }
+
+    /**
+     * Looks up native word which implements addition from prototype of the
+     * given type. Returns null pointer if there is no such word, or if the
+     * word has not been implemented in C++.
+     */
+    static quote::native_function prototype_function(
+      const std::shared_ptr<class runtime>& runtime,
+      const std::shared_ptr<object>& prototype,
+      const symbol* sym
+    )
+    {
+      std::shared_ptr<value> slot;
+
+      if (!prototype
+          || !prototype->property(runtime, sym->id(), slot)
+          || !value::is(slot, value::type::quote))
+      {
+        return nullptr;
+      }
+
+      return std::static_pointer_cast<quote>(slot)->function();
+    }
+
+    /**
+     * Selects form for the site, based on the operands observed on the first
+     * execution.
+     */
+    static enum form rewrite(const std::shared_ptr<context>& ctx,
+                             const symbol* sym,
+                             site& s,
+                             enum operands operands)
+    {
+      const auto& runtime = ctx->runtime();
+
+      switch (operands)
+      {
+        case operands::integers:
+        case operands::reals:
+          // The equality words are global words, so they are only quickened
+          // when the number prototype does not contain word with the same
+          // name.
+          if (is_equality(s.operation)
+              && runtime->number_prototype()->has_own_property(sym->id()))
+          {
+            return form::generic;
+          }
+
+          return operands == operands::integers ? form::integers : form::reals;
+
+        case operands::strings:
+        case operands::arrays:
+          if (s.operation != operation::add)
+          {
+            return form::generic;
+          }
+          s.function = prototype_function(
+            runtime,
+            operands == operands::strings
+              ? runtime->string_prototype()
+              : runtime->array_prototype(),
+            sym
+          );
+          if (!s.function)
+          {
+            return form::generic;
+          }
+
+          return operands == operands::strings ? form::strings : form::arrays;
+
+        default:
+          return form::generic;
+      }
+    }
+
+    /**
+     * Tests whether the global equality word would be resolved by the
+     * interpreter, in the current state of the context.
+     */
+    static bool resolves_globally(const std::shared_ptr<context>& ctx,
+                                  const symbol* sym,
+                                  site& s)
+    {
+      const auto& dictionary = ctx->dictionary();
+
+      if (ctx->module_scope())
+      {
+        return false;
+      }
+      if (s.dictionary_version != dictionary.version())
+      {
+        s.shadowed = !!dictionary.find(sym->id());
+        s.dictionary_version = dictionary.version();
+      }
+
+      return !s.shadowed;
+    }
+
+    template<class T>
+    static bool compare(enum operation operation, T a, T b)
+    {
+      switch (operation)
+      {
+        case operation::less_than:
+          return a < b;
+
+        case operation::greater_than:
+          return a > b;
+
+        case operation::less_than_or_equal:
+          return a <= b;
+
+        case operation::greater_than_or_equal:
+          return a >= b;
+
+        case operation::equal:
+          return a == b;
+
+        default:
+          return a != b;
+      }
+    }
+
+    static inline bool is_arithmetic(enum operation operation)
+    {
+      return operation == operation::add
+        || operation == operation::subtract
+        || operation == operation::multiply;
+    }
+
+    /**
+     * Performs checked integer arithmetic. Returns false if the operation
+     * overflows, in which case the result is left to the number prototype to
+     * promote into real number.
+     */
+    static bool int_arithmetic(enum operation operation,
+                               number::int_type a,
+                               number::int_type b,
+                               number::int_type& result)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+      switch (operation)
+      {
+        case operation::add:
+          return !__builtin_add_overflow(a, b, &result);
+
+        case operation::subtract:
+          return !__builtin_sub_overflow(a, b, &result);
+
+        default:
+          return !__builtin_mul_overflow(a, b, &result);
+      }
+#else
+      // Without overflow checking builtins, leave the arithmetic to the number
+      // prototype.
+      return false;
+#endif
+    }
+
+    static number::real_type real_arithmetic(enum operation operation,
+                                             number::real_type a,
+                                             number::real_type b)
+    {
+      switch (operation)
+      {
+        case operation::add:
+          return a + b;
+
+        case operation::subtract:
+          return a - b;
+
+        default:
+          return a * b;
+      }
+    }
+
+    bool execute(const std::shared_ptr<context>& ctx,
+                 const std::shared_ptr<value>& val,
+                 site& s)
+    {
+      const auto sym = static_cast<const symbol*>(val.get());
+      auto& stack = ctx->data();
+      const auto size = stack.size();
+      enum operands operands;
+
+      if (s.form == form::generic && !s.profile)
+      {
+        return value::exec(ctx, val);
+      }
+
+      operands = size < 2
+        ? operands::others
+        : classify(stack[size - 2], stack[size - 1]);
+
+      if (s.form == form::unobserved)
+      {
+        auto& statistics = ctx->runtime()->statistics();
+
+        s.form = rewrite(ctx, sym, s, operands);
+        if (statistics.profile_sites)
+        {
+          const auto position = sym->position();
+
+          s.profile = std::make_shared<runtime::statistics::site_profile>();
+          s.profile->word = sym->id();
+          s.profile->has_position = !!position;
+          if (position)
+          {
+            s.profile->position = *position;
+          }
+          statistics.site_profiles.push_back(s.profile);
+        }
+      }
+
+      if (s.profile)
+      {
+        count(s, operands);
+      }
+
+      if (s.form == form::generic)
+      {
+        return value::exec(ctx, val);
+      }
+      else if (!matches(s.form, operands))
+      {
+        s.form = form::generic;
+
+        return value::exec(ctx, val);
+      }
+      else if (is_equality(s.operation) && !resolves_globally(ctx, sym, s))
+      {
+        return value::exec(ctx, val);
+      }
+
+      if (const auto position = sym->position())
+      {
+        ctx->position() = *position;
+      }
+
+      if (s.form == form::strings || s.form == form::arrays)
+      {
+        s.function(ctx);
+
+        return !ctx->error();
+      }
+
+      const auto a = static_cast<const number*>(stack[size - 2].get());
+      const auto b = static_cast<const number*>(stack[size - 1].get());
+
+      if (s.form == form::integers)
+      {
+        const auto x = a->as_int();
+        const auto y = b->as_int();
+
+        if (is_arithmetic(s.operation))
+        {
+          number::int_type result;
+
+          if (!int_arithmetic(s.operation, x, y, result))
+          {
+            return value::exec(ctx, val);
+          }
+          stack.pop_back();
+          stack.pop_back();
+          ctx->push_int(result);
+        } else {
+          stack.pop_back();
+          stack.pop_back();
+          ctx->push_boolean(compare(s.operation, x, y));
+        }
+      } else {
+        const auto x = a->as_real();
+        const auto y = b->as_real();
+
+        stack.pop_back();
+        stack.pop_back();
+        if (is_arithmetic(s.operation))
+        {
+          ctx->push_real(real_arithmetic(s.operation, x, y));
+        } else {
+          ctx->push_boolean(compare(s.operation, x, y));
+        }
+      }
+
+      return true;
+    }
+  }
+}
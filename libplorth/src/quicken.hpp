@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2017-2018, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef PLORTH_QUICKEN_HPP_GUARD
+#define PLORTH_QUICKEN_HPP_GUARD
+
+#include <plorth/context.hpp>
+
+namespace plorth
+{
+  namespace quicken
+  {
+    /**
+     * Arithmetic and comparison operations which can be quickened.
+     */
+    enum class operation
+    {
+      add,
+      subtract,
+      multiply,
+      less_than,
+      greater_than,
+      less_than_or_equal,
+      greater_than_or_equal,
+      equal,
+      not_equal
+    };
+
+    /**
+     * Forms into which a call site is rewritten, based on the types of the
+     * operands observed when the site was executed for the first time.
+     */
+    enum class form
+    {
+      /** Site has not been executed yet. */
+      unobserved,
+      /** Both operands are integers. */
+      integers,
+      /** Both operands are numbers and at least one of them is real. */
+      reals,
+      /** Both operands are strings. */
+      strings,
+      /** Both operands are arrays. */
+      arrays,
+      /** Operands have been of different types; resolve the word normally. */
+      generic
+    };
+
+    /**
+     * Call site of an arithmetic or comparison word inside a compiled quote.
+     */
+    struct site
+    {
+      /** Index of the symbol in values of the quote. */
+      std::size_t index;
+      /** Operation performed by the word. */
+      enum operation operation;
+      /** Form into which the site has been rewritten. */
+      enum form form;
+      /** Word of a prototype called by string and array forms. */
+      quote::native_function function;
+      /**
+       * Version of the context dictionary which was checked for words
+       * shadowing the global equality words.
+       */
+      unsigned long dictionary_version;
+      /** Whether the context dictionary shadows the global equality word. */
+      bool shadowed;
+      /** Profile of the site, if site profiling has been enabled. */
+      std::shared_ptr<runtime::statistics::site_profile> profile;
+    };
+
+    /**
+     * Finds symbols which call arithmetic or comparison words from values of
+     * a compiled quote.
+     */
+    std::vector<site> find(const std::vector<std::shared_ptr<value>>& values);
+
+    /**
+     * Executes given call site, rewriting it into a specialized form on the
+     * first execution. If the operands do not match the form, the site is
+     * turned into generic one and the word is resolved as usual.
+     *
+     * \param ctx   Scripting context to execute the site in.
+     * \param val   Symbol which refers to the word.
+     * \param site  Call site to execute.
+     * \return      Boolean flag which tells whether execution succeeded
+     *              without errors or not.
+     */
+    bool execute(const std::shared_ptr<context>& ctx,
+                 const std::shared_ptr<value>& val,
+                 site& site);
+  }
+}
+
+#endif /* !PLORTH_QUICKEN_HPP_GUARD */
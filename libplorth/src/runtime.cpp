@@ -27,7 +27,9 @@
 #include <plorth/value-error.hpp>
 #include <plorth/value-quote.hpp>
 
+#include <algorithm>
 #include <cassert>
+#include <unordered_map>
 
 namespace plorth
 {
@@ -36,11 +38,15 @@ namespace plorth
     runtime::prototype_definition global_dictionary();
     runtime::prototype_definition array_prototype();
     runtime::prototype_definition boolean_prototype();
+    runtime::prototype_definition bytes_prototype();
     runtime::prototype_definition error_prototype();
+    runtime::prototype_definition file_prototype();
     runtime::prototype_definition number_prototype();
     runtime::prototype_definition object_prototype();
     runtime::prototype_definition quote_prototype();
+    runtime::prototype_definition stream_prototype();
     runtime::prototype_definition string_prototype();
+    runtime::prototype_definition string_builder_prototype();
     runtime::prototype_definition symbol_prototype();
     runtime::prototype_definition word_prototype();
   }
@@ -74,17 +80,47 @@ namespace plorth
 
   runtime::runtime(memory::manager* memory_manager)
     : m_memory_manager(memory_manager)
+    , m_statistics()
+#if PLORTH_ENABLE_JIT
+    , m_jit_enabled(false)
+#endif
   {
     assert(memory_manager);
 
     m_true_value = value<class boolean>(true);
     m_false_value = value<class boolean>(false);
+    m_empty_array = array(nullptr, 0);
+    m_empty_object = object({});
+    m_empty_string = string(nullptr, 0);
+
+#if PLORTH_ENABLE_INTEGER_CACHE
+    for (number::int_type i = PLORTH_INTEGER_CACHE_MIN;
+         i <= PLORTH_INTEGER_CACHE_MAX;
+         ++i)
+    {
+      m_integer_cache[i - PLORTH_INTEGER_CACHE_MIN] = number(i);
+    }
+#endif
+
+#if PLORTH_ENABLE_CHARACTER_CACHE
+    {
+      std::unique_ptr<std::shared_ptr<class string>[]> latin1(
+        new std::shared_ptr<class string>[256]
+      );
+
+      for (string::value_type c = 0; c < 256; ++c)
+      {
+        latin1[c] = character(c);
+      }
+      m_character_cache[0] = std::move(latin1);
+    }
+#endif
 
     for (auto& entry : api::global_dictionary())
     {
       m_dictionary.insert(word(
-        symbol(entry.first),
-        native_quote(entry.second)
+        symbol(entry.name),
+        native_quote(entry.callback, entry.stack_effect, entry.unchecked)
       ));
     }
 
@@ -103,11 +139,21 @@ namespace plorth
       U"boolean",
       api::boolean_prototype()
     );
+    m_bytes_prototype = make_prototype(
+      this,
+      U"bytes",
+      api::bytes_prototype()
+    );
     m_error_prototype = make_prototype(
       this,
       U"error",
       api::error_prototype()
     );
+    m_file_prototype = make_prototype(
+      this,
+      U"file",
+      api::file_prototype()
+    );
     m_number_prototype = make_prototype(
       this,
       U"number",
@@ -118,11 +164,21 @@ namespace plorth
       U"quote",
       api::quote_prototype()
     );
+    m_stream_prototype = make_prototype(
+      this,
+      U"stream",
+      api::stream_prototype()
+    );
     m_string_prototype = make_prototype(
       this,
       U"string",
       api::string_prototype()
     );
+    m_string_builder_prototype = make_prototype(
+      this,
+      U"string-builder",
+      api::string_builder_prototype()
+    );
     m_symbol_prototype = make_prototype(
       this,
       U"symbol",
@@ -133,6 +189,109 @@ namespace plorth
       U"word",
       api::word_prototype()
     );
+
+    build_method_table();
+  }
+
+  void runtime::build_method_table()
+  {
+    const struct
+    {
+      enum value::type type;
+      const std::shared_ptr<class object>& prototype;
+    } prototypes[] =
+    {
+      { value::type::boolean, m_boolean_prototype },
+      { value::type::number, m_number_prototype },
+      { value::type::string, m_string_prototype },
+      { value::type::array, m_array_prototype },
+      { value::type::object, m_object_prototype },
+      { value::type::symbol, m_symbol_prototype },
+      { value::type::quote, m_quote_prototype },
+      { value::type::word, m_word_prototype },
+      { value::type::error, m_error_prototype },
+      { value::type::string_builder, m_string_builder_prototype },
+      { value::type::file, m_file_prototype },
+      { value::type::bytes, m_bytes_prototype },
+      { value::type::stream, m_stream_prototype }
+    };
+    std::unordered_map<std::u32string, std::size_t> indexes;
+    std::size_t capacity = 1;
+
+    for (const auto& entry : prototypes)
+    {
+      const auto type = entry.type;
+
+      entry.prototype->for_each([&](const object::key_type& key,
+                                    const object::mapped_type& value)
+      {
+        const auto result = indexes.insert({ key, m_methods.size() });
+
+        if (result.second)
+        {
+          method_entry method;
+
+          method.hash = std::hash<std::u32string>()(key);
+          method.name = key;
+          method.types = 0;
+          m_methods.push_back(method);
+        }
+
+        auto& method = m_methods[result.first->second];
+
+        method.types |= 1u << static_cast<unsigned int>(type);
+        method.words[static_cast<std::size_t>(type)] = value;
+
+        return true;
+      });
+    }
+
+    // Keep the table at most quarter full, so that names which are not
+    // contained in the table usually hit an unused slot on the first probe.
+    while (capacity < m_methods.size() * 4)
+    {
+      capacity <<= 1;
+    }
+    m_method_index.assign(capacity, 0);
+    for (std::size_t i = 0; i < m_methods.size(); ++i)
+    {
+      auto slot = m_methods[i].hash & (capacity - 1);
+
+      while (m_method_index[slot])
+      {
+        slot = (slot + 1) & (capacity - 1);
+      }
+      m_method_index[slot] = static_cast<std::uint32_t>(i + 1);
+    }
+  }
+
+  bool runtime::prototype_word(enum value::type type,
+                               const class symbol& symbol,
+                               std::shared_ptr<class value>& slot) const
+  {
+    const auto mask = m_method_index.size() - 1;
+    const auto hash = symbol.hash();
+
+    for (auto index = hash & mask;
+         m_method_index[index];
+         index = (index + 1) & mask)
+    {
+      const auto& method = m_methods[m_method_index[index] - 1];
+
+      if (method.hash != hash || method.name.compare(symbol.id()))
+      {
+        continue;
+      }
+      else if (!(method.types & (1u << static_cast<unsigned int>(type))))
+      {
+        return false;
+      }
+      slot = method.words[static_cast<std::size_t>(type)];
+
+      return true;
+    }
+
+    return false;
   }
 
   io::input::result runtime::read(io::input::size_type size,
@@ -156,6 +315,29 @@ namespace plorth
     }
   }
 
+  void runtime::print(const std::shared_ptr<class string>& str) const
+  {
+    static const string::size_type chunk_size = 4096;
+    const auto length = str->length();
+    std::u32string chunk;
+
+    if (!m_output)
+    {
+      return;
+    }
+    else if (length <= chunk_size)
+    {
+      m_output->write(str->to_string());
+      return;
+    }
+    for (string::size_type offset = 0; offset < length; offset += chunk_size)
+    {
+      chunk.resize(std::min(chunk_size, length - offset));
+      str->copy(offset, chunk.length(), &chunk[0]);
+      m_output->write(chunk);
+    }
+  }
+
   void runtime::println() const
   {
 #if defined(_WIN32)
@@ -185,8 +367,12 @@ namespace plorth
     for (auto& entry : definition)
     {
       properties.push_back({
-        entry.first,
-        runtime->native_quote(entry.second)
+        entry.name,
+        runtime->native_quote(
+          entry.callback,
+          entry.stack_effect,
+          entry.unchecked
+        )
       });
     }
     properties.push_back({ U"__proto__", std::shared_ptr<value>() });
@@ -0,0 +1,573 @@
+/*
+ * Copyright (c) 2017-2018, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <plorth/context.hpp>
+
+#include "./utils.hpp"
+
+#include <algorithm>
+#include <unordered_set>
+
+namespace plorth
+{
+  const stack_effect::type_set stack_effect::any = ~0u;
+
+  static const struct
+  {
+    const char32_t* name;
+    enum value::type type;
+  } type_names[] =
+  {
+    { U"null", value::type::null },
+    { U"boolean", value::type::boolean },
+    { U"number", value::type::number },
+    { U"string", value::type::string },
+    { U"array", value::type::array },
+    { U"object", value::type::object },
+    { U"symbol", value::type::symbol },
+    { U"quote", value::type::quote },
+    { U"word", value::type::word },
+    { U"error", value::type::error },
+    { U"string-builder", value::type::string_builder },
+    { U"file", value::type::file },
+    { U"bytes", value::type::bytes },
+    { U"stream", value::type::stream }
+  };
+
+  static bool parse_type_set(const std::u32string& input,
+                             stack_effect::type_set& result)
+  {
+    std::u32string::size_type start = 0;
+
+    result = 0;
+    for (;;)
+    {
+      const auto end = input.find('|', start);
+      const auto name = input.substr(start, end - start);
+      bool found = false;
+
+      if (!name.compare(U"any"))
+      {
+        result = stack_effect::any;
+        found = true;
+      } else {
+        for (const auto& entry : type_names)
+        {
+          if (!name.compare(entry.name))
+          {
+            result |= stack_effect::type_of(entry.type);
+            found = true;
+            break;
+          }
+        }
+      }
+      if (!found)
+      {
+        return false;
+      }
+      else if (end == std::u32string::npos)
+      {
+        return true;
+      }
+      start = end + 1;
+    }
+  }
+
+  bool stack_effect::parse(const char32_t* notation, stack_effect& result)
+  {
+    std::vector<std::u32string> labels;
+    bool separator_found = false;
+    std::u32string token;
+
+    result.m_inputs.clear();
+    result.m_outputs.clear();
+
+    for (const char32_t* p = notation;; ++p)
+    {
+      if (*p && !unicode_isspace(*p))
+      {
+        token += *p;
+        continue;
+      }
+
+      if (token.empty())
+      {
+        // Nothing to do.
+      }
+      else if (!token.compare(U"--"))
+      {
+        if (separator_found)
+        {
+          return false;
+        }
+        separator_found = true;
+      }
+      else if (!separator_found)
+      {
+        const auto colon = token.find(':');
+        type_set types;
+
+        if (colon != std::u32string::npos)
+        {
+          if (!parse_type_set(token.substr(colon + 1), types))
+          {
+            return false;
+          }
+          labels.push_back(token.substr(0, colon));
+        }
+        else if (parse_type_set(token, types))
+        {
+          labels.push_back(U"");
+        } else {
+          types = any;
+          labels.push_back(token);
+        }
+        result.m_inputs.push_back(types);
+      } else {
+        const auto label = std::find(
+          std::begin(labels),
+          std::end(labels),
+          token
+        );
+        struct output output;
+
+        if (label != std::end(labels))
+        {
+          output.input = static_cast<int>(label - std::begin(labels));
+          output.types = result.m_inputs[output.input];
+        }
+        else if (parse_type_set(token, output.types))
+        {
+          output.input = -1;
+        } else {
+          return false;
+        }
+        result.m_outputs.push_back(output);
+      }
+      token.clear();
+
+      if (!*p)
+      {
+        break;
+      }
+    }
+
+    return separator_found;
+  }
+
+  static std::u32string type_set_to_string(stack_effect::type_set types)
+  {
+    std::u32string result;
+
+    if (types == stack_effect::any)
+    {
+      return U"any";
+    }
+    for (const auto& entry : type_names)
+    {
+      if (types & stack_effect::type_of(entry.type))
+      {
+        if (!result.empty())
+        {
+          result += '|';
+        }
+        result += entry.name;
+      }
+    }
+
+    return result;
+  }
+
+  std::u32string stack_effect::to_string() const
+  {
+    std::u32string result;
+
+    for (std::size_t i = 0; i < m_inputs.size(); ++i)
+    {
+      result += type_set_to_string(m_inputs[i]);
+      result += ' ';
+    }
+    result += U"--";
+    for (const auto& output : m_outputs)
+    {
+      result += ' ';
+      result += type_set_to_string(output.types);
+    }
+
+    return result;
+  }
+
+  namespace
+  {
+    /**
+     * Abstract interpreter which executes compiled values with types of the
+     * values instead of the values themselves.
+     */
+    class stack_simulator
+    {
+    public:
+      explicit stack_simulator(const class runtime& runtime,
+                               const std::vector<stack_effect::type_set>& stack,
+                               bool complete,
+                               const class dictionary* dictionary)
+        : m_runtime(runtime)
+        , m_stack(stack)
+        , m_complete(complete)
+        , m_dictionary(dictionary) {}
+
+      /**
+       * Simulates execution of the values and records results into given
+       * analysis.
+       */
+      void run(const std::vector<std::shared_ptr<value>>& values,
+               stack_analysis& analysis)
+      {
+        for (const auto& value : values)
+        {
+          collect_definitions(value);
+        }
+
+        for (std::size_t i = 0; i < values.size(); ++i)
+        {
+          const auto& value = values[i];
+
+          if (!value)
+          {
+            m_stack.push_back(stack_effect::type_of(value::type::null));
+            continue;
+          }
+
+          switch (value->type())
+          {
+            case value::type::symbol:
+              if (!symbol(
+                i,
+                std::static_pointer_cast<class symbol>(value)->id(),
+                analysis
+              ))
+              {
+                return;
+              }
+              break;
+
+            case value::type::word:
+              // Word definitions do not affect the stack.
+              break;
+
+            case value::type::array:
+            case value::type::object:
+              // Literal arrays and objects may contain `drop` which takes a
+              // value from the stack.
+              if (takes_values(value))
+              {
+                return;
+              }
+              m_stack.push_back(stack_effect::type_of(value->type()));
+              break;
+
+            default:
+              m_stack.push_back(stack_effect::type_of(value->type()));
+              break;
+          }
+        }
+      }
+
+    private:
+      bool symbol(std::size_t index,
+                  const std::u32string& id,
+                  stack_analysis& analysis)
+      {
+        // Look for prototype of the top-most value, just like the interpreter
+        // does.
+        if (!m_stack.empty())
+        {
+          const auto top = m_stack.back();
+          std::shared_ptr<object> prototype;
+          enum value::type type;
+
+          if (!single_type(top, type) || type == value::type::object)
+          {
+            // Word could be resolved from any prototype.
+            return false;
+          }
+          else if (type != value::type::null)
+          {
+            std::shared_ptr<value> slot;
+
+            if (!(prototype = prototype_of(type)))
+            {
+              return false;
+            }
+            // Prototypes of built-in types do not inherit from other objects,
+            // so own properties are the only ones which have to be looked up.
+            else if (prototype->own_property(id, slot))
+            {
+              if (!value::is(slot, value::type::quote))
+              {
+                return false;
+              }
+              analysis.sites.push_back({
+                index,
+                type,
+                std::static_pointer_cast<quote>(slot),
+                takes_known_types(
+                  std::static_pointer_cast<quote>(slot)->stack_effect()
+                )
+              });
+
+              return apply(
+                index,
+                std::static_pointer_cast<quote>(slot)->stack_effect(),
+                analysis
+              );
+            }
+          }
+        }
+        else if (!m_complete)
+        {
+          return false;
+        }
+
+        // Then the dictionaries.
+        if (m_definitions.find(id) != std::end(m_definitions)
+            || (m_dictionary && m_dictionary->find(id)))
+        {
+          return false;
+        }
+        if (const auto word = m_runtime.dictionary().find(id))
+        {
+          return apply(index, word->quote()->stack_effect(), analysis);
+        }
+
+        if (is_number(id))
+        {
+          m_stack.push_back(stack_effect::type_of(value::type::number));
+
+          return true;
+        }
+
+        return false;
+      }
+
+      /**
+       * Tests whether the simulated stack contains all values taken by a word
+       * with given stack effect, with types accepted by the word.
+       */
+      bool takes_known_types(const stack_effect* effect) const
+      {
+        if (!effect || effect->inputs().size() > m_stack.size())
+        {
+          return false;
+        }
+
+        const auto& inputs = effect->inputs();
+        const auto offset = m_stack.size() - inputs.size();
+
+        for (std::size_t i = 0; i < inputs.size(); ++i)
+        {
+          if (m_stack[offset + i] & ~inputs[i])
+          {
+            return false;
+          }
+        }
+
+        return true;
+      }
+
+      bool apply(std::size_t index,
+                 const stack_effect* effect,
+                 stack_analysis& analysis)
+      {
+        if (!effect)
+        {
+          return false;
+        }
+
+        const auto& inputs = effect->inputs();
+        const auto& outputs = effect->outputs();
+        std::vector<stack_effect::type_set> taken(inputs.size());
+
+        for (std::size_t i = inputs.size(); i > 0; --i)
+        {
+          if (!m_stack.empty())
+          {
+            taken[i - 1] = m_stack.back() & inputs[i - 1];
+            m_stack.pop_back();
+          }
+          else if (m_complete)
+          {
+            analysis.underflow = static_cast<long>(index);
+
+            return false;
+          } else {
+            taken[i - 1] = inputs[i - 1];
+          }
+        }
+
+        for (const auto& output : outputs)
+        {
+          m_stack.push_back(
+            output.input >= 0
+              ? taken[output.input]
+              : output.types
+          );
+        }
+
+        return true;
+      }
+
+      std::shared_ptr<object> prototype_of(enum value::type type) const
+      {
+        switch (type)
+        {
+          case value::type::boolean:
+            return m_runtime.boolean_prototype();
+
+          case value::type::number:
+            return m_runtime.number_prototype();
+
+          case value::type::string:
+            return m_runtime.string_prototype();
+
+          case value::type::array:
+            return m_runtime.array_prototype();
+
+          case value::type::symbol:
+            return m_runtime.symbol_prototype();
+
+          case value::type::quote:
+            return m_runtime.quote_prototype();
+
+          case value::type::word:
+            return m_runtime.word_prototype();
+
+          case value::type::error:
+            return m_runtime.error_prototype();
+
+          case value::type::string_builder:
+            return m_runtime.string_builder_prototype();
+
+          case value::type::file:
+            return m_runtime.file_prototype();
+
+          case value::type::bytes:
+            return m_runtime.bytes_prototype();
+
+          case value::type::stream:
+            return m_runtime.stream_prototype();
+
+          default:
+            return std::shared_ptr<object>();
+        }
+      }
+
+      /**
+       * Collects names of the words which are defined within the values, as
+       * those override words from the global dictionary.
+       */
+      void collect_definitions(const std::shared_ptr<value>& value)
+      {
+        if (value::is(value, value::type::word))
+        {
+          m_definitions.insert(
+            std::static_pointer_cast<word>(value)->symbol()->id()
+          );
+        }
+      }
+
+      static bool takes_values(const std::shared_ptr<value>& value)
+      {
+        if (value::is(value, value::type::symbol))
+        {
+          return !std::static_pointer_cast<class symbol>(value)->id().compare(
+            U"drop"
+          );
+        }
+        else if (value::is(value, value::type::array))
+        {
+          const auto ary = std::static_pointer_cast<array>(value);
+
+          for (array::size_type i = 0; i < ary->size(); ++i)
+          {
+            if (takes_values(ary->at(i)))
+            {
+              return true;
+            }
+          }
+        }
+        else if (value::is(value, value::type::object))
+        {
+          return !std::static_pointer_cast<object>(value)->for_each(
+            [](const object::key_type&, const object::mapped_type& property)
+            {
+              return !takes_values(property);
+            }
+          );
+        }
+
+        return false;
+      }
+
+      static bool single_type(stack_effect::type_set types,
+                              enum value::type& type)
+      {
+        for (const auto& entry : type_names)
+        {
+          if (types == stack_effect::type_of(entry.type))
+          {
+            type = entry.type;
+
+            return true;
+          }
+        }
+
+        return false;
+      }
+
+    private:
+      const class runtime& m_runtime;
+      std::vector<stack_effect::type_set> m_stack;
+      const bool m_complete;
+      const class dictionary* m_dictionary;
+      std::unordered_set<std::u32string> m_definitions;
+    };
+  }
+
+  stack_analysis stack_analysis::analyze(
+    const class runtime& runtime,
+    const std::vector<std::shared_ptr<value>>& values,
+    const std::vector<stack_effect::type_set>& stack,
+    bool complete,
+    const class dictionary* dictionary
+  )
+  {
+    stack_analysis analysis;
+
+    analysis.underflow = -1;
+    stack_simulator(runtime, stack, complete, dictionary).run(values, analysis);
+
+    return analysis;
+  }
+}
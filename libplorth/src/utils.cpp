@@ -30,6 +30,8 @@
 #include <cfloat>
 #include <climits>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
 
 namespace plorth
 {
@@ -167,6 +169,32 @@ namespace plorth
     return true;
   }
 
+  bool is_ascii(const unsigned char* input, std::size_t length)
+  {
+    std::size_t i = 0;
+
+    // Eight bytes are tested at once, as long as there are enough of them.
+    for (; i + sizeof(std::uint64_t) <= length; i += sizeof(std::uint64_t))
+    {
+      std::uint64_t word;
+
+      std::memcpy(&word, input + i, sizeof(word));
+      if (word & UINT64_C(0x8080808080808080))
+      {
+        return false;
+      }
+    }
+    for (; i < length; ++i)
+    {
+      if (input[i] & 0x80)
+      {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
   std::u32string to_unistring(number::int_type number)
   {
     const bool negative = number < 0;
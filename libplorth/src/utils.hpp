@@ -33,7 +33,7 @@ namespace plorth
   std::u32string json_stringify(const std::u32string&);
   number::int_type to_integer(const std::u32string&);
   number::real_type to_real(const std::u32string&);
-  bool is_number(const std::u32string&);
+  bool is_ascii(const unsigned char*, std::size_t);
   std::u32string to_unistring(number::int_type);
   std::u32string to_unistring(number::real_type);
 }
@@ -25,10 +25,69 @@
  */
 #include <plorth/context.hpp>
 
+#include <cstdint>
+#include <limits>
+
+#if !defined(PLORTH_INLINE_ARRAY_MAX_SIZE)
+# define PLORTH_INLINE_ARRAY_MAX_SIZE 16
+#endif
+
 namespace plorth
 {
   namespace
   {
+    /**
+     * Implementation of small array, which stores it's elements directly after
+     * the array value itself, in the same memory slot.
+     */
+    class inline_array : public array
+    {
+    public:
+      /**
+       * Allocates memory for the array and it's elements with single
+       * allocation and constructs the array.
+       */
+      static std::shared_ptr<array> make(memory::manager& memory_manager,
+                                         size_type size,
+                                         const_pointer elements)
+      {
+        void* memory = memory_manager.allocate(
+          sizeof(inline_array) + sizeof(value_type) * size
+        );
+
+        return std::shared_ptr<array>(
+          ::new (memory) inline_array(size, elements)
+        );
+      }
+
+      ~inline_array()
+      {
+        pointer elements = this->elements();
+
+        for (size_type i = 0; i < size(); ++i)
+        {
+          elements[i].~value_type();
+        }
+      }
+
+    private:
+      explicit inline_array(size_type size, const_pointer elements)
+        : array(size, reinterpret_cast<const_pointer>(this + 1))
+      {
+        pointer data = this->elements();
+
+        for (size_type i = 0; i < size; ++i)
+        {
+          ::new (static_cast<void*>(data + i)) value_type(elements[i]);
+        }
+      }
+
+      inline pointer elements()
+      {
+        return reinterpret_cast<pointer>(this + 1);
+      }
+    };
+
     /**
      * Implementation of simple array, which only acts as a wrapper for C type
      * array.
@@ -37,36 +96,58 @@ namespace plorth
     {
     public:
       simple_array(size_type size, const_pointer elements)
-        : m_size(size)
-        , m_elements(size > 0 ? new value_type[size] : nullptr)
+        : array(size, duplicate(size, elements)) {}
+
+      ~simple_array()
       {
-        for (size_type i = 0; i < m_size; ++i)
+        if (size() > 0)
         {
-          m_elements[i] = elements[i];
+          delete[] data();
         }
       }
 
-      ~simple_array()
+    private:
+      static const_pointer duplicate(size_type size, const_pointer elements)
       {
-        if (m_size > 0)
+        pointer result;
+
+        if (!size)
         {
-          delete[] m_elements;
+          return nullptr;
+        }
+        result = new value_type[size];
+        for (size_type i = 0; i < size; ++i)
+        {
+          result[i] = elements[i];
         }
-      }
 
-      inline size_type size() const
-      {
-        return m_size;
+        return result;
       }
+    };
 
-      const_reference at(size_type i) const
+    /**
+     * Implementation of array which repeats elements of already existing
+     * array given number of times, without constructing the repeated
+     * contents.
+     */
+    class repeated_array : public array
+    {
+    public:
+      explicit repeated_array(const std::shared_ptr<array>& original,
+                              size_type count)
+        : array(original->size() * count)
+        , m_original(original)
+        , m_original_size(original->size()) {}
+
+    protected:
+      const_reference element(size_type i) const
       {
-        return m_elements[i];
+        return m_original->at(i % m_original_size);
       }
 
     private:
-      const size_type m_size;
-      pointer m_elements;
+      const std::shared_ptr<array> m_original;
+      const size_type m_original_size;
     };
 
     /**
@@ -77,16 +158,12 @@ namespace plorth
     public:
       concat_array(const std::shared_ptr<array>& left,
                    const std::shared_ptr<array>& right)
-        : m_size(left->size() + right->size())
+        : array(left->size() + right->size())
         , m_left(left)
         , m_right(right) {}
 
-      inline size_type size() const
-      {
-        return m_size;
-      }
-
-      const_reference at(size_type offset) const
+    protected:
+      const_reference element(size_type offset) const
       {
         const size_type left_size = m_left->size();
 
@@ -99,7 +176,6 @@ namespace plorth
       }
 
     private:
-      const size_type m_size;
       const std::shared_ptr<array> m_left;
       const std::shared_ptr<array> m_right;
     };
@@ -113,15 +189,12 @@ namespace plorth
     public:
       explicit push_array(const std::shared_ptr<class array>& array,
                           const std::shared_ptr<value>& extra)
-        : m_array(array)
+        : plorth::array(array->size() + 1)
+        , m_array(array)
         , m_extra(extra) {}
 
-      inline size_type size() const
-      {
-        return m_array->size() + 1;
-      }
-
-      const_reference at(size_type offset) const
+    protected:
+      const_reference element(size_type offset) const
       {
         if (offset == m_array->size())
         {
@@ -138,6 +211,7 @@ namespace plorth
 
     /**
      * Array implementation which is actually portion of already existing array.
+     * If the other array is stored in contiguous memory, so is the portion.
      */
     class subarray : public array
     {
@@ -145,16 +219,12 @@ namespace plorth
       explicit subarray(const std::shared_ptr<class array>& array,
                         size_type offset,
                         size_type size)
-        : m_array(array)
-        , m_offset(offset)
-        , m_size(size) {}
-
-      inline size_type size() const
-      {
-        return m_size;
-      }
+        : plorth::array(size, array->data() ? array->data() + offset : nullptr)
+        , m_array(array)
+        , m_offset(offset) {}
 
-      const_reference at(size_type offset) const
+    protected:
+      const_reference element(size_type offset) const
       {
         return m_array->at(m_offset + offset);
       }
@@ -162,7 +232,6 @@ namespace plorth
     private:
       const std::shared_ptr<array> m_array;
       const size_type m_offset;
-      const size_type m_size;
     };
 
     /**
@@ -172,14 +241,11 @@ namespace plorth
     {
     public:
       explicit reversed_array(const std::shared_ptr<class array>& array)
-        : m_array(array) {}
-
-      inline size_type size() const
-      {
-        return m_array->size();
-      }
+        : plorth::array(array->size())
+        , m_array(array) {}
 
-      const_reference at(size_type offset) const
+    protected:
+      const_reference element(size_type offset) const
       {
         return m_array->at(size() - offset - 1);
       }
@@ -189,6 +255,16 @@ namespace plorth
     };
   }
 
+  array::array(size_type size, const_pointer data)
+    : value(type::array)
+    , m_size(size)
+    , m_data(data) {}
+
+  array::const_reference array::element(size_type offset) const
+  {
+    return m_data[offset];
+  }
+
   bool array::equals(const std::shared_ptr<value>& that) const
   {
     std::shared_ptr<array> ary;
@@ -322,6 +398,15 @@ namespace plorth
   std::shared_ptr<class array> runtime::array(array::const_pointer elements,
                                               array::size_type size)
   {
+    if (!size && m_empty_array)
+    {
+      return m_empty_array;
+    }
+    else if (size <= PLORTH_INLINE_ARRAY_MAX_SIZE)
+    {
+      return inline_array::make(*m_memory_manager, size, elements);
+    }
+
     return std::shared_ptr<class array>(
       new (*m_memory_manager) simple_array(size, elements)
     );
@@ -1175,7 +1260,16 @@ namespace plorth
 
     if (ctx->pop_array(a) && ctx->pop_array(b))
     {
-      ctx->push(ctx->runtime()->value<concat_array>(b, a));
+      if (!a->size())
+      {
+        ctx->push(b);
+      }
+      else if (!b->size())
+      {
+        ctx->push(a);
+      } else {
+        ctx->push(ctx->runtime()->value<concat_array>(b, a));
+      }
     }
   }
 
@@ -1201,22 +1295,27 @@ namespace plorth
     {
       const number::int_type count = num->as_int();
 
-      if (count > 0)
+      if (count < 0)
       {
-        const auto& runtime = ctx->runtime();
-        std::shared_ptr<array> result = ary;
-
-        for (number::int_type i = 1; i < count; ++i)
-        {
-          result = runtime->value<concat_array>(result, ary);
-        }
-        ctx->push(result);
+        ctx->error(error::code::range, U"Invalid repeat count.");
       }
-      else if (count == 0)
+      else if (count == 0 || !ary->size())
       {
         ctx->push_array(nullptr, 0);
+      }
+      else if (count == 1)
+      {
+        ctx->push(ary);
+      }
+      else if (static_cast<std::uint64_t>(count) >
+               std::numeric_limits<array::size_type>::max() / ary->size())
+      {
+        ctx->error(error::code::range, U"Repeat count is too large.");
       } else {
-        ctx->error(error::code::range, U"Invalid repeat count.");
+        ctx->push(ctx->runtime()->value<repeated_array>(
+          ary,
+          static_cast<array::size_type>(count)
+        ));
       }
     }
   }
@@ -1444,42 +1543,42 @@ namespace plorth
     {
       return
       {
-        { U"length", w_length },
+        { U"length", w_length, U"array -- array number" },
 
         // Modification.
-        { U"push", w_push },
-        { U"pop", w_pop },
+        { U"push", w_push, U"any array -- array" },
+        { U"pop", w_pop, U"array -- array any" },
 
         // Search methods.
-        { U"includes?", w_includes },
-        { U"index-of", w_index_of },
-        { U"find", w_find },
-        { U"find-index", w_find_index },
-        { U"every?", w_every },
-        { U"some?", w_some },
+        { U"includes?", w_includes, U"any array -- array boolean" },
+        { U"index-of", w_index_of, U"any array -- array number|null" },
+        { U"find", w_find, nullptr },
+        { U"find-index", w_find_index, nullptr },
+        { U"every?", w_every, nullptr },
+        { U"some?", w_some, nullptr },
 
         // Conversions.
-        { U"reverse", w_reverse },
-        { U"uniq", w_uniq },
-        { U"extract", w_extract },
-        { U"join", w_join },
-        { U"flatten", w_flatten },
-        { U"nflatten", w_nflatten },
-        { U">quote", w_to_quote },
-
-        { U"for-each", w_for_each },
-        { U"2for-each", w_2for_each },
-        { U"map", w_map },
-        { U"2map", w_2map },
-        { U"filter", w_filter },
-        { U"reduce", w_reduce },
-
-        { U"+", w_concat },
-        { U"*", w_repeat },
-        { U"&", w_intersect },
-        { U"|", w_union },
-        { U"@", w_get },
-        { U"!", w_set }
+        { U"reverse", w_reverse, U"array -- array" },
+        { U"uniq", w_uniq, U"array -- array" },
+        { U"extract", w_extract, nullptr },
+        { U"join", w_join, U"string array -- string" },
+        { U"flatten", w_flatten, U"array -- array" },
+        { U"nflatten", w_nflatten, U"number array -- array" },
+        { U">quote", w_to_quote, U"array -- quote" },
+
+        { U"for-each", w_for_each, nullptr },
+        { U"2for-each", w_2for_each, nullptr },
+        { U"map", w_map, nullptr },
+        { U"2map", w_2map, nullptr },
+        { U"filter", w_filter, nullptr },
+        { U"reduce", w_reduce, nullptr },
+
+        { U"+", w_concat, U"array array -- array" },
+        { U"*", w_repeat, U"number array -- array" },
+        { U"&", w_intersect, U"array array -- array" },
+        { U"|", w_union, U"array array -- array" },
+        { U"@", w_get, U"number array -- array any" },
+        { U"!", w_set, U"any number array -- array" }
       };
     }
   }
@@ -28,7 +28,8 @@
 namespace plorth
 {
   boolean::boolean(bool value)
-    : m_value(value) {}
+    : plorth::value(type::boolean)
+    , m_value(value) {}
 
   bool boolean::equals(const std::shared_ptr<class value>& that) const
   {
@@ -182,11 +183,11 @@ namespace plorth
     {
       return
       {
-        { U"and", w_and },
-        { U"or", w_or },
-        { U"xor", w_xor },
-        { U"not", w_not },
-        { U"?", w_select },
+        { U"and", w_and, U"boolean boolean -- boolean" },
+        { U"or", w_or, U"boolean boolean -- boolean" },
+        { U"xor", w_xor, U"boolean boolean -- boolean" },
+        { U"not", w_not, U"boolean -- boolean" },
+        { U"?", w_select, U"any any boolean -- any" },
       };
     }
   }
@@ -0,0 +1,681 @@
+/*
+ * Copyright (c) 2017-2018, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <plorth/context.hpp>
+#include <plorth/unicode.hpp>
+
+#include "./utils.hpp"
+
+#if !defined(PLORTH_INLINE_BYTES_MAX_LENGTH)
+# define PLORTH_INLINE_BYTES_MAX_LENGTH 256
+#endif
+
+#if !defined(PLORTH_BYTES_VIEW_MIN_LENGTH)
+# define PLORTH_BYTES_VIEW_MIN_LENGTH 16
+#endif
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+namespace plorth
+{
+  namespace
+  {
+    /**
+     * Implementation of byte sequence which stores it's contents directly
+     * after the value itself, in the same memory slot.
+     */
+    class inline_bytes : public bytes
+    {
+    public:
+      /**
+       * Allocates memory for the byte sequence and it's contents with single
+       * allocation and constructs the byte sequence.
+       */
+      static std::shared_ptr<bytes> make(memory::manager& memory_manager,
+                                         const_pointer data,
+                                         size_type length)
+      {
+        void* memory = memory_manager.allocate(sizeof(inline_bytes) + length);
+
+        return std::shared_ptr<bytes>(
+          ::new (memory) inline_bytes(data, length)
+        );
+      }
+
+    private:
+      explicit inline_bytes(const_pointer data, size_type length)
+        : bytes(reinterpret_cast<const_pointer>(this + 1), length)
+      {
+        if (length > 0)
+        {
+          std::memcpy(reinterpret_cast<value_type*>(this + 1), data, length);
+        }
+      }
+    };
+
+    /**
+     * Implementation of byte sequence which stores it's contents in a
+     * separately allocated buffer. Used for sequences which are too large to
+     * be allocated from the memory pool.
+     */
+    class simple_bytes : public bytes
+    {
+    public:
+      explicit simple_bytes(const_pointer data, size_type length)
+        : bytes(duplicate(data, length), length) {}
+
+      ~simple_bytes()
+      {
+        delete[] data();
+      }
+
+    private:
+      static const_pointer duplicate(const_pointer data, size_type length)
+      {
+        const auto result = new value_type[length];
+
+        std::memcpy(result, data, length);
+
+        return result;
+      }
+    };
+
+    /**
+     * Implementation of byte sequence which shares memory of another byte
+     * sequence.
+     */
+    class slice_bytes : public bytes
+    {
+    public:
+      explicit slice_bytes(const std::shared_ptr<bytes>& original,
+                           size_type offset,
+                           size_type length)
+        : bytes(original->data() + offset, length)
+        , m_original(original) {}
+
+    private:
+      const std::shared_ptr<bytes> m_original;
+    };
+
+    /**
+     * Implementation of string which reads it's characters directly from
+     * byte sequence consisting of ASCII characters only.
+     */
+    class ascii_string : public string
+    {
+    public:
+      explicit ascii_string(const std::shared_ptr<bytes>& original)
+        : string(original->length())
+        , m_original(original) {}
+
+      void copy(size_type offset, size_type count, pointer output) const
+      {
+        const auto data = m_original->data() + offset;
+
+        for (size_type i = 0; i < count; ++i)
+        {
+          output[i] = data[i];
+        }
+      }
+
+    protected:
+      value_type element(size_type offset) const
+      {
+        return m_original->at(offset);
+      }
+
+    private:
+      const std::shared_ptr<bytes> m_original;
+    };
+  }
+
+  bytes::bytes(const_pointer data, size_type length)
+    : value(type::bytes)
+    , m_data(data)
+    , m_length(length) {}
+
+  std::shared_ptr<bytes> bytes::slice(class runtime& runtime,
+                                      const std::shared_ptr<bytes>& input,
+                                      size_type offset,
+                                      size_type length)
+  {
+    if (!offset && length == input->length())
+    {
+      return input;
+    }
+    else if (length <= PLORTH_BYTES_VIEW_MIN_LENGTH)
+    {
+      return runtime.bytes(input->data() + offset, length);
+    }
+
+    return runtime.value<slice_bytes>(input, offset, length);
+  }
+
+  std::shared_ptr<string> bytes::decode(class runtime& runtime,
+                                        const std::shared_ptr<bytes>& input)
+  {
+    const auto data = input->data();
+    const auto length = input->length();
+    std::u32string output;
+
+    if (is_ascii(data, length))
+    {
+      string::value_type chars[PLORTH_BYTES_VIEW_MIN_LENGTH];
+
+      if (length > PLORTH_BYTES_VIEW_MIN_LENGTH)
+      {
+        return runtime.value<ascii_string>(input);
+      }
+      for (size_type i = 0; i < length; ++i)
+      {
+        chars[i] = data[i];
+      }
+
+      return runtime.string(chars, length);
+    }
+    else if (!utf8_decode_test(
+      std::string(reinterpret_cast<const char*>(data), length),
+      output
+    ))
+    {
+      return std::shared_ptr<string>();
+    }
+
+    return runtime.string(output);
+  }
+
+  bool bytes::integer_layout::parse(const std::u32string& input,
+                                    integer_layout& output)
+  {
+    static const struct
+    {
+      const char32_t* name;
+      integer_layout layout;
+    } layouts[] =
+    {
+      { U"u8", { 1, false, true } },
+      { U"i8", { 1, true, true } },
+      { U"u16le", { 2, false, true } },
+      { U"u16be", { 2, false, false } },
+      { U"i16le", { 2, true, true } },
+      { U"i16be", { 2, true, false } },
+      { U"u32le", { 4, false, true } },
+      { U"u32be", { 4, false, false } },
+      { U"i32le", { 4, true, true } },
+      { U"i32be", { 4, true, false } },
+      { U"u64le", { 8, false, true } },
+      { U"u64be", { 8, false, false } },
+      { U"i64le", { 8, true, true } },
+      { U"i64be", { 8, true, false } }
+    };
+
+    for (const auto& entry : layouts)
+    {
+      if (!input.compare(entry.name))
+      {
+        output = entry.layout;
+
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  bool bytes::equals(const std::shared_ptr<class value>& that) const
+  {
+    std::shared_ptr<bytes> b;
+
+    if (!value::is(that, type::bytes))
+    {
+      return false;
+    }
+    b = std::static_pointer_cast<bytes>(that);
+
+    return m_length == b->m_length
+      && (!m_length || !std::memcmp(m_data, b->m_data, m_length));
+  }
+
+  std::u32string bytes::to_string() const
+  {
+    return to_source();
+  }
+
+  std::u32string bytes::to_source() const
+  {
+    static const char32_t digits[] = U"0123456789abcdef";
+    std::u32string result;
+
+    result.reserve(m_length * 2 + 8);
+    result.append(U"<bytes ");
+    for (size_type i = 0; i < m_length; ++i)
+    {
+      result.append(1, digits[m_data[i] >> 4]);
+      result.append(1, digits[m_data[i] & 0x0f]);
+    }
+    result.append(1, U'>');
+
+    return result;
+  }
+
+  std::shared_ptr<bytes> runtime::bytes(bytes::const_pointer data,
+                                        bytes::size_type length)
+  {
+    if (length <= PLORTH_INLINE_BYTES_MAX_LENGTH)
+    {
+      return inline_bytes::make(*m_memory_manager, data, length);
+    }
+
+    return std::shared_ptr<class bytes>(
+      new (*m_memory_manager) simple_bytes(data, length)
+    );
+  }
+
+  static bool pop_bytes(const std::shared_ptr<context>& ctx,
+                        std::shared_ptr<bytes>& slot)
+  {
+    std::shared_ptr<value> b;
+
+    if (!ctx->pop(b, value::type::bytes))
+    {
+      return false;
+    }
+    slot = std::static_pointer_cast<bytes>(b);
+
+    return true;
+  }
+
+  /**
+   * Word: length
+   * Prototype: bytes
+   *
+   * Takes:
+   * - bytes
+   *
+   * Gives:
+   * - bytes
+   * - number
+   *
+   * Returns the number of bytes in the byte sequence.
+   */
+  static void w_length(const std::shared_ptr<context>& ctx)
+  {
+    std::shared_ptr<bytes> b;
+
+    if (pop_bytes(ctx, b))
+    {
+      ctx->push(b);
+      ctx->push_int(b->length());
+    }
+  }
+
+  /**
+   * Word: @
+   * Prototype: bytes
+   *
+   * Takes:
+   * - number
+   * - bytes
+   *
+   * Gives:
+   * - bytes
+   * - number
+   *
+   * Retrieves a byte at given index. Negative indices count backwards from
+   * the end of the byte sequence. If given index is out of bounds, a range
+   * error will be thrown.
+   */
+  static void w_get(const std::shared_ptr<context>& ctx)
+  {
+    std::shared_ptr<bytes> b;
+    std::shared_ptr<number> num;
+
+    if (pop_bytes(ctx, b) && ctx->pop_number(num))
+    {
+      const auto length = static_cast<number::int_type>(b->length());
+      number::int_type index = num->as_int();
+
+      if (index < 0)
+      {
+        index += length;
+      }
+
+      ctx->push(b);
+
+      if (index < 0 || index >= length)
+      {
+        ctx->error(error::code::range, U"Byte index out of bounds.");
+        return;
+      }
+
+      ctx->push_int(b->at(index));
+    }
+  }
+
+  /**
+   * Word: slice
+   * Prototype: bytes
+   *
+   * Takes:
+   * - number
+   * - number
+   * - bytes
+   *
+   * Gives:
+   * - bytes
+   * - bytes
+   *
+   * Takes a portion of the byte sequence, starting from offset given as the
+   * third topmost value of the stack and having length given as the second
+   * topmost value of the stack. Negative offset counts backwards from the
+   * end of the byte sequence. Contents of longer portions are not copied. If
+   * the portion does not fit in the byte sequence, a range error will be
+   * thrown.
+   *
+   *     "foobar" >bytes 3 2 rot slice nip >string #=> "ba"
+   */
+  static void w_slice(const std::shared_ptr<context>& ctx)
+  {
+    std::shared_ptr<bytes> b;
+    std::shared_ptr<number> count;
+    std::shared_ptr<number> offset;
+
+    if (pop_bytes(ctx, b) && ctx->pop_number(count) && ctx->pop_number(offset))
+    {
+      const auto length = static_cast<number::int_type>(b->length());
+      number::int_type start = offset->as_int();
+      const number::int_type size = count->as_int();
+
+      if (start < 0)
+      {
+        start += length;
+      }
+
+      ctx->push(b);
+
+      if (start < 0 || start > length || size < 0 || size > length - start)
+      {
+        ctx->error(error::code::range, U"Slice out of bounds.");
+        return;
+      }
+
+      ctx->push(bytes::slice(*ctx->runtime(), b, start, size));
+    }
+  }
+
+  /**
+   * Word: index-of
+   * Prototype: bytes
+   *
+   * Takes:
+   * - number|bytes
+   * - bytes
+   *
+   * Gives:
+   * - bytes
+   * - number|null
+   *
+   * Searches for the first occurrence of a byte value or byte sequence given
+   * as second topmost value of the stack from byte sequence given as topmost
+   * value of the stack. If it does not exist in the byte sequence, null will
+   * be returned. Otherwise, first numerical index of the occurrence is
+   * returned.
+   */
+  static void w_index_of(const std::shared_ptr<context>& ctx)
+  {
+    std::shared_ptr<bytes> b;
+    std::shared_ptr<value> needle;
+    bytes::const_pointer begin;
+    bytes::const_pointer end;
+    bytes::const_pointer found;
+
+    if (!pop_bytes(ctx, b) || !ctx->pop(needle))
+    {
+      return;
+    }
+    begin = b->data();
+    end = begin + b->length();
+    if (value::is(needle, value::type::number))
+    {
+      const auto c = std::static_pointer_cast<number>(needle)->as_int();
+
+      if (c < 0 || c > 255)
+      {
+        ctx->push(b);
+        ctx->error(error::code::range, U"Byte value out of range.");
+        return;
+      }
+      found = b->length()
+        ? static_cast<bytes::const_pointer>(std::memchr(begin, c, b->length()))
+        : nullptr;
+      if (!found)
+      {
+        found = end;
+      }
+    }
+    else if (value::is(needle, value::type::bytes))
+    {
+      const auto n = std::static_pointer_cast<bytes>(needle);
+
+      found = std::search(begin, end, n->data(), n->data() + n->length());
+      if (found == end && !n->length())
+      {
+        found = begin;
+      }
+    } else {
+      ctx->push(b);
+      ctx->error(
+        error::code::type,
+        U"Expected number or bytes, got " +
+        value::type_description(
+          needle ? needle->type() : value::type::null
+        ) +
+        U" instead."
+      );
+      return;
+    }
+
+    ctx->push(b);
+    if (found == end)
+    {
+      ctx->push_null();
+    } else {
+      ctx->push_int(found - begin);
+    }
+  }
+
+  /**
+   * Word: unpack
+   * Prototype: bytes
+   *
+   * Takes:
+   * - number
+   * - string
+   * - bytes
+   *
+   * Gives:
+   * - bytes
+   * - number
+   *
+   * Reads an integer number from offset given as third topmost value of the
+   * stack, using integer format given as second topmost value of the stack.
+   * The format consists of "u" for unsigned or "i" for signed integers,
+   * followed by the number of bits, which is 8, 16, 32 or 64. Formats of
+   * integers wider than 8 bits end with "le" for little endian or "be" for
+   * big endian byte order. If the integer does not fit in the byte sequence,
+   * a range error will be thrown. Range error is also thrown for unsigned 64
+   * bit integers which are too large to be represented as a number, that is
+   * 2^63 or larger.
+   *
+   *     "\u0001\u0002" >bytes 0 "u16be" rot unpack nip #=> 258
+   */
+  static void w_unpack(const std::shared_ptr<context>& ctx)
+  {
+    std::shared_ptr<bytes> b;
+    std::shared_ptr<string> format;
+    std::shared_ptr<number> offset;
+
+    if (pop_bytes(ctx, b) && ctx->pop_string(format) && ctx->pop_number(offset))
+    {
+      const auto length = static_cast<number::int_type>(b->length());
+      const auto start = offset->as_int();
+      bytes::integer_layout layout;
+      std::uint64_t result = 0;
+
+      ctx->push(b);
+      if (!bytes::integer_layout::parse(format->to_string(), layout))
+      {
+        ctx->error(error::code::value, U"Unknown integer format.");
+        return;
+      }
+      else if (start < 0
+               || start > length
+               || static_cast<number::int_type>(layout.size) > length - start)
+      {
+        ctx->error(error::code::range, U"Byte index out of bounds.");
+        return;
+      }
+      for (std::size_t i = 0; i < layout.size; ++i)
+      {
+        const auto index = layout.little_endian ? layout.size - i - 1 : i;
+
+        result = (result << 8) | b->at(start + index);
+      }
+      if (layout.is_signed)
+      {
+        const auto bits = layout.size * 8;
+
+        // Sign extend integers narrower than 64 bits.
+        if (bits < 64 && (result & (UINT64_C(1) << (bits - 1))))
+        {
+          result |= ~((UINT64_C(1) << bits) - 1);
+        }
+        ctx->push_int(static_cast<number::int_type>(
+          static_cast<std::int64_t>(result)
+        ));
+      }
+      else if (result > static_cast<std::uint64_t>(
+        std::numeric_limits<number::int_type>::max()
+      ))
+      {
+        ctx->error(error::code::range, U"Integer out of range for number.");
+      } else {
+        ctx->push_int(static_cast<number::int_type>(result));
+      }
+    }
+  }
+
+  /**
+   * Word: +
+   * Prototype: bytes
+   *
+   * Takes:
+   * - bytes
+   * - bytes
+   *
+   * Gives:
+   * - bytes
+   *
+   * Concatenates two byte sequences and returns the result.
+   */
+  static void w_concat(const std::shared_ptr<context>& ctx)
+  {
+    std::shared_ptr<bytes> a;
+    std::shared_ptr<bytes> b;
+
+    if (pop_bytes(ctx, a) && pop_bytes(ctx, b))
+    {
+      if (!a->length())
+      {
+        ctx->push(b);
+      }
+      else if (!b->length())
+      {
+        ctx->push(a);
+      } else {
+        std::string buffer;
+
+        buffer.reserve(a->length() + b->length());
+        buffer.append(reinterpret_cast<const char*>(b->data()), b->length());
+        buffer.append(reinterpret_cast<const char*>(a->data()), a->length());
+        ctx->push(ctx->runtime()->bytes(
+          reinterpret_cast<bytes::const_pointer>(buffer.data()),
+          buffer.length()
+        ));
+      }
+    }
+  }
+
+  /**
+   * Word: >string
+   * Prototype: bytes
+   *
+   * Takes:
+   * - bytes
+   *
+   * Gives:
+   * - string
+   *
+   * Decodes contents of the byte sequence as UTF-8 encoded text. Value error
+   * will be thrown if the byte sequence is not valid UTF-8. Byte sequences
+   * consisting of ASCII characters only are not copied.
+   */
+  static void w_to_string(const std::shared_ptr<context>& ctx)
+  {
+    std::shared_ptr<bytes> b;
+
+    if (pop_bytes(ctx, b))
+    {
+      const auto result = bytes::decode(*ctx->runtime(), b);
+
+      if (!result)
+      {
+        ctx->error(error::code::value, U"Unable to decode bytes as UTF-8.");
+        return;
+      }
+      ctx->push(result);
+    }
+  }
+
+  namespace api
+  {
+    runtime::prototype_definition bytes_prototype()
+    {
+      return
+      {
+        { U"length", w_length, U"bytes -- bytes number" },
+        { U"slice", w_slice, U"number number bytes -- bytes bytes" },
+        { U"index-of", w_index_of, U"number|bytes bytes -- bytes number|null" },
+        { U"unpack", w_unpack, U"number string bytes -- bytes number" },
+        { U"+", w_concat, U"bytes bytes -- bytes" },
+        { U"@", w_get, U"number bytes -- bytes number" },
+        { U">string", w_to_string, U"bytes -- string" },
+      };
+    }
+  }
+}
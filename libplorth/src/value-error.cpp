@@ -30,16 +30,85 @@ namespace plorth
   error::error(enum code code,
                const std::u32string& message,
                const struct position* position)
-    : m_code(code)
+    : value(type::error)
+    , m_code(code)
+    , m_payload(payload::message)
     , m_message(message)
-    , m_position(position ? new struct position(*position) : nullptr) {}
+    , m_literal(nullptr)
+    , m_expected_type(type::null)
+    , m_actual_type(type::null)
+    , m_has_position(!!position)
+    , m_position(position ? *position : plorth::position()) {}
 
-  error::~error()
+  error::error(enum code code,
+               const char32_t* message,
+               const struct position* position)
+    : value(type::error)
+    , m_code(code)
+    , m_payload(payload::literal)
+    , m_literal(message)
+    , m_expected_type(type::null)
+    , m_actual_type(type::null)
+    , m_has_position(!!position)
+    , m_position(position ? *position : plorth::position()) {}
+
+  error::error(enum value::type expected,
+               enum value::type actual,
+               const struct position* position)
+    : value(type::error)
+    , m_code(code::type)
+    , m_payload(payload::type_mismatch)
+    , m_literal(nullptr)
+    , m_expected_type(expected)
+    , m_actual_type(actual)
+    , m_has_position(!!position)
+    , m_position(position ? *position : plorth::position()) {}
+
+  const std::u32string& error::message() const
+  {
+    switch (m_payload)
+    {
+    case payload::message:
+      break;
+
+    case payload::literal:
+      m_message = m_literal;
+      m_payload = payload::message;
+      break;
+
+    case payload::type_mismatch:
+      m_message = U"Expected " +
+        type_description(m_expected_type) +
+        U", got " +
+        type_description(m_actual_type) +
+        U" instead.";
+      m_payload = payload::message;
+      break;
+    }
+
+    return m_message;
+  }
+
+  void error::reset(const struct position* position)
+  {
+    if ((m_has_position = !!position))
+    {
+      // Assignment reuses memory already allocated for the file name.
+      m_position = *position;
+    }
+  }
+
+  void error::reset(enum value::type expected,
+                    enum value::type actual,
+                    const struct position* position)
   {
-    if (m_position)
+    if (m_expected_type != expected || m_actual_type != actual)
     {
-      delete m_position;
+      m_expected_type = expected;
+      m_actual_type = actual;
+      m_payload = payload::type_mismatch;
     }
+    reset(position);
   }
 
   std::u32string error::code_description() const
@@ -90,7 +159,7 @@ namespace plorth
 
     err = std::static_pointer_cast<error>(that);
 
-    return m_code == err->m_code && !m_message.compare(err->m_message);
+    return m_code == err->m_code && !message().compare(err->message());
   }
 
   std::u32string error::to_string() const
@@ -98,9 +167,9 @@ namespace plorth
     std::u32string result;
 
     result += code_description();
-    if (!m_message.empty())
+    if (!message().empty())
     {
-      result += U": " + m_message;
+      result += U": " + message();
     }
 
     return result;
@@ -242,10 +311,10 @@ namespace plorth
     {
       return
       {
-        { U"code", w_code },
-        { U"message", w_message },
-        { U"position", w_position },
-        { U"throw", w_throw },
+        { U"code", w_code, U"error -- error number" },
+        { U"message", w_message, U"error -- error string|null" },
+        { U"position", w_position, U"error -- error object|null" },
+        { U"throw", w_throw, U"error --" },
       };
     }
   }
@@ -0,0 +1,1360 @@
+/*
+ * Copyright (c) 2017-2018, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <plorth/context.hpp>
+#include <plorth/event-loop.hpp>
+#include <plorth/unicode.hpp>
+#include <plorth/value-file.hpp>
+#include <plorth/value-stream.hpp>
+#if PLORTH_ENABLE_FILE_IO
+# include <fcntl.h>
+# if HAVE_SYS_TYPES_H
+#  include <sys/types.h>
+# endif
+# if HAVE_SYS_STAT_H
+#  include <sys/stat.h>
+# endif
+# if HAVE_SYS_MMAN_H
+#  include <sys/mman.h>
+# endif
+# include <unistd.h>
+#endif
+#if PLORTH_ENABLE_EVENT_LOOP
+# include <poll.h>
+# include <signal.h>
+# include <sys/stat.h>
+# include <sys/socket.h>
+# include <sys/un.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include "./utils.hpp"
+
+namespace plorth
+{
+  namespace
+  {
+#if PLORTH_ENABLE_FILE_IO && HAVE_SYS_MMAN_H && HAVE_SYS_STAT_H
+    /**
+     * Implementation of byte sequence which reads it's contents directly
+     * from a memory mapped file.
+     */
+    class mapped_bytes : public bytes
+    {
+    public:
+      explicit mapped_bytes(void* address, size_type length)
+        : bytes(static_cast<const_pointer>(address), length)
+        , m_address(address) {}
+
+      ~mapped_bytes()
+      {
+        ::munmap(m_address, length());
+      }
+
+    private:
+      void* const m_address;
+    };
+#endif
+
+#if PLORTH_ENABLE_FILE_IO
+    static std::u32string describe_error(const std::u32string& path)
+    {
+      return U"Unable to open `" + path + U"': " + utf8_decode(
+        std::strerror(errno)
+      );
+    }
+#endif
+
+#if PLORTH_ENABLE_EVENT_LOOP
+    /**
+     * Fills Unix domain socket address from given path. Returns false if the
+     * path is too long to fit into the address.
+     */
+    static bool make_address(const std::string& path, struct sockaddr_un& addr)
+    {
+      std::memset(&addr, 0, sizeof(addr));
+      addr.sun_family = AF_UNIX;
+      if (path.empty() || path.length() >= sizeof(addr.sun_path))
+      {
+        errno = ENAMETOOLONG;
+
+        return false;
+      }
+      std::memcpy(addr.sun_path, path.c_str(), path.length());
+
+      return true;
+    }
+
+    /**
+     * Writes into a pipe with SIGPIPE blocked, so that a pipe whose read end
+     * has been closed fails the write with EPIPE instead of terminating the
+     * process.
+     */
+    static ssize_t write_pipe(int fd, const void* data, std::size_t length)
+    {
+      static const struct timespec no_wait = { 0, 0 };
+      sigset_t sigpipe;
+      sigset_t pending;
+      sigset_t previous;
+      ssize_t written;
+      int saved_errno;
+
+      sigemptyset(&sigpipe);
+      sigaddset(&sigpipe, SIGPIPE);
+      sigpending(&pending);
+      pthread_sigmask(SIG_BLOCK, &sigpipe, &previous);
+      written = ::write(fd, data, length);
+      saved_errno = errno;
+
+      // Discard the signal raised by the write, unless the signal had been
+      // raised already before it.
+      if (written < 0
+          && saved_errno == EPIPE
+          && !sigismember(&pending, SIGPIPE))
+      {
+        while (::sigtimedwait(&sigpipe, nullptr, &no_wait) < 0
+               && errno == EINTR);
+      }
+      pthread_sigmask(SIG_SETMASK, &previous, nullptr);
+      errno = saved_errno;
+
+      return written;
+    }
+#endif
+  }
+
+  file::file(int fd,
+             enum mode mode,
+             const std::u32string& path,
+             bool non_blocking)
+    : value(type::file)
+    , m_fd(fd)
+    , m_mode(mode)
+    , m_path(path)
+    , m_buffer(new unsigned char[buffer_size])
+    , m_offset(0)
+    , m_length(0)
+    , m_non_blocking(non_blocking)
+    , m_socket(false) {}
+
+  file::~file()
+  {
+    close();
+    delete[] m_buffer;
+  }
+
+  std::shared_ptr<file> file::open(const std::shared_ptr<context>& ctx,
+                                   const std::u32string& path,
+                                   enum mode mode)
+  {
+#if PLORTH_ENABLE_FILE_IO
+    const auto encoded_path = utf8_encode(path);
+    int flags = mode == mode::read ? O_RDONLY : O_WRONLY | O_CREAT | O_TRUNC;
+    int fd;
+
+# if defined(O_CLOEXEC)
+    flags |= O_CLOEXEC;
+# endif
+    do
+    {
+      fd = ::open(encoded_path.c_str(), flags, 0666);
+    }
+    while (fd < 0 && errno == EINTR);
+    if (fd < 0)
+    {
+      ctx->error(error::code::io, describe_error(path));
+
+      return std::shared_ptr<file>();
+    }
+
+    return ctx->runtime()->value<file>(fd, mode, path);
+#else
+    ctx->error(error::code::io, U"File I/O has been disabled.");
+
+    return std::shared_ptr<file>();
+#endif
+  }
+
+  bool file::pipe(const std::shared_ptr<context>& ctx,
+                  std::shared_ptr<file>& read_end,
+                  std::shared_ptr<file>& write_end)
+  {
+#if PLORTH_ENABLE_EVENT_LOOP
+    const auto& runtime = ctx->runtime();
+    int fds[2];
+
+    if (::pipe2(fds, O_NONBLOCK | O_CLOEXEC) != 0)
+    {
+      ctx->error(error::code::io, describe_error(U"pipe"));
+
+      return false;
+    }
+    read_end = runtime->value<file>(fds[0], mode::read, U"pipe", true);
+    write_end = runtime->value<file>(fds[1], mode::write, U"pipe", true);
+
+    return true;
+#else
+    ctx->error(error::code::io, U"Event loop has been disabled.");
+
+    return false;
+#endif
+  }
+
+  std::shared_ptr<file> file::connect(const std::shared_ptr<context>& ctx,
+                                      const std::u32string& path)
+  {
+#if PLORTH_ENABLE_EVENT_LOOP
+    struct sockaddr_un addr;
+    std::shared_ptr<file> result;
+    int fd;
+
+    if (!make_address(utf8_encode(path), addr)
+        || (fd = ::socket(
+          AF_UNIX,
+          SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
+          0
+        )) < 0)
+    {
+      ctx->error(error::code::io, describe_error(path));
+
+      return result;
+    }
+    if (::connect(
+      fd,
+      reinterpret_cast<const struct sockaddr*>(&addr),
+      sizeof(addr)
+    ) != 0 && errno != EINPROGRESS)
+    {
+      ctx->error(error::code::io, describe_error(path));
+      ::close(fd);
+
+      return result;
+    }
+    result = ctx->runtime()->value<file>(fd, mode::read_write, path, true);
+    result->m_socket = true;
+
+    return result;
+#else
+    ctx->error(error::code::io, U"Event loop has been disabled.");
+
+    return std::shared_ptr<file>();
+#endif
+  }
+
+  std::shared_ptr<file> file::listen(const std::shared_ptr<context>& ctx,
+                                     const std::u32string& path)
+  {
+#if PLORTH_ENABLE_EVENT_LOOP
+    const auto encoded_path = utf8_encode(path);
+    struct sockaddr_un addr;
+    struct stat st;
+    int fd;
+
+    if (!make_address(encoded_path, addr)
+        || (fd = ::socket(
+          AF_UNIX,
+          SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
+          0
+        )) < 0)
+    {
+      ctx->error(error::code::io, describe_error(path));
+
+      return std::shared_ptr<file>();
+    }
+    // Remove socket left behind by previous process listening in the same
+    // path. Other kinds of files are never removed.
+    if (!::lstat(encoded_path.c_str(), &st) && S_ISSOCK(st.st_mode))
+    {
+      ::unlink(encoded_path.c_str());
+    }
+    if (::bind(
+      fd,
+      reinterpret_cast<const struct sockaddr*>(&addr),
+      sizeof(addr)
+    ) != 0 || ::listen(fd, SOMAXCONN) != 0)
+    {
+      ctx->error(error::code::io, describe_error(path));
+      ::close(fd);
+
+      return std::shared_ptr<file>();
+    }
+
+    return ctx->runtime()->value<file>(fd, mode::read, path, true);
+#else
+    ctx->error(error::code::io, U"Event loop has been disabled.");
+
+    return std::shared_ptr<file>();
+#endif
+  }
+
+  std::shared_ptr<bytes> file::slurp_bytes(const std::shared_ptr<context>& ctx,
+                                           const std::u32string& path)
+  {
+#if PLORTH_ENABLE_FILE_IO
+    const auto& runtime = ctx->runtime();
+    const auto encoded_path = utf8_encode(path);
+    std::string buffer;
+    int fd;
+
+    do
+    {
+      fd = ::open(encoded_path.c_str(), O_RDONLY);
+    }
+    while (fd < 0 && errno == EINTR);
+    if (fd < 0)
+    {
+      ctx->error(error::code::io, describe_error(path));
+
+      return std::shared_ptr<bytes>();
+    }
+# if HAVE_SYS_MMAN_H && HAVE_SYS_STAT_H
+    struct stat st;
+
+    if (!::fstat(fd, &st) && S_ISREG(st.st_mode) && st.st_size > 0)
+    {
+      const auto length = static_cast<std::size_t>(st.st_size);
+      void* address = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+
+      if (address != MAP_FAILED)
+      {
+        ::close(fd);
+
+        return runtime->value<mapped_bytes>(address, length);
+      }
+    }
+# endif
+    // Files which cannot be mapped into memory, such as pipes, are read in
+    // chunks until the end of the file is encountered.
+    buffer.resize(buffer_size);
+    for (std::size_t length = 0;;)
+    {
+      const auto read = ::read(fd, &buffer[length], buffer.length() - length);
+
+      if (read < 0)
+      {
+        if (errno == EINTR)
+        {
+          continue;
+        }
+        ctx->error(error::code::io, describe_error(path));
+        ::close(fd);
+
+        return std::shared_ptr<bytes>();
+      }
+      else if (!read)
+      {
+        ::close(fd);
+
+        return runtime->bytes(
+          reinterpret_cast<bytes::const_pointer>(buffer.data()),
+          length
+        );
+      }
+      length += read;
+      if (length == buffer.length())
+      {
+        buffer.resize(buffer.length() * 2);
+      }
+    }
+#else
+    ctx->error(error::code::io, U"File I/O has been disabled.");
+
+    return std::shared_ptr<bytes>();
+#endif
+  }
+
+  std::shared_ptr<string> file::slurp(const std::shared_ptr<context>& ctx,
+                                      const std::u32string& path)
+  {
+    const auto contents = slurp_bytes(ctx, path);
+    std::shared_ptr<string> result;
+
+    if (!contents)
+    {
+      return result;
+    }
+    else if (!(result = bytes::decode(*ctx->runtime(), contents)))
+    {
+      ctx->error(error::code::io, U"Unable to decode file contents as UTF-8.");
+    }
+
+    return result;
+  }
+
+  io::input::result file::read_line(std::u32string& output)
+  {
+    const auto start = output.length();
+
+    if (!is_readable())
+    {
+      return io::input::result::failure;
+    }
+
+    // Continue from where previous call left off, if the file did not have
+    // the whole line available back then.
+    output.append(m_partial_line);
+    m_partial_line.clear();
+    for (;;)
+    {
+      io::input::result result;
+      char32_t c;
+
+      // Runs of ASCII characters are copied directly from the buffer.
+      while (m_offset < m_length
+             && m_buffer[m_offset] < 0x80
+             && m_buffer[m_offset] != '\n')
+      {
+        output.append(1, static_cast<char32_t>(m_buffer[m_offset++]));
+      }
+      if ((result = get(c)) == io::input::result::failure)
+      {
+        return result;
+      }
+      else if (result == io::input::result::would_block)
+      {
+        m_partial_line.assign(output, start, std::u32string::npos);
+        output.erase(start);
+
+        return result;
+      }
+      else if (result == io::input::result::eof)
+      {
+        return output.length() > start ? io::input::result::ok : result;
+      }
+      else if (c == '\n')
+      {
+        if (!output.empty() && output.back() == '\r')
+        {
+          output.pop_back();
+        }
+
+        return io::input::result::ok;
+      }
+      output.append(1, c);
+    }
+  }
+
+  io::input::result file::read_chunk(size_type size,
+                                     std::u32string& output,
+                                     size_type& read)
+  {
+    read = 0;
+    if (!is_readable())
+    {
+      return io::input::result::failure;
+    }
+    while (read < size)
+    {
+      char32_t c;
+      const auto result = get(c);
+
+      if (result != io::input::result::ok)
+      {
+        return result;
+      }
+      output.append(1, c);
+      ++read;
+    }
+
+    return io::input::result::ok;
+  }
+
+  io::input::result file::read_bytes(std::string& output)
+  {
+#if PLORTH_ENABLE_FILE_IO
+    long read;
+
+    if (!is_readable())
+    {
+      return io::input::result::failure;
+    }
+    if (m_offset >= m_length && (read = fill()) <= 0)
+    {
+      if (!read)
+      {
+        return io::input::result::eof;
+      }
+      else if (m_non_blocking && (errno == EAGAIN || errno == EWOULDBLOCK))
+      {
+        return io::input::result::ok;
+      }
+
+      return io::input::result::failure;
+    }
+    output.append(
+      reinterpret_cast<const char*>(m_buffer + m_offset),
+      m_length - m_offset
+    );
+    m_offset = m_length = 0;
+
+    return io::input::result::ok;
+#else
+    return io::input::result::failure;
+#endif
+  }
+
+  bool file::wait_readable()
+  {
+#if PLORTH_ENABLE_EVENT_LOOP
+    struct pollfd pfd;
+    int result;
+
+    if (!is_readable())
+    {
+      return false;
+    }
+    else if (!m_non_blocking)
+    {
+      return true;
+    }
+    pfd.fd = m_fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    do
+    {
+      result = ::poll(&pfd, 1, -1);
+    }
+    while (result < 0 && errno == EINTR);
+
+    return result > 0;
+#else
+    return is_readable();
+#endif
+  }
+
+  bool file::accept(const std::shared_ptr<context>& ctx,
+                    std::shared_ptr<file>& slot)
+  {
+#if PLORTH_ENABLE_EVENT_LOOP
+    int fd;
+
+    slot.reset();
+    if (!is_readable())
+    {
+      ctx->error(error::code::io, U"File has been closed.");
+
+      return false;
+    }
+    do
+    {
+      fd = ::accept4(m_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    }
+    while (fd < 0 && errno == EINTR);
+    if (fd < 0)
+    {
+      if (errno == EAGAIN || errno == EWOULDBLOCK)
+      {
+        return true;
+      }
+      ctx->error(
+        error::code::io,
+        U"Unable to accept connection: " + utf8_decode(std::strerror(errno))
+      );
+
+      return false;
+    }
+    slot = ctx->runtime()->value<file>(fd, mode::read_write, m_path, true);
+    slot->m_socket = true;
+
+    return true;
+#else
+    ctx->error(error::code::io, U"Event loop has been disabled.");
+
+    return false;
+#endif
+  }
+
+  bool file::write(const std::shared_ptr<string>& str)
+  {
+    const auto length = str->length();
+    string::value_type chunk[256];
+
+    if (!is_writable())
+    {
+      return false;
+    }
+    else if (m_non_blocking)
+    {
+      const auto encoded = utf8_encode(str->to_string());
+
+      return write_pending(encoded.data(), encoded.length());
+    }
+    for (size_type offset = 0; offset < length;)
+    {
+      const auto count = std::min<size_type>(length - offset, 256);
+
+      str->copy(offset, count, chunk);
+      offset += count;
+      for (size_type i = 0; i < count; ++i)
+      {
+        const auto c = chunk[i];
+
+        // Make sure that there is room for the longest possible UTF-8
+        // sequence before encoding the character into the buffer.
+        if (m_length + 4 > buffer_size && !flush())
+        {
+          return false;
+        }
+        if (c < 0x80)
+        {
+          m_buffer[m_length++] = static_cast<unsigned char>(c);
+        }
+        else if (!unicode_validate(c))
+        {
+          continue;
+        }
+        else if (c < 0x800)
+        {
+          m_buffer[m_length++] = static_cast<unsigned char>(0xc0 | (c >> 6));
+          m_buffer[m_length++] = static_cast<unsigned char>(0x80 | (c & 0x3f));
+        }
+        else if (c < 0x10000)
+        {
+          m_buffer[m_length++] = static_cast<unsigned char>(0xe0 | (c >> 12));
+          m_buffer[m_length++] = static_cast<unsigned char>(
+            0x80 | ((c >> 6) & 0x3f)
+          );
+          m_buffer[m_length++] = static_cast<unsigned char>(0x80 | (c & 0x3f));
+        } else {
+          m_buffer[m_length++] = static_cast<unsigned char>(0xf0 | (c >> 18));
+          m_buffer[m_length++] = static_cast<unsigned char>(
+            0x80 | ((c >> 12) & 0x3f)
+          );
+          m_buffer[m_length++] = static_cast<unsigned char>(
+            0x80 | ((c >> 6) & 0x3f)
+          );
+          m_buffer[m_length++] = static_cast<unsigned char>(0x80 | (c & 0x3f));
+        }
+      }
+    }
+
+    return true;
+  }
+
+  bool file::write(const std::shared_ptr<bytes>& b)
+  {
+    auto data = b->data();
+    auto remaining = b->length();
+
+    if (!is_writable())
+    {
+      return false;
+    }
+    else if (m_non_blocking)
+    {
+      return write_pending(reinterpret_cast<const char*>(data), remaining);
+    }
+    while (remaining > 0)
+    {
+      std::size_t count;
+
+      if (m_length == buffer_size && !flush())
+      {
+        return false;
+      }
+      count = std::min(remaining, buffer_size - m_length);
+      std::memcpy(m_buffer + m_length, data, count);
+      m_length += count;
+      data += count;
+      remaining -= count;
+    }
+
+    return true;
+  }
+
+  bool file::flush()
+  {
+#if PLORTH_ENABLE_FILE_IO
+    std::size_t offset = 0;
+
+    if (!is_writable())
+    {
+      return false;
+    }
+    else if (m_non_blocking)
+    {
+      // Output of non-blocking files is kept in a separate pending buffer so
+      // that the primary buffer remains available for reading from sockets.
+      while (offset < m_pending.length())
+      {
+        const auto data = m_pending.data() + offset;
+        const auto length = m_pending.length() - offset;
+# if PLORTH_ENABLE_EVENT_LOOP
+        // Sockets are written with send() and pipes with SIGPIPE blocked,
+        // so that a peer which has closed the connection does not terminate
+        // the process with SIGPIPE.
+        const auto written = m_socket
+          ? ::send(m_fd, data, length, MSG_NOSIGNAL)
+          : write_pipe(m_fd, data, length);
+# else
+        const auto written = ::write(m_fd, data, length);
+# endif
+
+        if (written < 0)
+        {
+          if (errno == EINTR)
+          {
+            continue;
+          }
+          else if (errno == EAGAIN || errno == EWOULDBLOCK)
+          {
+            break;
+          }
+          // Output which cannot be delivered is discarded, so that the file
+          // does not remain writable forever.
+          m_pending.clear();
+
+          return false;
+        }
+        offset += written;
+      }
+      m_pending.erase(0, offset);
+
+      return true;
+    }
+    while (offset < m_length)
+    {
+      const auto written = ::write(m_fd, m_buffer + offset, m_length - offset);
+
+      if (written < 0)
+      {
+        if (errno == EINTR)
+        {
+          continue;
+        }
+
+        return false;
+      }
+      offset += written;
+    }
+    m_length = 0;
+
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  bool file::close()
+  {
+#if PLORTH_ENABLE_FILE_IO
+    bool result = true;
+
+    if (!is_open())
+    {
+      return true;
+    }
+    if (m_mode != mode::read)
+    {
+      result = flush();
+    }
+    m_pending.clear();
+    m_partial_line.clear();
+    m_partial_sequence.clear();
+    if (::close(m_fd) != 0)
+    {
+      result = false;
+    }
+    m_fd = -1;
+    m_offset = m_length = 0;
+
+    return result;
+#else
+    return true;
+#endif
+  }
+
+  io::input::result file::get(char32_t& c)
+  {
+    std::u32string decoded;
+    std::size_t size;
+    long read;
+
+    // UTF-8 sequence may have been split between two reads from
+    // non-blocking file, in which case the beginning of it has already been
+    // consumed.
+    if (m_partial_sequence.empty())
+    {
+      if (m_offset >= m_length && (read = fill()) <= 0)
+      {
+        if (!read)
+        {
+          return io::input::result::eof;
+        }
+        else if (m_non_blocking && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+          return io::input::result::would_block;
+        }
+
+        return io::input::result::failure;
+      }
+      if (m_buffer[m_offset] < 0x80)
+      {
+        c = m_buffer[m_offset++];
+
+        return io::input::result::ok;
+      }
+      m_partial_sequence.append(1, static_cast<char>(m_buffer[m_offset++]));
+    }
+    size = utf8_sequence_length(
+      static_cast<unsigned char>(m_partial_sequence[0])
+    );
+    if (!size || size > 4)
+    {
+      m_partial_sequence.clear();
+
+      return io::input::result::failure;
+    }
+    while (m_partial_sequence.length() < size)
+    {
+      if (m_offset >= m_length && (read = fill()) <= 0)
+      {
+        if (read < 0
+            && m_non_blocking
+            && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+          return io::input::result::would_block;
+        }
+        m_partial_sequence.clear();
+
+        return io::input::result::failure;
+      }
+      m_partial_sequence.append(1, static_cast<char>(m_buffer[m_offset++]));
+    }
+    if (!utf8_decode_test(m_partial_sequence, decoded)
+        || decoded.length() != 1)
+    {
+      m_partial_sequence.clear();
+
+      return io::input::result::failure;
+    }
+    m_partial_sequence.clear();
+    c = decoded[0];
+
+    return io::input::result::ok;
+  }
+
+  bool file::write_pending(const char* data, std::size_t length)
+  {
+    m_pending.append(data, length);
+
+    return flush();
+  }
+
+  long file::fill()
+  {
+#if PLORTH_ENABLE_FILE_IO
+    ssize_t read;
+
+    m_offset = m_length = 0;
+    do
+    {
+      read = ::read(m_fd, m_buffer, buffer_size);
+    }
+    while (read < 0 && errno == EINTR);
+    if (read > 0)
+    {
+      m_length = static_cast<std::size_t>(read);
+    }
+
+    return static_cast<long>(read);
+#else
+    return -1;
+#endif
+  }
+
+  bool file::equals(const std::shared_ptr<value>& that) const
+  {
+    return that.get() == this;
+  }
+
+  std::u32string file::to_string() const
+  {
+    return m_path;
+  }
+
+  std::u32string file::to_source() const
+  {
+    return U"<file " + json_stringify(m_path) + U">";
+  }
+
+  static bool pop_file(const std::shared_ptr<context>& ctx,
+                       std::shared_ptr<file>& slot,
+                       enum file::mode mode)
+  {
+    std::shared_ptr<value> f;
+
+    if (!ctx->pop(f, value::type::file))
+    {
+      return false;
+    }
+    slot = std::static_pointer_cast<file>(f);
+    if (!slot->is_open())
+    {
+      ctx->error(error::code::io, U"File has been closed.");
+
+      return false;
+    }
+    else if (mode == file::mode::read ? !slot->is_readable()
+                                      : !slot->is_writable())
+    {
+      ctx->error(
+        error::code::io,
+        mode == file::mode::read
+          ? U"File has not been opened for reading."
+          : U"File has not been opened for writing."
+      );
+
+      return false;
+    }
+
+    return true;
+  }
+
+#if PLORTH_ENABLE_EVENT_LOOP
+  static bool pop_watchable_file(const std::shared_ptr<context>& ctx,
+                                 std::shared_ptr<file>& slot)
+  {
+    std::shared_ptr<value> f;
+
+    if (!ctx->pop(f, value::type::file))
+    {
+      return false;
+    }
+    slot = std::static_pointer_cast<file>(f);
+    if (!slot->is_open())
+    {
+      ctx->error(error::code::io, U"File has been closed.");
+
+      return false;
+    }
+    else if (!slot->is_non_blocking())
+    {
+      ctx->error(error::code::io, U"File is not in non-blocking mode.");
+
+      return false;
+    }
+
+    return true;
+  }
+
+  static void watch(const std::shared_ptr<context>& ctx,
+                    enum event_loop::event event)
+  {
+    std::shared_ptr<file> f;
+    std::shared_ptr<quote> callback;
+
+    if (pop_watchable_file(ctx, f) && ctx->pop_quote(callback))
+    {
+      ctx->runtime()->event_loop().watch(f, event, callback);
+      ctx->push(f);
+    }
+  }
+#endif
+
+  /**
+   * Word: read-line
+   * Prototype: file
+   *
+   * Takes:
+   * - file
+   *
+   * Gives:
+   * - file
+   * - string|null
+   *
+   * Reads single line from the file. The line separator is not included in
+   * the resulting string. If end of the file has been reached, null will be
+   * returned instead. Files in non-blocking mode also give null when the
+   * whole line cannot be read without blocking, and the part of the line
+   * read so far is returned by a later call, once the rest of the line is
+   * available.
+   *
+   *     "input.txt" open-read read-line #=> <file "input.txt"> "first line"
+   */
+  static void w_read_line(const std::shared_ptr<context>& ctx)
+  {
+    std::shared_ptr<file> f;
+
+    if (pop_file(ctx, f, file::mode::read))
+    {
+      std::u32string output;
+      const auto result = f->read_line(output);
+
+      if (result == io::input::result::failure)
+      {
+        ctx->error(error::code::io, U"Unable to read file as UTF-8.");
+        return;
+      }
+      ctx->push(f);
+      if (result != io::input::result::ok)
+      {
+        ctx->push_null();
+      } else {
+        ctx->push_string(output);
+      }
+    }
+  }
+
+  /**
+   * Word: lines
+   * Prototype: file
+   *
+   * Takes:
+   * - file
+   *
+   * Gives:
+   * - file
+   * - stream
+   *
+   * Returns a stream which reads lines from the file, one line at a time.
+   * Line separators are not included in the lines.
+   *
+   *     "input.txt" open-read lines nip ( println ) swap for-each
+   */
+  static void w_lines(const std::shared_ptr<context>& ctx)
+  {
+    std::shared_ptr<file> f;
+
+    if (pop_file(ctx, f, file::mode::read))
+    {
+      ctx->push(f);
+      ctx->push(stream::lines(*ctx->runtime(), f));
+    }
+  }
+
+  /**
+   * Word: read-chunk
+   * Prototype: file
+   *
+   * Takes:
+   * - number
+   * - file
+   *
+   * Gives:
+   * - file
+   * - string|null
+   *
+   * Reads given number of Unicode characters from the file. If end of the
+   * file has been reached, null will be returned instead. The resulting
+   * string might have less than given number of characters if there isn't
+   * that much characters left in the file, or if the file is in non-blocking
+   * mode and the rest of the characters cannot be read without blocking.
+   */
+  static void w_read_chunk(const std::shared_ptr<context>& ctx)
+  {
+    std::shared_ptr<file> f;
+    std::shared_ptr<number> num;
+
+    if (pop_file(ctx, f, file::mode::read) && ctx->pop_number(num))
+    {
+      const number::int_type amount = num->as_int();
+      std::u32string output;
+      file::size_type read;
+      io::input::result result;
+
+      if (amount <= 0)
+      {
+        ctx->error(
+          error::code::range,
+          amount < 0 ? U"Negative size to be read." : U"Zero size to be read."
+        );
+        return;
+      }
+      result = f->read_chunk(amount, output, read);
+      if (result == io::input::result::failure)
+      {
+        ctx->error(error::code::io, U"Unable to read file as UTF-8.");
+        return;
+      }
+      ctx->push(f);
+      if (result == io::input::result::eof && output.empty())
+      {
+        ctx->push_null();
+      } else {
+        ctx->push_string(output);
+      }
+    }
+  }
+
+  /**
+   * Word: read-bytes
+   * Prototype: file
+   *
+   * Takes:
+   * - file
+   *
+   * Gives:
+   * - file
+   * - bytes|null
+   *
+   * Reads whatever input is currently available from the file as a byte
+   * sequence. Files in non-blocking mode give an empty byte sequence when
+   * there is nothing to be read without blocking. If end of the file has been
+   * reached, null will be returned instead.
+   *
+   *     ( read-bytes nip >string println ) swap on-readable
+   */
+  static void w_read_bytes(const std::shared_ptr<context>& ctx)
+  {
+    std::shared_ptr<file> f;
+
+    if (pop_file(ctx, f, file::mode::read))
+    {
+      std::string output;
+      const auto result = f->read_bytes(output);
+
+      if (result == io::input::result::failure)
+      {
+        ctx->error(error::code::io, U"Unable to read file.");
+        return;
+      }
+      ctx->push(f);
+      if (result == io::input::result::eof)
+      {
+        ctx->push_null();
+      } else {
+        ctx->push(ctx->runtime()->bytes(
+          reinterpret_cast<bytes::const_pointer>(output.data()),
+          output.length()
+        ));
+      }
+    }
+  }
+
+  /**
+   * Word: accept
+   * Prototype: file
+   *
+   * Takes:
+   * - file
+   *
+   * Gives:
+   * - file
+   * - file|null
+   *
+   * Accepts pending connection from Unix domain socket created with
+   * `unix-listen`. The connection is in non-blocking mode. If there are no
+   * pending connections, null will be returned instead.
+   *
+   *     "/tmp/app.sock" unix-listen accept
+   */
+  static void w_accept(const std::shared_ptr<context>& ctx)
+  {
+    std::shared_ptr<file> f;
+    std::shared_ptr<file> connection;
+
+    if (pop_file(ctx, f, file::mode::read) && f->accept(ctx, connection))
+    {
+      ctx->push(f);
+      ctx->push(connection);
+    }
+  }
+
+  /**
+   * Word: on-readable
+   * Prototype: file
+   *
+   * Takes:
+   * - quote
+   * - file
+   *
+   * Gives:
+   * - file
+   *
+   * Registers quote which the event loop calls with the file whenever there
+   * is input to be read from the file, or when the other end has been
+   * closed. The quote keeps on being called until the file is closed or no
+   * longer watched, so it should read the available input. Only files in
+   * non-blocking mode, such as pipes and Unix domain sockets, can be watched.
+   *
+   *     ( read-bytes nip >string println ) swap on-readable
+   */
+  static void w_on_readable(const std::shared_ptr<context>& ctx)
+  {
+#if PLORTH_ENABLE_EVENT_LOOP
+    watch(ctx, event_loop::event::readable);
+#else
+    ctx->error(error::code::io, U"Event loop has been disabled.");
+#endif
+  }
+
+  /**
+   * Word: on-writable
+   * Prototype: file
+   *
+   * Takes:
+   * - quote
+   * - file
+   *
+   * Gives:
+   * - file
+   *
+   * Registers quote which the event loop calls with the file whenever output
+   * can be written into the file without blocking. Pending output is always
+   * written before the quote is called. The quote keeps on being called until
+   * the file is closed or no longer watched.
+   *
+   *     ( "hello" swap write unwatch drop ) swap on-writable
+   */
+  static void w_on_writable(const std::shared_ptr<context>& ctx)
+  {
+#if PLORTH_ENABLE_EVENT_LOOP
+    watch(ctx, event_loop::event::writable);
+#else
+    ctx->error(error::code::io, U"Event loop has been disabled.");
+#endif
+  }
+
+  /**
+   * Word: unwatch
+   * Prototype: file
+   *
+   * Takes:
+   * - file
+   *
+   * Gives:
+   * - file
+   *
+   * Removes quotes registered with `on-readable` and `on-writable` from the
+   * file. Pending output of the file is still written by the event loop.
+   */
+  static void w_unwatch(const std::shared_ptr<context>& ctx)
+  {
+#if PLORTH_ENABLE_EVENT_LOOP
+    std::shared_ptr<value> f;
+
+    if (ctx->pop(f, value::type::file))
+    {
+      ctx->runtime()->event_loop().unwatch(std::static_pointer_cast<file>(f));
+      ctx->push(f);
+    }
+#else
+    ctx->error(error::code::io, U"Event loop has been disabled.");
+#endif
+  }
+
+  /**
+   * Word: write
+   * Prototype: file
+   *
+   * Takes:
+   * - any
+   * - file
+   *
+   * Gives:
+   * - file
+   *
+   * Writes the value given as second topmost value of the stack into the
+   * file as UTF-8 encoded text. Byte sequences are written as they are.
+   * Other values which are not strings are converted into strings first.
+   * Null is ignored. Written text is buffered until the
+   * buffer is full or the file is closed. Files in non-blocking mode write as
+   * much as they can immediately, and the event loop writes the rest once
+   * the file becomes writable.
+   *
+   *     "output.txt" open-write "foo\n" swap write close
+   */
+  static void w_write(const std::shared_ptr<context>& ctx)
+  {
+    std::shared_ptr<file> f;
+    std::shared_ptr<value> val;
+
+    if (pop_file(ctx, f, file::mode::write) && ctx->pop(val))
+    {
+      bool result = true;
+
+      if (value::is(val, value::type::string))
+      {
+        result = f->write(std::static_pointer_cast<string>(val));
+      }
+      else if (value::is(val, value::type::bytes))
+      {
+        result = f->write(std::static_pointer_cast<bytes>(val));
+      }
+      else if (val)
+      {
+        result = f->write(ctx->runtime()->string(val->to_string()));
+      }
+      if (!result)
+      {
+        ctx->error(error::code::io, U"Unable to write into file.");
+        return;
+      }
+#if PLORTH_ENABLE_EVENT_LOOP
+      if (f->has_pending_output())
+      {
+        ctx->runtime()->event_loop().flush_later(f);
+      }
+#endif
+      ctx->push(f);
+    }
+  }
+
+  /**
+   * Word: close
+   * Prototype: file
+   *
+   * Takes:
+   * - file
+   *
+   * Closes the file. Buffered output of files opened for writing is written
+   * into the file first. Files are also closed automatically once they are
+   * no longer referenced.
+   */
+  static void w_close(const std::shared_ptr<context>& ctx)
+  {
+    std::shared_ptr<value> f;
+
+    if (ctx->pop(f, value::type::file)
+        && !std::static_pointer_cast<file>(f)->close())
+    {
+      ctx->error(error::code::io, U"Unable to close file.");
+    }
+  }
+
+  namespace api
+  {
+    runtime::prototype_definition file_prototype()
+    {
+      return
+      {
+        { U"read-line", w_read_line, U"file -- file string|null" },
+        { U"lines", w_lines, U"file -- file stream" },
+        { U"read-chunk", w_read_chunk, U"number file -- file string|null" },
+        { U"read-bytes", w_read_bytes, U"file -- file bytes|null" },
+        { U"accept", w_accept, U"file -- file file|null" },
+        { U"on-readable", w_on_readable, U"quote file -- file" },
+        { U"on-writable", w_on_writable, U"quote file -- file" },
+        { U"unwatch", w_unwatch, U"file -- file" },
+        { U"write", w_write, U"any file -- file" },
+        { U"close", w_close, U"file --" },
+      };
+    }
+  }
+}
@@ -49,12 +49,8 @@ namespace plorth
     {
     public:
       explicit int_number(int_type val)
-        : m_value(val) {}
-
-      enum number_type number_type() const
-      {
-        return number_type::integer;
-      }
+        : number(number_type::integer)
+        , m_value(val) {}
 
       int_type as_int() const
       {
@@ -66,6 +62,14 @@ namespace plorth
         return static_cast<number::real_type>(m_value);
       }
 
+      /**
+       * Non-virtual accessor for the value, used by the arithmetic kernels.
+       */
+      inline int_type value() const
+      {
+        return m_value;
+      }
+
     private:
       const int_type m_value;
     };
@@ -74,12 +78,8 @@ namespace plorth
     {
     public:
       explicit real_number(number::real_type val)
-        : m_value(val) {}
-
-      enum number_type number_type() const
-      {
-        return number_type::real;
-      }
+        : number(number_type::real)
+        , m_value(val) {}
 
       int_type as_int() const
       {
@@ -102,11 +102,38 @@ namespace plorth
         return m_value;
       }
 
+      /**
+       * Non-virtual accessor for the value, used by the arithmetic kernels.
+       */
+      inline real_type value() const
+      {
+        return m_value;
+      }
+
     private:
       const real_type m_value;
     };
+
+    inline number::int_type int_value(const std::shared_ptr<number>& num)
+    {
+      return static_cast<const int_number*>(num.get())->value();
+    }
+
+    inline number::real_type real_value(const std::shared_ptr<number>& num)
+    {
+      if (num->is(number::number_type::integer))
+      {
+        return static_cast<number::real_type>(int_value(num));
+      }
+
+      return static_cast<const real_number*>(num.get())->value();
+    }
   }
 
+  number::number(enum number_type number_type)
+    : value(type::number)
+    , m_number_type(number_type) {}
+
   bool number::equals(const std::shared_ptr<class value>& that) const
   {
     std::shared_ptr<number> num;
@@ -142,22 +169,17 @@ namespace plorth
   std::shared_ptr<number> runtime::number(number::int_type value)
   {
 #if PLORTH_ENABLE_INTEGER_CACHE
-    static const int offset = 128;
-
-    if (value >= -128 && value <= 127)
+    if (value >= PLORTH_INTEGER_CACHE_MIN && value <= PLORTH_INTEGER_CACHE_MAX)
     {
-      const int index = value + offset;
-      auto reference = m_integer_cache[index];
+      // Cache is populated when the runtime is being constructed.
+      const auto& reference = m_integer_cache[
+        value - PLORTH_INTEGER_CACHE_MIN
+      ];
 
-      if (!reference)
+      if (reference)
       {
-        reference = std::shared_ptr<class number>(
-          new (*m_memory_manager) int_number(value)
-        );
-        m_integer_cache[index] = reference;
+        return reference;
       }
-
-      return reference;
     }
 #endif
 
@@ -203,6 +225,26 @@ namespace plorth
     }
   }
 
+  /**
+   * Pops number from the data stack. Words which take only numbers are
+   * instantiated with and without the checks. Variants without them are
+   * called only after the caller has verified that the stack contains the
+   * numbers.
+   */
+  template<bool Checked>
+  static inline bool pop_number(const std::shared_ptr<context>& ctx,
+                                std::shared_ptr<number>& slot)
+  {
+    if (!Checked)
+    {
+      ctx->pop_unchecked(slot);
+
+      return true;
+    }
+
+    return ctx->pop_number(slot);
+  }
+
   /**
    * Word: nan?
    * Prototype: number
@@ -216,11 +258,12 @@ namespace plorth
    *
    * Returns true if given number is NaN.
    */
+  template<bool Checked>
   static void w_is_nan(const std::shared_ptr<context>& ctx)
   {
     std::shared_ptr<number> num;
 
-    if (ctx->pop_number(num))
+    if (pop_number<Checked>(ctx, num))
     {
       ctx->push(num);
       if (num->is(number::number_type::real))
@@ -245,11 +288,12 @@ namespace plorth
    *
    * Returns true if given number is finite.
    */
+  template<bool Checked>
   static void w_is_finite(const std::shared_ptr<context>& ctx)
   {
     std::shared_ptr<number> num;
 
-    if (ctx->pop_number(num))
+    if (pop_number<Checked>(ctx, num))
     {
       ctx->push(num);
       if (num->is(number::number_type::real))
@@ -307,11 +351,12 @@ namespace plorth
    *
    * Returns absolute value of the number.
    */
+  template<bool Checked>
   static void w_abs(const std::shared_ptr<context>& ctx)
   {
     std::shared_ptr<number> num;
 
-    if (ctx->pop_number(num))
+    if (pop_number<Checked>(ctx, num))
     {
       if (num->is(number::number_type::real))
       {
@@ -334,11 +379,12 @@ namespace plorth
    *
    * Rounds given number to nearest integer value.
    */
+  template<bool Checked>
   static void w_round(const std::shared_ptr<context>& ctx)
   {
     std::shared_ptr<number> num;
 
-    if (ctx->pop_number(num))
+    if (pop_number<Checked>(ctx, num))
     {
       if (num->is(number::number_type::real))
       {
@@ -361,11 +407,12 @@ namespace plorth
    *
    * Computes the smallest integer value not less than given number.
    */
+  template<bool Checked>
   static void w_ceil(const std::shared_ptr<context>& ctx)
   {
     std::shared_ptr<number> num;
 
-    if (ctx->pop_number(num))
+    if (pop_number<Checked>(ctx, num))
     {
       if (num->is(number::number_type::real))
       {
@@ -388,11 +435,12 @@ namespace plorth
    *
    * Computes the largest integer value not greater than given number.
    */
+  template<bool Checked>
   static void w_floor(const std::shared_ptr<context>& ctx)
   {
     std::shared_ptr<number> num;
 
-    if (ctx->pop_number(num))
+    if (pop_number<Checked>(ctx, num))
     {
       if (num->is(number::number_type::real))
       {
@@ -416,12 +464,13 @@ namespace plorth
    *
    * Returns maximum of two numbers.
    */
+  template<bool Checked>
   static void w_max(const std::shared_ptr<context>& ctx)
   {
     std::shared_ptr<number> a;
     std::shared_ptr<number> b;
 
-    if (ctx->pop_number(b) && ctx->pop_number(a))
+    if (pop_number<Checked>(ctx, b) && pop_number<Checked>(ctx, a))
     {
       if (a->is(number::number_type::real) || b->is(number::number_type::real))
       {
@@ -445,12 +494,13 @@ namespace plorth
    *
    * Returns minimum of two numbers.
    */
+  template<bool Checked>
   static void w_min(const std::shared_ptr<context>& ctx)
   {
     std::shared_ptr<number> a;
     std::shared_ptr<number> b;
 
-    if (ctx->pop_number(b) && ctx->pop_number(a))
+    if (pop_number<Checked>(ctx, b) && pop_number<Checked>(ctx, a))
     {
       if (a->is(number::number_type::real) || b->is(number::number_type::real))
       {
@@ -475,13 +525,16 @@ namespace plorth
    *
    * Clamps the topmost number between the minimum and maximum limits.
    */
+  template<bool Checked>
   static void w_clamp(const std::shared_ptr<context>& ctx)
   {
     std::shared_ptr<number> a;
     std::shared_ptr<number> b;
     std::shared_ptr<number> c;
 
-    if (ctx->pop_number(c) && ctx->pop_number(b) && ctx->pop_number(a))
+    if (pop_number<Checked>(ctx, c)
+        && pop_number<Checked>(ctx, b)
+        && pop_number<Checked>(ctx, a))
     {
       if (a->is(number::number_type::real)
           || b->is(number::number_type::real)
@@ -533,13 +586,16 @@ namespace plorth
    * Tests whether the topmost number is in range of given minimum and maximum
    * numbers.
    */
+  template<bool Checked>
   static void w_is_in_range(const std::shared_ptr<context>& ctx)
   {
     std::shared_ptr<number> a;
     std::shared_ptr<number> b;
     std::shared_ptr<number> c;
 
-    if (ctx->pop_number(c) && ctx->pop_number(b) && ctx->pop_number(a))
+    if (pop_number<Checked>(ctx, c)
+        && pop_number<Checked>(ctx, b)
+        && pop_number<Checked>(ctx, a))
     {
       if (a->is(number::number_type::real)
           || b->is(number::number_type::real)
@@ -560,36 +616,111 @@ namespace plorth
     }
   }
 
-  template<class RealOperation, class IntOperation>
+  static inline bool int_add(number::int_type a,
+                             number::int_type b,
+                             number::int_type& result)
+  {
+#if defined(__GNUC__) || defined(__clang__)
+    return !__builtin_add_overflow(a, b, &result);
+#else
+    if ((b > 0 && a > number::int_max - b) || (b < 0 && a < number::int_min - b))
+    {
+      return false;
+    }
+    result = a + b;
+
+    return true;
+#endif
+  }
+
+  static inline bool int_sub(number::int_type a,
+                             number::int_type b,
+                             number::int_type& result)
+  {
+#if defined(__GNUC__) || defined(__clang__)
+    return !__builtin_sub_overflow(a, b, &result);
+#else
+    if ((b < 0 && a > number::int_max + b) || (b > 0 && a < number::int_min + b))
+    {
+      return false;
+    }
+    result = a - b;
+
+    return true;
+#endif
+  }
+
+  static inline bool int_mul(number::int_type a,
+                             number::int_type b,
+                             number::int_type& result)
+  {
+#if defined(__GNUC__) || defined(__clang__)
+    return !__builtin_mul_overflow(a, b, &result);
+#else
+    if (a > 0)
+    {
+      if ((b > 0 && a > number::int_max / b) ||
+          (b < 0 && b < number::int_min / a))
+      {
+        return false;
+      }
+    }
+    else if (a < 0)
+    {
+      if ((b > 0 && a < number::int_min / b) ||
+          (b < 0 && a < number::int_max / b))
+      {
+        return false;
+      }
+    }
+    result = a * b;
+
+    return true;
+#endif
+  }
+
+  /**
+   * Arithmetic kernel shared by the "+", "-" and "*" words. Two integers are
+   * computed with checked integer arithmetic and promoted into real number only
+   * when the operation overflows. In every other case both operands are
+   * converted into real numbers exactly once.
+   */
+  template<bool Checked, class RealOperation>
   static void number_op(
     const std::shared_ptr<context>& ctx,
     const RealOperation& real_op,
-    const IntOperation& int_op
+    bool (*int_op)(number::int_type, number::int_type, number::int_type&)
   )
   {
     std::shared_ptr<number> a;
     std::shared_ptr<number> b;
-    number::real_type result;
 
-    if (!ctx->pop_number(b) || !ctx->pop_number(a))
+    if (!pop_number<Checked>(ctx, b) || !pop_number<Checked>(ctx, a))
     {
       return;
     }
 
-    result = real_op(a->as_real(), b->as_real());
-
     if (a->is(number::number_type::integer) &&
-        b->is(number::number_type::integer) &&
-        std::fabs(result) <= number::int_max)
+        b->is(number::number_type::integer))
     {
-      // Repeat the operation with full integer precision
-      ctx->push_int(int_op(a->as_int(), b->as_int()));
+      const auto x = int_value(a);
+      const auto y = int_value(b);
+      number::int_type result;
+
+      if (int_op(x, y, result))
+      {
+        ctx->push_int(result);
+      } else {
+        // Integer overflow. Keep it real.
+        ctx->push_real(real_op(
+          static_cast<number::real_type>(x),
+          static_cast<number::real_type>(y)
+        ));
+      }
       return;
     }
 
-    // Otherwise keep it real as it seems to be integer overflow or either of
-    // the arguments are real numbers.
-    ctx->push_real(result);
+    ctx->push_real(real_op(real_value(a), real_value(b)));
   }
 
   /**
@@ -605,9 +736,10 @@ namespace plorth
    *
    * Performs addition on the two given numbers.
    */
+  template<bool Checked>
   static void w_add(const std::shared_ptr<context>& ctx)
   {
-    number_op(ctx, std::plus<number::real_type>(), std::plus<number::int_type>());
+    number_op<Checked>(ctx, std::plus<number::real_type>(), int_add);
   }
 
   /**
@@ -623,9 +755,10 @@ namespace plorth
    *
    * Subtracts the second number from the first and returns the result.
    */
+  template<bool Checked>
   static void w_sub(const std::shared_ptr<context>& ctx)
   {
-    number_op(ctx, std::minus<number::real_type>(), std::minus<number::int_type>());
+    number_op<Checked>(ctx, std::minus<number::real_type>(), int_sub);
   }
 
   /**
@@ -641,9 +774,10 @@ namespace plorth
    *
    * Performs multiplication on the two given numbers.
    */
+  template<bool Checked>
   static void w_mul(const std::shared_ptr<context>& ctx)
   {
-    number_op(ctx, std::multiplies<number::real_type>(), std::multiplies<number::int_type>());
+    number_op<Checked>(ctx, std::multiplies<number::real_type>(), int_mul);
   }
 
   /**
@@ -659,12 +793,13 @@ namespace plorth
    *
    * Divides the first number by the second and returns the result.
    */
+  template<bool Checked>
   static void w_div(const std::shared_ptr<context>& ctx)
   {
     std::shared_ptr<number> a;
     std::shared_ptr<number> b;
 
-    if (ctx->pop_number(b) && ctx->pop_number(a))
+    if (pop_number<Checked>(ctx, b) && pop_number<Checked>(ctx, a))
     {
       ctx->push_real(a->as_real() / b->as_real());
     }
@@ -684,6 +819,7 @@ namespace plorth
    * Computes the modulo of the first number with respect to the second number
    * i.e. the remainder after floor division.
    */
+  template<bool Checked>
   static void w_mod(const std::shared_ptr<context>& ctx)
   {
     std::shared_ptr<number> a;
@@ -692,7 +828,7 @@ namespace plorth
     number::real_type divider;
     number::real_type result;
 
-    if (ctx->pop_number(b) && ctx->pop_number(a))
+    if (pop_number<Checked>(ctx, b) && pop_number<Checked>(ctx, a))
     {
       dividend = a->as_real();
       divider = b->as_real();
@@ -704,14 +840,14 @@ namespace plorth
     }
   }
 
-  template<typename Operation >
+  template<bool Checked, typename Operation>
   static void number_bit_op(const std::shared_ptr<context>& ctx,
                             const Operation& op)
   {
     std::shared_ptr<number> a;
     std::shared_ptr<number> b;
 
-    if (ctx->pop_number(b) && ctx->pop_number(a))
+    if (pop_number<Checked>(ctx, b) && pop_number<Checked>(ctx, a))
     {
       ctx->push_int(op(a->as_int(), b->as_int()));
     }
@@ -730,9 +866,10 @@ namespace plorth
    *
    * Performs bitwise and on the two given numbers.
    */
+  template<bool Checked>
   static void w_bit_and(const std::shared_ptr<context>& ctx)
   {
-    number_bit_op(ctx, std::bit_and<number::int_type>());
+    number_bit_op<Checked>(ctx, std::bit_and<number::int_type>());
   }
 
   /**
@@ -748,9 +885,10 @@ namespace plorth
    *
    * Performs bitwise or on the two given numbers.
    */
+  template<bool Checked>
   static void w_bit_or(const std::shared_ptr<context>& ctx)
   {
-    number_bit_op(ctx, std::bit_or<number::int_type>());
+    number_bit_op<Checked>(ctx, std::bit_or<number::int_type>());
   }
 
   /**
@@ -766,9 +904,10 @@ namespace plorth
    *
    * Performs bitwise xor on the two given numbers.
    */
+  template<bool Checked>
   static void w_bit_xor(const std::shared_ptr<context>& ctx)
   {
-    number_bit_op(ctx, std::bit_xor<number::int_type>());
+    number_bit_op<Checked>(ctx, std::bit_xor<number::int_type>());
   }
 
   /**
@@ -784,12 +923,13 @@ namespace plorth
    *
    * Returns the first value with bits shifted right by the second value.
    */
+  template<bool Checked>
   static void w_shift_right(const std::shared_ptr<context>& ctx)
   {
     std::shared_ptr<number> a;
     std::shared_ptr<number> b;
 
-    if (ctx->pop_number(b) && ctx->pop_number(a))
+    if (pop_number<Checked>(ctx, b) && pop_number<Checked>(ctx, a))
     {
       ctx->push_int(a->as_int() >> b->as_int());
     }
@@ -808,12 +948,13 @@ namespace plorth
    *
    * Returns the first value with bits shifted left by the second value.
    */
+  template<bool Checked>
   static void w_shift_left(const std::shared_ptr<context>& ctx)
   {
     std::shared_ptr<number> a;
     std::shared_ptr<number> b;
 
-    if (ctx->pop_number(b) && ctx->pop_number(a))
+    if (pop_number<Checked>(ctx, b) && pop_number<Checked>(ctx, a))
     {
       ctx->push_int(a->as_int() << b->as_int());
     }
@@ -831,11 +972,12 @@ namespace plorth
    *
    * Flips the bits of the value.
    */
+  template<bool Checked>
   static void w_bit_not(const std::shared_ptr<context>& ctx)
   {
     std::shared_ptr<number> a;
 
-    if (ctx->pop_number(a))
+    if (pop_number<Checked>(ctx, a))
     {
       ctx->push_int(~a->as_int());
     }
@@ -854,12 +996,13 @@ namespace plorth
    *
    * Returns true if the first number is less than the second one.
    */
+  template<bool Checked>
   static void w_lt(const std::shared_ptr<context>& ctx)
   {
     std::shared_ptr<number> a;
     std::shared_ptr<number> b;
 
-    if (ctx->pop_number(b) && ctx->pop_number(a))
+    if (pop_number<Checked>(ctx, b) && pop_number<Checked>(ctx, a))
     {
       if (a->is(number::number_type::real) || b->is(number::number_type::real))
       {
@@ -883,12 +1026,13 @@ namespace plorth
    *
    * Returns true if the first number is greater than the second one.
    */
+  template<bool Checked>
   static void w_gt(const std::shared_ptr<context>& ctx)
   {
     std::shared_ptr<number> a;
     std::shared_ptr<number> b;
 
-    if (ctx->pop_number(b) && ctx->pop_number(a))
+    if (pop_number<Checked>(ctx, b) && pop_number<Checked>(ctx, a))
     {
       if (a->is(number::number_type::real) || b->is(number::number_type::real))
       {
@@ -912,12 +1056,13 @@ namespace plorth
    *
    * Returns true if the first number is less than or equal to the second one.
    */
+  template<bool Checked>
   static void w_lte(const std::shared_ptr<context>& ctx)
   {
     std::shared_ptr<number> a;
     std::shared_ptr<number> b;
 
-    if (ctx->pop_number(b) && ctx->pop_number(a))
+    if (pop_number<Checked>(ctx, b) && pop_number<Checked>(ctx, a))
     {
       if (a->is(number::number_type::real) || b->is(number::number_type::real))
       {
@@ -942,12 +1087,13 @@ namespace plorth
    * Returns true if the first number is greater than or equal to the second
    * one.
    */
+  template<bool Checked>
   static void w_gte(const std::shared_ptr<context>& ctx)
   {
     std::shared_ptr<number> a;
     std::shared_ptr<number> b;
 
-    if (ctx->pop_number(b) && ctx->pop_number(a))
+    if (pop_number<Checked>(ctx, b) && pop_number<Checked>(ctx, a))
     {
       if (a->is(number::number_type::real) || b->is(number::number_type::real))
       {
@@ -964,37 +1110,62 @@ namespace plorth
     {
       return
       {
-        { U"nan?", w_is_nan },
-        { U"finite?", w_is_finite },
-
-        { U"times", w_times },
-
-        { U"abs", w_abs },
-        { U"round", w_round },
-        { U"floor", w_floor },
-        { U"ceil", w_ceil },
-        { U"max", w_max },
-        { U"min", w_min },
-        { U"clamp", w_clamp },
-        { U"in-range?", w_is_in_range },
-
-        { U"+", w_add },
-        { U"-", w_sub },
-        { U"*", w_mul },
-        { U"/", w_div },
-        { U"%", w_mod },
-
-        { U"&", w_bit_and },
-        { U"|", w_bit_or },
-        { U"^", w_bit_xor },
-        { U"<<", w_shift_left },
-        { U">>", w_shift_right },
-        { U"~", w_bit_not },
-
-        { U"<", w_lt },
-        { U">", w_gt },
-        { U"<=", w_lte },
-        { U">=", w_gte }
+        { U"nan?", w_is_nan<true>, U"number -- number boolean",
+          w_is_nan<false> },
+        { U"finite?", w_is_finite<true>, U"number -- number boolean",
+          w_is_finite<false> },
+
+        { U"times", w_times, nullptr },
+
+        { U"abs", w_abs<true>, U"number -- number",
+          w_abs<false> },
+        { U"round", w_round<true>, U"number -- number",
+          w_round<false> },
+        { U"floor", w_floor<true>, U"number -- number",
+          w_floor<false> },
+        { U"ceil", w_ceil<true>, U"number -- number",
+          w_ceil<false> },
+        { U"max", w_max<true>, U"number number -- number",
+          w_max<false> },
+        { U"min", w_min<true>, U"number number -- number",
+          w_min<false> },
+        { U"clamp", w_clamp<true>, U"number number number -- number",
+          w_clamp<false> },
+        { U"in-range?", w_is_in_range<true>, U"number number number -- boolean",
+          w_is_in_range<false> },
+
+        { U"+", w_add<true>, U"number number -- number",
+          w_add<false> },
+        { U"-", w_sub<true>, U"number number -- number",
+          w_sub<false> },
+        { U"*", w_mul<true>, U"number number -- number",
+          w_mul<false> },
+        { U"/", w_div<true>, U"number number -- number",
+          w_div<false> },
+        { U"%", w_mod<true>, U"number number -- number",
+          w_mod<false> },
+
+        { U"&", w_bit_and<true>, U"number number -- number",
+          w_bit_and<false> },
+        { U"|", w_bit_or<true>, U"number number -- number",
+          w_bit_or<false> },
+        { U"^", w_bit_xor<true>, U"number number -- number",
+          w_bit_xor<false> },
+        { U"<<", w_shift_left<true>, U"number number -- number",
+          w_shift_left<false> },
+        { U">>", w_shift_right<true>, U"number number -- number",
+          w_shift_right<false> },
+        { U"~", w_bit_not<true>, U"number -- number",
+          w_bit_not<false> },
+
+        { U"<", w_lt<true>, U"number number -- boolean",
+          w_lt<false> },
+        { U">", w_gt<true>, U"number number -- boolean",
+          w_gt<false> },
+        { U"<=", w_lte<true>, U"number number -- boolean",
+          w_lte<false> },
+        { U">=", w_gte<true>, U"number number -- boolean",
+          w_gte<false> }
       };
     }
   }
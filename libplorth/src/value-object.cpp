@@ -26,8 +26,18 @@
 #include <plorth/context.hpp>
 #include <plorth/value-string.hpp>
 
+#include <bitset>
+
 #include "./utils.hpp"
 
+#if !defined(PLORTH_OBJECT_MAX_DEPTH)
+# define PLORTH_OBJECT_MAX_DEPTH 8
+#endif
+
+#if !defined(PLORTH_OBJECT_TRIE_MIN_SIZE)
+# define PLORTH_OBJECT_TRIE_MIN_SIZE 32
+#endif
+
 namespace plorth
 {
   namespace
@@ -65,53 +75,80 @@ namespace plorth
         return m_container.size();
       }
 
-      std::vector<key_type> keys() const
+      bool for_each(const visitor& callback) const
       {
-        std::vector<key_type> result;
-
-        result.reserve(m_container.size());
         for (const auto& property : m_container)
         {
-          result.push_back(property.first);
+          if (!callback(property.first, property.second))
+          {
+            return false;
+          }
         }
 
-        return result;
+        return true;
       }
 
-      std::vector<mapped_type> values() const
+    private:
+      const container_type m_container;
+    };
+
+    class set_object : public object
+    {
+    public:
+      explicit set_object(const std::shared_ptr<class object>& object,
+                          const key_type& key,
+                          const mapped_type& value)
+        : plorth::object(layout::layered, object->depth() + 1)
+        , m_object(object)
+        , m_key(key)
+        , m_value(value)
+        , m_size(object->size() + 1) {}
+
+      bool has_own_property(const key_type& key) const
       {
-        std::vector<mapped_type> result;
+        return key == m_key || m_object->has_own_property(key);
+      }
 
-        result.reserve(m_container.size());
-        for (const auto& property : m_container)
+      bool own_property(const key_type& key, mapped_type& slot) const
+      {
+        if (key == m_key)
         {
-          result.push_back(property.second);
+          slot = m_value;
+
+          return true;
         }
 
-        return result;
+        return m_object->own_property(key, slot);
       }
 
-      std::vector<value_type> entries() const
+      size_type size() const
       {
-        return std::vector<value_type>(
-          std::begin(m_container),
-          std::end(m_container)
-        );
+        return m_size;
+      }
+
+      bool for_each(const visitor& callback) const
+      {
+        return m_object->for_each(callback) && callback(m_key, m_value);
       }
 
     private:
-      const container_type m_container;
+      const std::shared_ptr<object> m_object;
+      const key_type m_key;
+      const mapped_type m_value;
+      const size_type m_size;
     };
 
-    class set_object : public object
+    class set_object_override : public object
     {
     public:
-      explicit set_object(const std::shared_ptr<class object>& object,
-                          const key_type& key,
-                          const mapped_type& value)
-        : m_object(object)
+      explicit set_object_override(const std::shared_ptr<class object>& object,
+                                   const key_type& key,
+                                   const mapped_type& value)
+        : plorth::object(layout::layered, object->depth() + 1)
+        , m_object(object)
         , m_key(key)
-        , m_value(value) {}
+        , m_value(value)
+        , m_size(object->size()) {}
 
       bool has_own_property(const key_type& key) const
       {
@@ -132,192 +169,441 @@ namespace plorth
 
       size_type size() const
       {
-        return m_object->size() + 1;
+        return m_size;
       }
 
-      std::vector<key_type> keys() const
+      bool for_each(const visitor& callback) const
       {
-        auto keys = m_object->keys();
-
-        keys.push_back(m_key);
+        const auto& key = m_key;
+        const auto& value = m_value;
 
-        return keys;
+        return m_object->for_each([&](const key_type& k, const mapped_type& v)
+        {
+          return callback(k, k == key ? value : v);
+        });
       }
 
-      std::vector<mapped_type> values() const
-      {
-        auto values = m_object->values();
+    private:
+      const std::shared_ptr<object> m_object;
+      const key_type m_key;
+      const mapped_type m_value;
+      const size_type m_size;
+    };
 
-        values.push_back(m_value);
+    class delete_object : public object
+    {
+    public:
+      explicit delete_object(const std::shared_ptr<class object>& object,
+                             const key_type& removed_key)
+        : plorth::object(layout::layered, object->depth() + 1)
+        , m_object(object)
+        , m_removed_key(removed_key)
+        , m_size(object->size() - 1) {}
 
-        return values;
+      bool has_own_property(const key_type& key) const
+      {
+        return m_removed_key != key && m_object->has_own_property(key);
+      }
+
+      bool own_property(const key_type& key, mapped_type& slot) const
+      {
+        return key != m_removed_key && m_object->own_property(key, slot);
       }
 
-      std::vector<value_type> entries() const
+      size_type size() const
       {
-        auto entries = m_object->entries();
+        return m_size;
+      }
 
-        entries.push_back({ m_key, m_value });
+      bool for_each(const visitor& callback) const
+      {
+        const auto& removed_key = m_removed_key;
 
-        return entries;
+        return m_object->for_each([&](const key_type& k, const mapped_type& v)
+        {
+          return k == removed_key || callback(k, v);
+        });
       }
 
     private:
       const std::shared_ptr<object> m_object;
-      const key_type m_key;
-      const mapped_type m_value;
+      const key_type m_removed_key;
+      const size_type m_size;
     };
 
-    class set_object_override : public object
+    /**
+     * Object which stores it's properties in a hash array mapped trie. When
+     * the object is modified, only the nodes on the path from the root of the
+     * trie to the modified property are copied and rest of the nodes are
+     * shared between the original and the modified object.
+     */
+    class trie_object : public object
     {
     public:
-      explicit set_object_override(const std::shared_ptr<class object>& object,
-                                   const key_type& key,
-                                   const mapped_type& value)
-        : m_object(object)
-        , m_key(key)
-        , m_value(value) {}
+      struct node;
+      using node_pointer = std::shared_ptr<const node>;
+      using hash_type = std::size_t;
+
+      /**
+       * Entry in trie node, which is either a property or pointer to another
+       * node.
+       */
+      struct entry
+      {
+        key_type key;
+        mapped_type value;
+        node_pointer child;
+      };
+
+      /**
+       * Node in the trie. Bitmap tells which one of the 32 possible slots are
+       * used in the node. Nodes placed below the maximum depth of the trie
+       * store properties whose hashes collide; their bitmap is not used.
+       */
+      struct node
+      {
+        std::uint32_t bitmap;
+        std::vector<entry> entries;
+      };
+
+      explicit trie_object(const node_pointer& root, size_type size)
+        : object(layout::trie)
+        , m_root(root)
+        , m_size(size) {}
+
+      /**
+       * Constructs trie from properties of given object.
+       */
+      static node_pointer build(const std::shared_ptr<class object>& object)
+      {
+        node_pointer root;
+        bool added;
+
+        object->for_each([&](const key_type& key, const mapped_type& value)
+        {
+          root = insert(root.get(), hash(key), 0, key, value, added);
+
+          return true;
+        });
+
+        return root;
+      }
+
+      inline const node_pointer& root() const
+      {
+        return m_root;
+      }
 
       bool has_own_property(const key_type& key) const
       {
-        return key == m_key || m_object->has_own_property(key);
+        return !!find(key);
       }
 
       bool own_property(const key_type& key, mapped_type& slot) const
       {
-        if (key == m_key)
+        if (const auto e = find(key))
         {
-          slot = m_value;
+          slot = e->value;
 
           return true;
         }
 
-        return m_object->own_property(key, slot);
+        return false;
       }
 
       size_type size() const
       {
-        return m_object->size();
+        return m_size;
       }
 
-      std::vector<key_type> keys() const
+      bool for_each(const visitor& callback) const
       {
-        return m_object->keys();
+        return !m_root || visit(m_root.get(), callback);
       }
 
-      std::vector<mapped_type> values() const
+      /**
+       * Returns copy of given trie where given property has been either
+       * introduced or replaced.
+       */
+      static node_pointer insert(const node* n,
+                                 hash_type hash,
+                                 unsigned int shift,
+                                 const key_type& key,
+                                 const mapped_type& value,
+                                 bool& added)
       {
-        std::vector<mapped_type> result;
+        auto result = n ? std::make_shared<node>(*n) : std::make_shared<node>();
 
-        result.reserve(m_object->size());
-        for (const auto property : m_object->entries())
+        added = false;
+        if (shift >= hash_bits)
         {
-          if (property.first == m_key)
+          for (auto& e : result->entries)
           {
-            result.push_back(m_value);
+            if (e.key == key)
+            {
+              e.value = value;
+
+              return result;
+            }
+          }
+          result->entries.push_back({ key, value, node_pointer() });
+          added = true;
+
+          return result;
+        }
+
+        const auto bit = slot_bit(hash, shift);
+        const auto index = slot_index(result->bitmap, bit);
+
+        if (!(result->bitmap & bit))
+        {
+          result->bitmap |= bit;
+          result->entries.insert(
+            std::begin(result->entries) + index,
+            { key, value, node_pointer() }
+          );
+          added = true;
+        } else {
+          auto& e = result->entries[index];
+
+          if (e.child)
+          {
+            e.child = insert(e.child.get(), hash, shift + 5, key, value, added);
+          }
+          else if (e.key == key)
+          {
+            e.value = value;
           } else {
-            result.push_back(property.second);
+            e.child = merge(
+              e.key,
+              e.value,
+              trie_object::hash(e.key),
+              key,
+              value,
+              hash,
+              shift + 5
+            );
+            e.key.clear();
+            e.value.reset();
+            added = true;
           }
         }
 
         return result;
       }
 
-      std::vector<value_type> entries() const
+      /**
+       * Returns copy of given trie where given property has been removed.
+       * Null pointer is returned if the resulting trie is empty.
+       */
+      static node_pointer remove(const node_pointer& n,
+                                 hash_type hash,
+                                 unsigned int shift,
+                                 const key_type& key,
+                                 bool& removed)
       {
-        std::vector<value_type> result;
+        std::shared_ptr<node> result;
+
+        removed = false;
+        if (shift >= hash_bits)
+        {
+          for (std::size_t i = 0; i < n->entries.size(); ++i)
+          {
+            if (n->entries[i].key == key)
+            {
+              if (n->entries.size() == 1)
+              {
+                removed = true;
+
+                return node_pointer();
+              }
+              result = std::make_shared<node>(*n);
+              result->entries.erase(std::begin(result->entries) + i);
+              removed = true;
+
+              return result;
+            }
+          }
+
+          return n;
+        }
+
+        const auto bit = slot_bit(hash, shift);
+        const auto index = slot_index(n->bitmap, bit);
+
+        if (!(n->bitmap & bit))
+        {
+          return n;
+        }
+
+        const auto& e = n->entries[index];
 
-        result.reserve(m_object->size());
-        for (const auto property : m_object->entries())
+        if (e.child)
         {
-          if (property.first == m_key)
+          const auto child = remove(e.child, hash, shift + 5, key, removed);
+
+          if (!removed)
+          {
+            return n;
+          }
+          result = std::make_shared<node>(*n);
+          if (!child)
           {
-            result.push_back({ m_key, m_value });
+            result->bitmap &= ~bit;
+            result->entries.erase(std::begin(result->entries) + index);
+          }
+          else if (child->entries.size() == 1 && !child->entries[0].child)
+          {
+            // Single property left in the child node can be lifted up.
+            result->entries[index] = child->entries[0];
           } else {
-            result.push_back(property);
+            result->entries[index].child = child;
+          }
+        }
+        else if (e.key == key)
+        {
+          removed = true;
+          if (n->entries.size() == 1)
+          {
+            return node_pointer();
           }
+          result = std::make_shared<node>(*n);
+          result->bitmap &= ~bit;
+          result->entries.erase(std::begin(result->entries) + index);
+        } else {
+          return n;
         }
 
         return result;
       }
 
-    private:
-      const std::shared_ptr<object> m_object;
-      const key_type m_key;
-      const mapped_type m_value;
-    };
-
-    class delete_object : public object
-    {
-    public:
-      explicit delete_object(const std::shared_ptr<class object>& object,
-                             const key_type& removed_key)
-        : m_object(object)
-        , m_removed_key(removed_key) {}
-
-      bool has_own_property(const key_type& key) const
+      static inline hash_type hash(const key_type& key)
       {
-        return m_removed_key != key && m_object->has_own_property(key);
+        return std::hash<key_type>()(key);
       }
 
-      bool own_property(const key_type& key, mapped_type& slot) const
+    private:
+      static const unsigned int hash_bits = sizeof(hash_type) * 8;
+
+      static inline std::uint32_t slot_bit(hash_type hash, unsigned int shift)
       {
-        return key != m_removed_key && m_object->own_property(key, slot);
+        return static_cast<std::uint32_t>(1) << ((hash >> shift) & 31);
       }
 
-      size_type size() const
+      static inline std::size_t slot_index(std::uint32_t bitmap,
+                                           std::uint32_t bit)
       {
-        return m_object->size() - 1;
+        return std::bitset<32>(bitmap & (bit - 1)).count();
       }
 
-      std::vector<key_type> keys() const
+      /**
+       * Constructs node which contains two properties whose hashes are equal
+       * up to the given shift.
+       */
+      static node_pointer merge(const key_type& key1,
+                                const mapped_type& value1,
+                                hash_type hash1,
+                                const key_type& key2,
+                                const mapped_type& value2,
+                                hash_type hash2,
+                                unsigned int shift)
       {
-        std::vector<key_type> result;
+        auto result = std::make_shared<node>();
 
-        for (const auto& key : m_object->keys())
+        if (shift >= hash_bits)
         {
-          if (key != m_removed_key)
+          result->bitmap = 0;
+          result->entries.push_back({ key1, value1, node_pointer() });
+          result->entries.push_back({ key2, value2, node_pointer() });
+        } else {
+          const auto bit1 = slot_bit(hash1, shift);
+          const auto bit2 = slot_bit(hash2, shift);
+
+          result->bitmap = bit1 | bit2;
+          if (bit1 == bit2)
+          {
+            result->entries.push_back({
+              key_type(),
+              mapped_type(),
+              merge(key1, value1, hash1, key2, value2, hash2, shift + 5)
+            });
+          }
+          else if (bit1 < bit2)
           {
-            result.push_back(key);
+            result->entries.push_back({ key1, value1, node_pointer() });
+            result->entries.push_back({ key2, value2, node_pointer() });
+          } else {
+            result->entries.push_back({ key2, value2, node_pointer() });
+            result->entries.push_back({ key1, value1, node_pointer() });
           }
         }
 
         return result;
       }
 
-      std::vector<mapped_type> values() const
+      const entry* find(const key_type& key) const
       {
-        std::vector<mapped_type> result;
+        const auto h = hash(key);
+        const node* n = m_root.get();
+        unsigned int shift = 0;
 
-        for (const auto& property : m_object->entries())
+        while (n)
         {
-          if (property.first != m_removed_key)
+          if (shift >= hash_bits)
+          {
+            for (const auto& e : n->entries)
+            {
+              if (e.key == key)
+              {
+                return &e;
+              }
+            }
+
+            return nullptr;
+          }
+
+          const auto bit = slot_bit(h, shift);
+
+          if (!(n->bitmap & bit))
+          {
+            return nullptr;
+          }
+
+          const auto& e = n->entries[slot_index(n->bitmap, bit)];
+
+          if (!e.child)
           {
-            result.push_back(property.second);
+            return e.key == key ? &e : nullptr;
           }
+          n = e.child.get();
+          shift += 5;
         }
 
-        return result;
+        return nullptr;
       }
 
-      std::vector<value_type> entries() const
+      static bool visit(const node* n, const visitor& callback)
       {
-        std::vector<value_type> result;
-
-        for (const auto& property : m_object->entries())
+        for (const auto& e : n->entries)
         {
-          if (property.first != m_removed_key)
+          if (e.child)
+          {
+            if (!visit(e.child.get(), callback))
+            {
+              return false;
+            }
+          }
+          else if (!callback(e.key, e.value))
           {
-            result.push_back(property);
+            return false;
           }
         }
 
-        return result;
+        return true;
       }
 
-    private:
-      const std::shared_ptr<object> m_object;
-      const key_type m_removed_key;
+      const node_pointer m_root;
+      const size_type m_size;
     };
   }
 
@@ -358,6 +644,51 @@ namespace plorth
     return true;
   }
 
+  std::vector<object::key_type> object::keys() const
+  {
+    std::vector<key_type> result;
+
+    result.reserve(size());
+    for_each([&result](const key_type& key, const mapped_type&)
+    {
+      result.push_back(key);
+
+      return true;
+    });
+
+    return result;
+  }
+
+  std::vector<object::mapped_type> object::values() const
+  {
+    std::vector<mapped_type> result;
+
+    result.reserve(size());
+    for_each([&result](const key_type&, const mapped_type& value)
+    {
+      result.push_back(value);
+
+      return true;
+    });
+
+    return result;
+  }
+
+  std::vector<object::value_type> object::entries() const
+  {
+    std::vector<value_type> result;
+
+    result.reserve(size());
+    for_each([&result](const key_type& key, const mapped_type& value)
+    {
+      result.push_back({ key, value });
+
+      return true;
+    });
+
+    return result;
+  }
+
   bool object::equals(const std::shared_ptr<value>& that) const
   {
     std::shared_ptr<object> obj;
@@ -377,15 +708,10 @@ namespace plorth
       return false;
     }
 
-    for (auto property : entries())
+    return for_each([&](const key_type& key, const mapped_type& value)
     {
-      if (!obj->own_property(property.first, slot) || property.second != slot)
-      {
-        return false;
-      }
-    }
-
-    return true;
+      return obj->own_property(key, slot) && value == slot;
+    });
   }
 
   std::u32string object::to_string() const
@@ -393,7 +719,7 @@ namespace plorth
     std::u32string result;
     bool first = true;
 
-    for (const auto property : entries())
+    for_each([&](const key_type& key, const mapped_type& value)
     {
       if (first)
       {
@@ -402,13 +728,15 @@ namespace plorth
         result += ',';
         result += ' ';
       }
-      result += property.first;
+      result += key;
       result += '=';
-      if (property.second)
+      if (value)
       {
-        result += property.second->to_string();
+        result += value->to_string();
       }
-    }
+
+      return true;
+    });
 
     return result;
   }
@@ -419,7 +747,7 @@ namespace plorth
     bool first = true;
 
     result += '{';
-    for (const auto property : entries())
+    for_each([&](const key_type& key, const mapped_type& value)
     {
       if (first)
       {
@@ -428,16 +756,18 @@ namespace plorth
         result += ',';
         result += ' ';
       }
-      result += json_stringify(property.first);
+      result += json_stringify(key);
       result += ':';
       result += ' ';
-      if (property.second)
+      if (value)
       {
-        result += property.second->to_source();
+        result += value->to_source();
       } else {
         result += U"null";
       }
-    }
+
+      return true;
+    });
     result += '}';
 
     return result;
@@ -447,6 +777,11 @@ namespace plorth
     const std::vector<object::value_type>& properties
   )
   {
+    if (properties.empty() && m_empty_object)
+    {
+      return m_empty_object;
+    }
+
     return std::shared_ptr<class object>(
       new (*m_memory_manager) simple_object(
         std::begin(properties),
@@ -455,6 +790,153 @@ namespace plorth
     );
   }
 
+  /**
+   * Updates runtime statistics after an object has been modified.
+   */
+  static void count_update(const std::shared_ptr<runtime>& runtime,
+                           const std::shared_ptr<object>& result,
+                           bool compacted)
+  {
+    auto& stats = runtime->statistics();
+
+    ++stats.object_updates;
+    stats.object_depth_total += result->depth();
+    if (compacted)
+    {
+      ++stats.object_compactions;
+    }
+  }
+
+  /**
+   * Constructs copy of the object with given property either introduced or
+   * replaced. Modifications are layered on top of the original object until
+   * the layers become too deep, after which they are compacted into a single
+   * hash table. Large objects are stored in a trie instead, so that they can
+   * be modified without copying all of their properties.
+   */
+  static std::shared_ptr<object> set_property(
+    const std::shared_ptr<runtime>& runtime,
+    const std::shared_ptr<object>& obj,
+    const object::key_type& key,
+    const object::mapped_type& value
+  )
+  {
+    std::shared_ptr<object> result;
+    bool compacted = false;
+
+    if (obj->layout() == object::layout::trie
+        || obj->size() + 1 >= PLORTH_OBJECT_TRIE_MIN_SIZE)
+    {
+      trie_object::node_pointer root;
+      bool added;
+
+      if (obj->layout() == object::layout::trie)
+      {
+        root = static_cast<const trie_object*>(obj.get())->root();
+      } else {
+        root = trie_object::build(obj);
+        compacted = true;
+      }
+      root = trie_object::insert(
+        root.get(),
+        trie_object::hash(key),
+        0,
+        key,
+        value,
+        added
+      );
+      result = runtime->value<trie_object>(
+        root,
+        obj->size() + (added ? 1 : 0)
+      );
+    }
+    else if (obj->depth() + 1 >= PLORTH_OBJECT_MAX_DEPTH)
+    {
+      std::vector<object::value_type> properties;
+
+      properties.reserve(obj->size() + 1);
+      obj->for_each([&](const object::key_type& k,
+                        const object::mapped_type& v)
+      {
+        if (k != key)
+        {
+          properties.push_back({ k, v });
+        }
+
+        return true;
+      });
+      properties.push_back({ key, value });
+      result = runtime->object(properties);
+      compacted = true;
+    }
+    else if (obj->has_own_property(key))
+    {
+      result = runtime->value<set_object_override>(obj, key, value);
+    } else {
+      result = runtime->value<set_object>(obj, key, value);
+    }
+    count_update(runtime, result, compacted);
+
+    return result;
+  }
+
+  /**
+   * Constructs copy of the object with given property removed. The property
+   * must exist in the object.
+   */
+  static std::shared_ptr<object> delete_property(
+    const std::shared_ptr<runtime>& runtime,
+    const std::shared_ptr<object>& obj,
+    const object::key_type& key
+  )
+  {
+    std::shared_ptr<object> result;
+    bool compacted = false;
+
+    if (obj->layout() == object::layout::trie
+        || obj->size() > PLORTH_OBJECT_TRIE_MIN_SIZE)
+    {
+      trie_object::node_pointer root;
+      bool removed;
+
+      if (obj->layout() == object::layout::trie)
+      {
+        root = static_cast<const trie_object*>(obj.get())->root();
+      } else {
+        root = trie_object::build(obj);
+        compacted = true;
+      }
+      root = trie_object::remove(root, trie_object::hash(key), 0, key, removed);
+      result = runtime->value<trie_object>(
+        root,
+        obj->size() - (removed ? 1 : 0)
+      );
+    }
+    else if (obj->depth() + 1 >= PLORTH_OBJECT_MAX_DEPTH)
+    {
+      std::vector<object::value_type> properties;
+
+      properties.reserve(obj->size());
+      obj->for_each([&](const object::key_type& k,
+                        const object::mapped_type& v)
+      {
+        if (k != key)
+        {
+          properties.push_back({ k, v });
+        }
+
+        return true;
+      });
+      result = runtime->object(properties);
+      compacted = true;
+    } else {
+      result = runtime->value<delete_object>(obj, key);
+    }
+    count_update(runtime, result, compacted);
+
+    return result;
+  }
+
   /**
    * Word: keys
    * Prototype: object
@@ -481,10 +963,12 @@ namespace plorth
     }
 
     result.reserve(obj->size());
-    for (const auto key : obj->keys())
+    obj->for_each([&](const object::key_type& key, const object::mapped_type&)
     {
       result.push_back(runtime->string(key));
-    }
+
+      return true;
+    });
 
     ctx->push(obj);
     ctx->push_array(result.data(), result.size());
@@ -541,14 +1025,18 @@ namespace plorth
       return;
     }
 
-    for (const auto property : obj->entries())
+    result.reserve(obj->size());
+    obj->for_each([&](const object::key_type& key,
+                      const object::mapped_type& value)
     {
-      std::shared_ptr<value> pair[2];
+      std::shared_ptr<class value> pair[2];
 
-      pair[0] = runtime->string(property.first);
-      pair[1] = property.second;
+      pair[0] = runtime->string(key);
+      pair[1] = value;
       result.push_back(runtime->array(pair, 2));
-    }
+
+      return true;
+    });
 
     ctx->push(obj);
     ctx->push_array(result);
@@ -714,16 +1202,7 @@ namespace plorth
 
     if (ctx->pop_object(obj) && ctx->pop_string(id) && ctx->pop(val))
     {
-      const auto key = id->to_string();
-      std::shared_ptr<object> result;
-
-      if (obj->has_own_property(key))
-      {
-        result = ctx->runtime()->value<set_object_override>(obj, key, val);
-      } else {
-        result = ctx->runtime()->value<set_object>(obj, key, val);
-      }
-      ctx->push(result);
+      ctx->push(set_property(ctx->runtime(), obj, id->to_string(), val));
     }
   }
 
@@ -751,12 +1230,14 @@ namespace plorth
 
       if (!obj->has_own_property(name))
       {
+        ctx->push(obj);
         ctx->error(
           error::code::range,
           U"No such property: `" + name + U"'"
         );
+        return;
       }
-      ctx->push(ctx->runtime()->value<delete_object>(obj, name));
+      ctx->push(delete_property(ctx->runtime(), obj, name));
     }
   }
 
@@ -781,16 +1262,18 @@ namespace plorth
 
     if (ctx->pop_object(a) && ctx->pop_object(b))
     {
-      const auto entries = b->entries();
-      std::unordered_map<std::u32string, std::shared_ptr<value>> properties(
-        std::begin(entries),
-        std::end(entries)
-      );
-
-      for (const auto property : a->entries())
+      std::unordered_map<std::u32string, std::shared_ptr<value>> properties;
+      const auto insert = [&properties](const object::key_type& key,
+                                        const object::mapped_type& value)
       {
-        properties[property.first] = property.second;
-      }
+        properties[key] = value;
+
+        return true;
+      };
+
+      properties.reserve(a->size() + b->size());
+      b->for_each(insert);
+      a->for_each(insert);
       ctx->push_object(std::vector<object::value_type>(
         std::begin(properties),
         std::end(properties)
@@ -798,22 +1281,159 @@ namespace plorth
     }
   }
 
+  /**
+   * Word: for-each
+   * Prototype: object
+   *
+   * Takes:
+   * - quote
+   * - object
+   *
+   * Runs quote once for every non-inherited property in the object, with the
+   * name of the property and it's value pushed onto the stack.
+   *
+   *     ( swap print ": " print println ) { "a": 1 } for-each
+   */
+  static void w_for_each(const std::shared_ptr<context>& ctx)
+  {
+    const auto& runtime = ctx->runtime();
+    std::shared_ptr<object> obj;
+    std::shared_ptr<quote> quo;
+
+    if (!ctx->pop_object(obj) || !ctx->pop_quote(quo))
+    {
+      return;
+    }
+
+    obj->for_each([&](const object::key_type& key,
+                      const object::mapped_type& value)
+    {
+      ctx->push(runtime->string(key));
+      ctx->push(value);
+
+      return quo->call(ctx);
+    });
+  }
+
+  /**
+   * Word: map
+   * Prototype: object
+   *
+   * Takes:
+   * - quote
+   * - object
+   *
+   * Gives:
+   * - object
+   *
+   * Applies quote once for each non-inherited property in the object, with
+   * the name of the property and it's value pushed onto the stack, and
+   * constructs new object with the same keys from values returned by the
+   * quote.
+   */
+  static void w_map(const std::shared_ptr<context>& ctx)
+  {
+    const auto& runtime = ctx->runtime();
+    std::shared_ptr<object> obj;
+    std::shared_ptr<quote> quo;
+    std::vector<object::value_type> result;
+
+    if (!ctx->pop_object(obj) || !ctx->pop_quote(quo))
+    {
+      return;
+    }
+
+    result.reserve(obj->size());
+    if (obj->for_each([&](const object::key_type& key,
+                          const object::mapped_type& value)
+    {
+      std::shared_ptr<class value> quote_result;
+
+      ctx->push(runtime->string(key));
+      ctx->push(value);
+      if (!quo->call(ctx) || !ctx->pop(quote_result))
+      {
+        return false;
+      }
+      result.push_back({ key, quote_result });
+
+      return true;
+    }))
+    {
+      ctx->push_object(result);
+    }
+  }
+
+  /**
+   * Word: filter
+   * Prototype: object
+   *
+   * Takes:
+   * - quote
+   * - object
+   *
+   * Gives:
+   * - object
+   *
+   * Constructs new object which contains only those non-inherited properties
+   * of the object which satisfy the provided testing quote. The quote is
+   * called with the name of the property and it's value pushed onto the
+   * stack.
+   */
+  static void w_filter(const std::shared_ptr<context>& ctx)
+  {
+    const auto& runtime = ctx->runtime();
+    std::shared_ptr<object> obj;
+    std::shared_ptr<quote> quo;
+    std::vector<object::value_type> result;
+
+    if (!ctx->pop_object(obj) || !ctx->pop_quote(quo))
+    {
+      return;
+    }
+
+    if (obj->for_each([&](const object::key_type& key,
+                          const object::mapped_type& value)
+    {
+      bool quote_result;
+
+      ctx->push(runtime->string(key));
+      ctx->push(value);
+      if (!quo->call(ctx) || !ctx->pop_boolean(quote_result))
+      {
+        return false;
+      }
+      else if (quote_result)
+      {
+        result.push_back({ key, value });
+      }
+
+      return true;
+    }))
+    {
+      ctx->push_object(result);
+    }
+  }
+
   namespace api
   {
     runtime::prototype_definition object_prototype()
     {
       return
       {
-        { U"keys", w_keys },
-        { U"values", w_values },
-        { U"entries", w_entries },
-        { U"has?", w_has },
-        { U"has-own?", w_has_own },
-        { U"new", w_new },
-        { U"@", w_get },
-        { U"!", w_set },
-        { U"delete", w_delete },
-        { U"+", w_concat }
+        { U"keys", w_keys, U"object -- object array" },
+        { U"values", w_values, U"object -- object array" },
+        { U"entries", w_entries, U"object -- object array" },
+        { U"has?", w_has, U"string object -- object boolean" },
+        { U"has-own?", w_has_own, U"string object -- object boolean" },
+        { U"new", w_new, nullptr },
+        { U"@", w_get, U"string object -- object any" },
+        { U"!", w_set, U"any string object -- object" },
+        { U"delete", w_delete, U"string object -- object" },
+        { U"+", w_concat, U"object object -- object" },
+        { U"for-each", w_for_each, nullptr },
+        { U"map", w_map, nullptr },
+        { U"filter", w_filter, nullptr }
       };
     }
   }
@@ -25,12 +25,47 @@
  */
 #include <plorth/context.hpp>
 
+#include "./inliner.hpp"
+#include "./jit.hpp"
+#include "./quicken.hpp"
 #include "./utils.hpp"
 
+#include <cassert>
+
 namespace plorth
 {
   namespace
   {
+    /**
+     * Tests whether the stack contains all values taken by a word with given
+     * stack effect, with types accepted by the word.
+     */
+    static bool takes_values(const context::container_type& stack,
+                             const stack_effect& effect)
+    {
+      const auto& inputs = effect.inputs();
+
+      if (stack.size() < inputs.size())
+      {
+        return false;
+      }
+
+      auto value = std::end(stack) - inputs.size();
+
+      for (const auto types : inputs)
+      {
+        const auto type = *value ? (*value)->type() : value::type::null;
+
+        if (!(stack_effect::type_of(type) & types))
+        {
+          return false;
+        }
+        ++value;
+      }
+
+      return true;
+    }
+
     /**
      * Compiled quote consists from sequence of words parsed from source code.
      * When called, values are iterated and each value is being executed as part
@@ -39,18 +74,199 @@ namespace plorth
     class compiled_quote : public quote
     {
     public:
-      explicit compiled_quote(const std::vector<std::shared_ptr<value>>& values)
-        : m_values(values) {}
+      explicit compiled_quote(const std::vector<std::shared_ptr<value>>& values,
+                              native_code code = nullptr)
+        : quote(quote_type::compiled)
+        , m_values(values)
+        , m_code(code)
+        , m_analyzed(false)
+        , m_prepared(false)
+        , m_inlined(false)
+        , m_bound(false)
+#if PLORTH_ENABLE_JIT
+        , m_calls(0)
+#endif
+        {}
 
-      inline enum quote_type quote_type() const
+      bool call(const std::shared_ptr<context>& ctx) const
       {
-        return quote_type::compiled;
+        auto& scopes = ctx->module_scopes();
+        bool result;
+
+        // Symbols are resolved from the module the quote was defined in,
+        // instead of the module of the word which happened to call it.
+        if (m_bound)
+        {
+          scopes.push_back(m_module.lock());
+        }
+        else if (!scopes.empty() && scopes.back())
+        {
+          scopes.push_back(nullptr);
+        } else {
+          return execute(ctx);
+        }
+        result = execute(ctx);
+        scopes.pop_back();
+
+        return result;
       }
 
-      bool call(const std::shared_ptr<context>& ctx) const
+      bool bound() const
       {
+        return m_bound;
+      }
+
+      void bind_module(const std::shared_ptr<object>& module)
+      {
+        if (m_bound)
+        {
+          return;
+        }
+        m_module = module;
+        m_bound = true;
         for (const auto& value : m_values)
         {
+          bind_value(value, module);
+        }
+      }
+
+      /**
+       * Executes the values of the quote.
+       */
+      bool execute(const std::shared_ptr<context>& ctx) const
+      {
+        if (m_code)
+        {
+          return m_code(ctx, m_values);
+        }
+#if PLORTH_ENABLE_JIT
+        if (m_jit_code && m_jit_code->valid())
+        {
+          return m_jit_code->entry()(ctx, m_values);
+        }
+        else if (++m_calls == jit::compile_threshold
+                 && ctx->runtime()->jit_enabled()
+                 && (m_jit_code = jit::compile(
+                   ctx->runtime(),
+                   m_values,
+                   sites(ctx->runtime())
+                 )))
+        {
+          ++ctx->runtime()->statistics().jit_compilations;
+
+          return m_jit_code->entry()(ctx, m_values);
+        }
+#endif
+
+        prepare(ctx);
+
+        const auto& values = m_inlined ? m_expanded_values : m_values;
+        auto site = std::begin(m_expanded_sites);
+        const auto sites_end = std::end(m_expanded_sites);
+        auto quickened = std::begin(m_quickened);
+        const auto quickened_end = std::end(m_quickened);
+        auto guard = std::begin(m_guards);
+        const auto guards_end = std::end(m_guards);
+
+        for (std::size_t i = 0; i < values.size(); ++i)
+        {
+          // Values of inlined words are executed in place, unless the symbol
+          // would now be resolved into something else, in which case the
+          // symbol is executed instead and the inlined values are skipped.
+          while (guard != guards_end && guard->index == i)
+          {
+            if (inliner::enter(ctx, *guard))
+            {
+              ++guard;
+              continue;
+            }
+            if (!value::exec(ctx, guard->symbol))
+            {
+              return false;
+            }
+            i += guard->size;
+            while (guard != guards_end && guard->index < i)
+            {
+              ++guard;
+            }
+            while (site != sites_end && site->index < i)
+            {
+              ++site;
+            }
+            while (quickened != quickened_end && quickened->index < i)
+            {
+              ++quickened;
+            }
+          }
+          if (i >= values.size())
+          {
+            break;
+          }
+
+          const auto& value = values[i];
+
+          // Arithmetic and comparison words are specialized for the types of
+          // operands they have been observed with.
+          if (quickened != quickened_end && quickened->index == i)
+          {
+            if (site != sites_end && site->index == i)
+            {
+              ++site;
+            }
+            if (!quicken::execute(ctx, value, *quickened++))
+            {
+              return false;
+            }
+            continue;
+          }
+
+          // Symbols whose word was resolved during the analysis are called
+          // directly, as long as the top-most value of the stack is of the
+          // same type as it was when the symbol was resolved. Otherwise the
+          // symbol is resolved normally.
+          if (site != sites_end && site->index == i)
+          {
+            const auto& stack = ctx->data();
+
+            if (!stack.empty() && value::is(stack.back(), site->type))
+            {
+              const auto position = std::static_pointer_cast<symbol>(
+                value
+              )->position();
+
+              const auto unchecked = m_unchecked[
+                site - std::begin(m_expanded_sites)
+              ];
+
+              if (position)
+              {
+                ctx->position() = *position;
+              }
+
+              // Values taken by the word were proven to be of correct types
+              // during the analysis, but words preceding it may since have
+              // been redefined, so they are verified once here instead of
+              // one by one in the native word.
+              if (unchecked
+                  && takes_values(stack, *site->quote->stack_effect()))
+              {
+                ++site;
+                unchecked(ctx);
+                if (ctx->error())
+                {
+                  return false;
+                }
+                continue;
+              }
+              if (!(site++)->quote->call(ctx))
+              {
+                return false;
+              }
+              continue;
+            }
+            ++site;
+          }
+
           if (!value::exec(ctx, value))
           {
             return false;
@@ -60,6 +276,120 @@ namespace plorth
         return true;
       }
 
+      /**
+       * Analyzes the values with static stack effects of the words, unless
+       * already done, and returns symbols which could be resolved during the
+       * analysis.
+       */
+      const std::vector<stack_analysis::site>& sites(
+        const std::shared_ptr<class runtime>& runtime
+      ) const
+      {
+        if (!m_analyzed)
+        {
+          m_sites = stack_analysis::analyze(*runtime, m_values, {}, false).sites;
+          m_analyzed = true;
+        }
+
+        return m_sites;
+      }
+
+      /**
+       * Prepares the values for interpretation when the quote is called for
+       * the first time. Short words of the context dictionary are inlined,
+       * and the resulting values are analyzed.
+       */
+      void prepare(const std::shared_ptr<context>& ctx) const
+      {
+        if (m_prepared)
+        {
+          return;
+        }
+        m_inlined = inliner::expand(ctx, m_values, m_expanded_values, m_guards);
+        if (m_inlined)
+        {
+          ctx->runtime()->statistics().inlined_words += m_guards.size();
+          m_expanded_sites = stack_analysis::analyze(
+            *ctx->runtime(),
+            m_expanded_values,
+            {},
+            false
+          ).sites;
+          m_quickened = quicken::find(m_expanded_values);
+        } else {
+          m_expanded_sites = sites(ctx->runtime());
+          m_quickened = quicken::find(m_values);
+        }
+        for (const auto& site : m_expanded_sites)
+        {
+          const auto unchecked = site.proven
+            ? site.quote->unchecked_function()
+            : nullptr;
+
+          if (unchecked)
+          {
+            ++ctx->runtime()->statistics().unchecked_sites;
+          }
+          m_unchecked.push_back(unchecked);
+        }
+        m_prepared = true;
+      }
+
+      const std::vector<std::shared_ptr<value>>* values() const
+      {
+        return &m_values;
+      }
+
+      /**
+       * Binds quotes found from given value into the module.
+       */
+      static void bind_value(const std::shared_ptr<value>& value,
+                             const std::shared_ptr<object>& module)
+      {
+        if (!value)
+        {
+          return;
+        }
+        switch (value->type())
+        {
+          case type::quote:
+            std::static_pointer_cast<quote>(value)->bind_module(module);
+            break;
+
+          case type::word:
+            std::static_pointer_cast<word>(value)->quote()->bind_module(
+              module
+            );
+            break;
+
+          case type::array:
+            {
+              const auto ary = std::static_pointer_cast<array>(value);
+
+              for (array::size_type i = 0; i < ary->size(); ++i)
+              {
+                bind_value(ary->at(i), module);
+              }
+            }
+            break;
+
+          case type::object:
+            std::static_pointer_cast<object>(value)->for_each(
+              [&module](const object::key_type&,
+                        const object::mapped_type& property)
+              {
+                bind_value(property, module);
+
+                return true;
+              }
+            );
+            break;
+
+          default:
+            break;
+        }
+      }
+
       std::u32string to_string() const
       {
         std::u32string result;
@@ -111,6 +441,39 @@ namespace plorth
 
     private:
       const std::vector<std::shared_ptr<value>> m_values;
+      /** Native code generated from the values, if any. */
+      const native_code m_code;
+      /** Whether the values have been analyzed yet or not. */
+      mutable bool m_analyzed;
+      /** Symbols resolved during the analysis. */
+      mutable std::vector<stack_analysis::site> m_sites;
+      /** Whether the values have been prepared for interpretation yet. */
+      mutable bool m_prepared;
+      /** Whether any words have been inlined into the values. */
+      mutable bool m_inlined;
+      /** Whether the quote has been bound into a module. */
+      bool m_bound;
+      /** Module which the quote has been bound into. */
+      std::weak_ptr<object> m_module;
+      /** Values with short words inlined into them. */
+      mutable std::vector<std::shared_ptr<value>> m_expanded_values;
+      /** Words inlined into the values. */
+      mutable std::vector<inliner::guard> m_guards;
+      /** Symbols resolved during the analysis of the interpreted values. */
+      mutable std::vector<stack_analysis::site> m_expanded_sites;
+      /**
+       * Unchecked variants of native words called by the sites above, or
+       * null pointers for sites which cannot use such variant.
+       */
+      mutable std::vector<quote::native_function> m_unchecked;
+      /** Arithmetic and comparison call sites of the interpreted values. */
+      mutable std::vector<quicken::site> m_quickened;
+#if PLORTH_ENABLE_JIT
+      /** Number of times the quote has been called. */
+      mutable unsigned int m_calls;
+      /** Machine code translated from the values, once the quote is hot. */
+      mutable std::unique_ptr<jit::code> m_jit_code;
+#endif
     };
 
     /**
@@ -120,12 +483,24 @@ namespace plorth
     class native_quote : public quote
     {
     public:
-      explicit native_quote(callback cb)
-        : m_callback(cb) {}
-
-      inline enum quote_type quote_type() const
+      explicit native_quote(callback cb,
+                            const char32_t* effect,
+                            native_function unchecked)
+        : quote(quote_type::native)
+        , m_callback(cb)
+        , m_unchecked(unchecked)
+        , m_has_effect(effect != nullptr)
       {
-        return quote_type::native;
+        if (m_has_effect)
+        {
+          m_has_effect = stack_effect::parse(effect, m_effect);
+          assert(m_has_effect);
+        }
+        // Unchecked variant is useless without the effect to verify against.
+        if (!m_has_effect)
+        {
+          m_unchecked = nullptr;
+        }
       }
 
       bool call(const std::shared_ptr<context>& ctx) const
@@ -147,8 +522,28 @@ namespace plorth
         return this == that.get();
       }
 
+      const class stack_effect* stack_effect() const
+      {
+        return m_has_effect ? &m_effect : nullptr;
+      }
+
+      native_function function() const
+      {
+        const auto target = m_callback.target<native_function>();
+
+        return target ? *target : nullptr;
+      }
+
+      native_function unchecked_function() const
+      {
+        return m_unchecked;
+      }
+
     private:
       const callback m_callback;
+      native_function m_unchecked;
+      bool m_has_effect;
+      class stack_effect m_effect;
     };
   }
 
@@ -159,13 +554,72 @@ namespace plorth
     );
   }
 
-  std::shared_ptr<quote> runtime::native_quote(quote::callback callback)
+  std::shared_ptr<quote> runtime::compiled_quote(
+    const std::vector<std::shared_ptr<class value>>& values,
+    quote::native_code code
+  )
+  {
+    return std::shared_ptr<quote>(
+      new (*m_memory_manager) class compiled_quote(values, code)
+    );
+  }
+
+  std::shared_ptr<quote> runtime::native_quote(
+    quote::callback callback,
+    const char32_t* stack_effect,
+    quote::native_function unchecked
+  )
   {
     return std::shared_ptr<quote>(
-      new (*m_memory_manager) class native_quote(callback)
+      new (*m_memory_manager) class native_quote(
+        callback,
+        stack_effect,
+        unchecked
+      )
     );
   }
 
+  bool context::check(const std::shared_ptr<quote>& quote)
+  {
+    std::vector<stack_effect::type_set> stack;
+    const std::vector<std::shared_ptr<value>>* values;
+    stack_analysis analysis;
+
+    if (!quote || !quote->is(quote::quote_type::compiled))
+    {
+      return true;
+    }
+    values = quote->values();
+    stack.reserve(m_data.size());
+    for (const auto& value : m_data)
+    {
+      stack.push_back(stack_effect::type_of(
+        value ? value->type() : value::type::null
+      ));
+    }
+    analysis = stack_analysis::analyze(
+      *m_runtime,
+      *values,
+      stack,
+      true,
+      &m_dictionary
+    );
+    if (analysis.underflow >= 0)
+    {
+      const auto& value = (*values)[analysis.underflow];
+
+      error(
+        error::code::range,
+        U"Stack underflow.",
+        std::static_pointer_cast<symbol>(value)->position()
+      );
+
+      return false;
+    }
+
+    return true;
+  }
+
   std::u32string quote::to_source() const
   {
     return U"(" + to_string() + U")";
@@ -367,15 +821,15 @@ namespace plorth
     {
       return
       {
-        { U"call", w_call },
-        { U"compose", w_compose },
-        { U"curry", w_curry },
-        { U"negate", w_negate },
-        { U"dip", w_dip },
-        { U"2dip", w_2dip },
+        { U"call", w_call, nullptr },
+        { U"compose", w_compose, U"quote quote -- quote" },
+        { U"curry", w_curry, U"any quote -- quote" },
+        { U"negate", w_negate, U"quote -- quote" },
+        { U"dip", w_dip, nullptr },
+        { U"2dip", w_2dip, nullptr },
 
         // Type conversions.
-        { U">word", w_to_word }
+        { U">word", w_to_word, U"symbol quote -- word" }
       };
     }
   }
@@ -0,0 +1,436 @@
+/*
+ * Copyright (c) 2017-2018, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <plorth/context.hpp>
+#include <plorth/value-file.hpp>
+#include <plorth/value-quote.hpp>
+#include <plorth/value-stream.hpp>
+
+namespace plorth
+{
+  namespace
+  {
+    /**
+     * Stream which produces lines read from input of the interpreter.
+     */
+    class input_line_stream : public stream
+    {
+    public:
+      explicit input_line_stream(const std::shared_ptr<io::input>& input)
+        : m_input(input) {}
+
+      result next(const std::shared_ptr<context>& ctx,
+                  std::shared_ptr<value>& slot)
+      {
+        m_buffer.clear();
+        switch (m_input ? m_input->read_line(m_buffer) : io::input::result::eof)
+        {
+          case io::input::result::ok:
+            slot = ctx->runtime()->string(m_buffer);
+            return result::ok;
+
+          case io::input::result::eof:
+            return result::end;
+
+          default:
+            ctx->error(error::code::io, U"Unable to decode input as UTF-8.");
+            return result::error;
+        }
+      }
+
+    private:
+      const std::shared_ptr<io::input> m_input;
+      std::u32string m_buffer;
+    };
+
+    /**
+     * Stream which produces lines read from a file.
+     */
+    class file_line_stream : public stream
+    {
+    public:
+      explicit file_line_stream(const std::shared_ptr<file>& input)
+        : m_file(input) {}
+
+      result next(const std::shared_ptr<context>& ctx,
+                  std::shared_ptr<value>& slot)
+      {
+        if (!m_file->is_open())
+        {
+          ctx->error(error::code::io, U"File has been closed.");
+          return result::error;
+        }
+        m_buffer.clear();
+        for (;;)
+        {
+          switch (m_file->read_line(m_buffer))
+          {
+            case io::input::result::ok:
+              slot = ctx->runtime()->string(m_buffer);
+              return result::ok;
+
+            case io::input::result::eof:
+              return result::end;
+
+            // Consumers of the stream expect to receive the next line, so
+            // wait for rest of it if the file is in non-blocking mode.
+            case io::input::result::would_block:
+              if (m_file->wait_readable())
+              {
+                continue;
+              }
+              ctx->error(error::code::io, U"Unable to read file.");
+              return result::error;
+
+            default:
+              ctx->error(error::code::io, U"Unable to read file as UTF-8.");
+              return result::error;
+          }
+        }
+      }
+
+    private:
+      const std::shared_ptr<file> m_file;
+      std::u32string m_buffer;
+    };
+
+    class map_stream : public stream
+    {
+    public:
+      explicit map_stream(const std::shared_ptr<stream>& source,
+                          const std::shared_ptr<quote>& quote)
+        : m_source(source)
+        , m_quote(quote) {}
+
+      result next(const std::shared_ptr<context>& ctx,
+                  std::shared_ptr<value>& slot)
+      {
+        std::shared_ptr<value> input;
+        const auto status = m_source->next(ctx, input);
+
+        if (status != result::ok)
+        {
+          return status;
+        }
+        ctx->push(input);
+        if (!m_quote->call(ctx) || !ctx->pop(slot))
+        {
+          return result::error;
+        }
+
+        return result::ok;
+      }
+
+    private:
+      const std::shared_ptr<stream> m_source;
+      const std::shared_ptr<quote> m_quote;
+    };
+
+    class filter_stream : public stream
+    {
+    public:
+      explicit filter_stream(const std::shared_ptr<stream>& source,
+                             const std::shared_ptr<quote>& quote)
+        : m_source(source)
+        , m_quote(quote) {}
+
+      result next(const std::shared_ptr<context>& ctx,
+                  std::shared_ptr<value>& slot)
+      {
+        for (;;)
+        {
+          const auto status = m_source->next(ctx, slot);
+          bool quote_result;
+
+          if (status != result::ok)
+          {
+            return status;
+          }
+          ctx->push(slot);
+          if (!m_quote->call(ctx) || !ctx->pop_boolean(quote_result))
+          {
+            return result::error;
+          }
+          else if (quote_result)
+          {
+            return result::ok;
+          }
+        }
+      }
+
+    private:
+      const std::shared_ptr<stream> m_source;
+      const std::shared_ptr<quote> m_quote;
+    };
+  }
+
+  std::shared_ptr<stream> stream::lines(
+    class runtime& runtime,
+    const std::shared_ptr<io::input>& input
+  )
+  {
+    return runtime.value<input_line_stream>(input);
+  }
+
+  std::shared_ptr<stream> stream::lines(
+    class runtime& runtime,
+    const std::shared_ptr<class file>& input
+  )
+  {
+    return runtime.value<file_line_stream>(input);
+  }
+
+  std::shared_ptr<stream> stream::map(
+    class runtime& runtime,
+    const std::shared_ptr<stream>& source,
+    const std::shared_ptr<class quote>& quote
+  )
+  {
+    return runtime.value<map_stream>(source, quote);
+  }
+
+  std::shared_ptr<stream> stream::filter(
+    class runtime& runtime,
+    const std::shared_ptr<stream>& source,
+    const std::shared_ptr<class quote>& quote
+  )
+  {
+    return runtime.value<filter_stream>(source, quote);
+  }
+
+  bool stream::equals(const std::shared_ptr<class value>& that) const
+  {
+    return that.get() == this;
+  }
+
+  std::u32string stream::to_string() const
+  {
+    return to_source();
+  }
+
+  std::u32string stream::to_source() const
+  {
+    return U"<stream>";
+  }
+
+  static bool pop_stream(const std::shared_ptr<context>& ctx,
+                         std::shared_ptr<stream>& slot)
+  {
+    std::shared_ptr<value> s;
+
+    if (!ctx->pop(s, value::type::stream))
+    {
+      return false;
+    }
+    slot = std::static_pointer_cast<stream>(s);
+
+    return true;
+  }
+
+  /**
+   * Word: next
+   * Prototype: stream
+   *
+   * Takes:
+   * - stream
+   *
+   * Gives:
+   * - stream
+   * - any
+   *
+   * Retrieves the next value from the stream. If there are no more values in
+   * the stream, null will be returned instead.
+   */
+  static void w_next(const std::shared_ptr<context>& ctx)
+  {
+    std::shared_ptr<stream> s;
+    std::shared_ptr<value> val;
+
+    if (pop_stream(ctx, s))
+    {
+      const auto result = s->next(ctx, val);
+
+      if (result == stream::result::error)
+      {
+        return;
+      }
+      ctx->push(s);
+      if (result == stream::result::ok)
+      {
+        ctx->push(val);
+      } else {
+        ctx->push_null();
+      }
+    }
+  }
+
+  /**
+   * Word: for-each
+   * Prototype: stream
+   *
+   * Takes:
+   * - quote
+   * - stream
+   *
+   * Runs quote once for every value in the stream. Values are retrieved one
+   * at a time, so the stream is never held in memory entirely.
+   *
+   *     0 input-lines ( drop 1 + ) swap for-each #=> number of lines
+   */
+  static void w_for_each(const std::shared_ptr<context>& ctx)
+  {
+    std::shared_ptr<stream> s;
+    std::shared_ptr<quote> quo;
+
+    if (!pop_stream(ctx, s) || !ctx->pop_quote(quo))
+    {
+      return;
+    }
+
+    for (;;)
+    {
+      std::shared_ptr<value> val;
+
+      if (s->next(ctx, val) != stream::result::ok)
+      {
+        return;
+      }
+      ctx->push(val);
+      if (!quo->call(ctx))
+      {
+        return;
+      }
+    }
+  }
+
+  /**
+   * Word: map
+   * Prototype: stream
+   *
+   * Takes:
+   * - quote
+   * - stream
+   *
+   * Gives:
+   * - stream
+   *
+   * Returns a stream which applies given quote to each value of the stream.
+   * The quote is not run until the values are retrieved from the resulting
+   * stream.
+   */
+  static void w_map(const std::shared_ptr<context>& ctx)
+  {
+    std::shared_ptr<stream> s;
+    std::shared_ptr<quote> quo;
+
+    if (pop_stream(ctx, s) && ctx->pop_quote(quo))
+    {
+      ctx->push(stream::map(*ctx->runtime(), s, quo));
+    }
+  }
+
+  /**
+   * Word: filter
+   * Prototype: stream
+   *
+   * Takes:
+   * - quote
+   * - stream
+   *
+   * Gives:
+   * - stream
+   *
+   * Returns a stream which skips values of the stream that do not satisfy
+   * the provided testing quote. The quote is not run until the values are
+   * retrieved from the resulting stream.
+   */
+  static void w_filter(const std::shared_ptr<context>& ctx)
+  {
+    std::shared_ptr<stream> s;
+    std::shared_ptr<quote> quo;
+
+    if (pop_stream(ctx, s) && ctx->pop_quote(quo))
+    {
+      ctx->push(stream::filter(*ctx->runtime(), s, quo));
+    }
+  }
+
+  /**
+   * Word: >array
+   * Prototype: stream
+   *
+   * Takes:
+   * - stream
+   *
+   * Gives:
+   * - array
+   *
+   * Retrieves all remaining values from the stream and returns them in an
+   * array.
+   */
+  static void w_to_array(const std::shared_ptr<context>& ctx)
+  {
+    std::shared_ptr<stream> s;
+    std::vector<std::shared_ptr<value>> result;
+
+    if (!pop_stream(ctx, s))
+    {
+      return;
+    }
+
+    for (;;)
+    {
+      std::shared_ptr<value> val;
+      const auto status = s->next(ctx, val);
+
+      if (status == stream::result::error)
+      {
+        return;
+      }
+      else if (status == stream::result::end)
+      {
+        break;
+      }
+      result.push_back(val);
+    }
+
+    ctx->push_array(result.data(), result.size());
+  }
+
+  namespace api
+  {
+    runtime::prototype_definition stream_prototype()
+    {
+      return
+      {
+        { U"next", w_next, U"stream -- stream any" },
+        { U"for-each", w_for_each, nullptr },
+        { U"map", w_map, U"quote stream -- stream" },
+        { U"filter", w_filter, U"quote stream -- stream" },
+        { U">array", w_to_array, U"stream -- array" },
+      };
+    }
+  }
+}
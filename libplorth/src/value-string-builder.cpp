@@ -0,0 +1,361 @@
+/*
+ * Copyright (c) 2017-2018, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <plorth/context.hpp>
+#include <plorth/value-string-builder.hpp>
+
+#include "./utils.hpp"
+
+#include <cstdint>
+#include <cstring>
+
+namespace plorth
+{
+  string_builder::string_builder()
+    : value(type::string_builder)
+    , m_chars(nullptr)
+    , m_length(0)
+    , m_capacity(0) {}
+
+  string_builder::~string_builder()
+  {
+    if (m_chars)
+    {
+      delete[] m_chars;
+    }
+  }
+
+  void string_builder::append(value_type c)
+  {
+    reserve(1);
+    m_chars[m_length++] = c;
+  }
+
+  void string_builder::append(const value_type* chars, size_type length)
+  {
+    if (!length)
+    {
+      return;
+    }
+    reserve(length);
+    std::memcpy(m_chars + m_length, chars, sizeof(value_type) * length);
+    m_length += length;
+  }
+
+  void string_builder::append(const std::shared_ptr<string>& str)
+  {
+    const auto length = str->length();
+
+    if (!length)
+    {
+      return;
+    }
+    reserve(length);
+    str->copy(0, length, m_chars + m_length);
+    m_length += length;
+  }
+
+  void string_builder::append(const std::shared_ptr<number>& num)
+  {
+    if (num->is(number::number_type::integer))
+    {
+      const auto value = num->as_int();
+      const bool negative = value < 0;
+      auto mag = negative
+        ? -static_cast<std::uint64_t>(value)
+        : static_cast<std::uint64_t>(value);
+      value_type buffer[21];
+      size_type offset = sizeof(buffer) / sizeof(value_type);
+
+      // Digits are written from the end of the buffer towards it's beginning.
+      do
+      {
+        buffer[--offset] = U'0' + (mag % 10);
+        mag /= 10;
+      }
+      while (mag);
+      if (negative)
+      {
+        buffer[--offset] = U'-';
+      }
+      append(buffer + offset, sizeof(buffer) / sizeof(value_type) - offset);
+    } else {
+      const auto str = to_unistring(num->as_real());
+
+      append(str.c_str(), str.length());
+    }
+  }
+
+  std::shared_ptr<string> string_builder::freeze(class runtime& runtime)
+  {
+    if (!m_frozen)
+    {
+      m_frozen = runtime.adopt_string(m_chars, m_length);
+      m_chars = nullptr;
+      m_capacity = 0;
+    }
+
+    return m_frozen;
+  }
+
+  void string_builder::reserve(size_type additional)
+  {
+    const auto required = m_length + additional;
+    size_type capacity;
+    value_type* chars;
+
+    if (required <= m_capacity)
+    {
+      return;
+    }
+    capacity = m_capacity > 0 ? m_capacity : 16;
+    while (capacity < required)
+    {
+      capacity *= 2;
+    }
+    chars = new value_type[capacity];
+    if (m_frozen)
+    {
+      // Contents of the builder are currently owned by a string which has
+      // been given out, so they need to be copied into the new buffer.
+      m_frozen->copy(0, m_length, chars);
+      m_frozen.reset();
+    }
+    else if (m_chars)
+    {
+      std::memcpy(chars, m_chars, sizeof(value_type) * m_length);
+      delete[] m_chars;
+    }
+    m_chars = chars;
+    m_capacity = capacity;
+  }
+
+  bool string_builder::equals(const std::shared_ptr<value>& that) const
+  {
+    return that.get() == this;
+  }
+
+  std::u32string string_builder::to_string() const
+  {
+    if (m_frozen)
+    {
+      return m_frozen->to_string();
+    }
+
+    return std::u32string(m_chars ? m_chars : U"", m_length);
+  }
+
+  std::u32string string_builder::to_source() const
+  {
+    return U"<string-builder " + json_stringify(to_string()) + U">";
+  }
+
+  static bool pop_builder(const std::shared_ptr<context>& ctx,
+                          std::shared_ptr<string_builder>& slot)
+  {
+    std::shared_ptr<value> builder;
+
+    if (!ctx->pop(builder, value::type::string_builder))
+    {
+      return false;
+    }
+    slot = std::static_pointer_cast<string_builder>(builder);
+
+    return true;
+  }
+
+  /**
+   * Word: length
+   * Prototype: string-builder
+   *
+   * Takes:
+   * - string-builder
+   *
+   * Gives:
+   * - string-builder
+   * - number
+   *
+   * Returns the number of characters currently in the string builder.
+   */
+  static void w_length(const std::shared_ptr<context>& ctx)
+  {
+    std::shared_ptr<string_builder> builder;
+
+    if (pop_builder(ctx, builder))
+    {
+      ctx->push(builder);
+      ctx->push_int(builder->length());
+    }
+  }
+
+  static void append_value(const std::shared_ptr<string_builder>& builder,
+                           const std::shared_ptr<value>& val)
+  {
+    if (value::is(val, value::type::string))
+    {
+      builder->append(std::static_pointer_cast<string>(val));
+    }
+    else if (value::is(val, value::type::number))
+    {
+      builder->append(std::static_pointer_cast<number>(val));
+    }
+    else if (val)
+    {
+      const auto str = val->to_string();
+
+      builder->append(str.c_str(), str.length());
+    }
+  }
+
+  /**
+   * Word: append
+   * Prototype: string-builder
+   *
+   * Takes:
+   * - any
+   * - string-builder
+   *
+   * Gives:
+   * - string-builder
+   *
+   * Appends the value given as second topmost value of the stack into the
+   * string builder. Values which are not strings are converted into strings
+   * first. Null is ignored.
+   *
+   *     "" >string-builder "foo" swap append "bar" swap append >string
+   *     #=> "foobar"
+   */
+  static void w_append(const std::shared_ptr<context>& ctx)
+  {
+    std::shared_ptr<string_builder> builder;
+    std::shared_ptr<value> val;
+
+    if (pop_builder(ctx, builder) && ctx->pop(val))
+    {
+      append_value(builder, val);
+      ctx->push(builder);
+    }
+  }
+
+  /**
+   * Word: append-line
+   * Prototype: string-builder
+   *
+   * Takes:
+   * - any
+   * - string-builder
+   *
+   * Gives:
+   * - string-builder
+   *
+   * Appends the value given as second topmost value of the stack followed by
+   * a new line into the string builder.
+   */
+  static void w_append_line(const std::shared_ptr<context>& ctx)
+  {
+    std::shared_ptr<string_builder> builder;
+    std::shared_ptr<value> val;
+
+    if (pop_builder(ctx, builder) && ctx->pop(val))
+    {
+      append_value(builder, val);
+      builder->append(U'\n');
+      ctx->push(builder);
+    }
+  }
+
+  /**
+   * Word: append-number
+   * Prototype: string-builder
+   *
+   * Takes:
+   * - number
+   * - string-builder
+   *
+   * Gives:
+   * - string-builder
+   *
+   * Formats the number given as second topmost value of the stack directly
+   * into the string builder.
+   */
+  static void w_append_number(const std::shared_ptr<context>& ctx)
+  {
+    std::shared_ptr<string_builder> builder;
+    std::shared_ptr<number> num;
+
+    if (pop_builder(ctx, builder) && ctx->pop_number(num))
+    {
+      builder->append(num);
+      ctx->push(builder);
+    }
+  }
+
+  /**
+   * Word: >string
+   * Prototype: string-builder
+   *
+   * Takes:
+   * - string-builder
+   *
+   * Gives:
+   * - string
+   *
+   * Converts contents of the string builder into a string. Characters of the
+   * builder are not copied; the builder can still be appended into, in which
+   * case it's contents are copied before they are modified.
+   */
+  static void w_to_string(const std::shared_ptr<context>& ctx)
+  {
+    std::shared_ptr<string_builder> builder;
+
+    if (pop_builder(ctx, builder))
+    {
+      ctx->push(builder->freeze(*ctx->runtime()));
+    }
+  }
+
+  namespace api
+  {
+    runtime::prototype_definition string_builder_prototype()
+    {
+      return
+      {
+        { U"length", w_length, U"string-builder -- string-builder number" },
+        { U"append", w_append, U"any string-builder -- string-builder" },
+        {
+          U"append-line",
+          w_append_line,
+          U"any string-builder -- string-builder"
+        },
+        {
+          U"append-number",
+          w_append_number,
+          U"number string-builder -- string-builder"
+        },
+        { U">string", w_to_string, U"string-builder -- string" },
+      };
+    }
+  }
+}
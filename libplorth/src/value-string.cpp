@@ -25,11 +25,26 @@
  */
 #include <plorth/context.hpp>
 #include <plorth/unicode.hpp>
+#include <plorth/value-string-builder.hpp>
 
 #include "./utils.hpp"
 
+#if !defined(PLORTH_INLINE_STRING_MAX_LENGTH)
+# define PLORTH_INLINE_STRING_MAX_LENGTH 64
+#endif
+
+#if !defined(PLORTH_STRING_VIEW_MIN_LENGTH)
+# define PLORTH_STRING_VIEW_MIN_LENGTH 16
+#endif
+
+#if !defined(PLORTH_STRING_VIEW_MIN_FRACTION)
+# define PLORTH_STRING_VIEW_MIN_FRACTION 8
+#endif
+
 #include <algorithm>
+#include <cstdint>
 #include <cstring>
+#include <limits>
 
 namespace plorth
 {
@@ -39,36 +54,91 @@ namespace plorth
     {
     public:
       explicit simple_string(const char32_t* chars, size_type length)
-        : m_length(length)
-        , m_chars(m_length > 0 ? new char32_t[m_length] : nullptr)
+        : string(length, duplicate(chars, length)) {}
+
+      /**
+       * Constructs string which takes ownership of already allocated array
+       * of Unicode code points.
+       */
+      explicit simple_string(size_type length, char32_t* chars)
+        : string(length, chars) {}
+
+      ~simple_string()
       {
-        if (m_length > 0)
+        if (data())
         {
-          std::memcpy(m_chars, chars, sizeof(char32_t) * m_length);
+          delete[] data();
         }
       }
 
-      ~simple_string()
+    private:
+      static const_pointer duplicate(const char32_t* chars, size_type length)
       {
-        if (m_length > 0)
+        pointer result;
+
+        if (!length)
         {
-          delete[] m_chars;
+          return nullptr;
         }
+        result = new char32_t[length];
+        std::memcpy(result, chars, sizeof(char32_t) * length);
+
+        return result;
       }
+    };
 
-      inline size_type length() const
+    /**
+     * Implementation of short string, which stores it's characters directly
+     * after the string value itself, in the same memory slot.
+     */
+    class inline_string : public string
+    {
+    public:
+      /**
+       * Allocates memory for the string and it's characters with single
+       * allocation and constructs the string.
+       */
+      static std::shared_ptr<string> make(memory::manager& memory_manager,
+                                          const_pointer chars,
+                                          size_type length)
       {
-        return m_length;
+        void* memory = memory_manager.allocate(
+          sizeof(inline_string) + sizeof(value_type) * length
+        );
+
+        return std::shared_ptr<string>(
+          ::new (memory) inline_string(chars, length)
+        );
       }
 
-      value_type at(size_type offset) const
+    private:
+      explicit inline_string(const_pointer chars, size_type length)
+        : string(length, reinterpret_cast<const_pointer>(this + 1))
       {
-        return m_chars[offset];
+        if (length > 0)
+        {
+          std::memcpy(
+            reinterpret_cast<pointer>(this + 1),
+            chars,
+            sizeof(value_type) * length
+          );
+        }
       }
+    };
+
+    /**
+     * Implementation of string which consists of single Unicode character,
+     * stored directly in the string value itself.
+     */
+    class character_string : public string
+    {
+    public:
+      explicit character_string(value_type c)
+        : string(1, &m_char)
+        , m_char(c) {}
 
     private:
-      const size_type m_length;
-      char32_t* m_chars;
+      const value_type m_char;
     };
 
     class concat_string : public string
@@ -76,16 +146,31 @@ namespace plorth
     public:
       explicit concat_string(const std::shared_ptr<string>& left,
                              const std::shared_ptr<string>& right)
-        : m_length(left->length() + right->length())
+        : string(left->length() + right->length())
         , m_left(left)
         , m_right(right) {}
 
-      inline size_type length() const
+      void copy(size_type offset, size_type count, pointer output) const
       {
-        return m_length;
+        const size_type left_length = m_left->length();
+
+        if (offset < left_length)
+        {
+          const auto left_count = std::min(count, left_length - offset);
+
+          m_left->copy(offset, left_count, output);
+          offset = left_length;
+          count -= left_count;
+          output += left_count;
+        }
+        if (count > 0)
+        {
+          m_right->copy(offset - left_length, count, output);
+        }
       }
 
-      value_type at(size_type offset) const
+    protected:
+      value_type element(size_type offset) const
       {
         const size_type left_length = m_left->length();
 
@@ -98,35 +183,67 @@ namespace plorth
       }
 
     private:
-      const size_type m_length;
       const std::shared_ptr<string> m_left;
       const std::shared_ptr<string> m_right;
     };
 
-    class substring : public string
+    /**
+     * Implementation of string which points to a range of characters in
+     * another string which stores it's characters in contiguous memory. The
+     * other string is kept alive as long as the view exists.
+     */
+    class string_view : public string
     {
     public:
-      explicit substring(const std::shared_ptr<string>& original,
-                         size_type offset,
-                         size_type length)
-        : m_original(original)
-        , m_offset(offset)
-        , m_length(length) {}
-
-      inline size_type length() const
+      explicit string_view(const std::shared_ptr<string>& owner,
+                           const_pointer chars,
+                           size_type length)
+        : string(length, chars)
+        , m_owner(owner) {}
+
+    private:
+      const std::shared_ptr<string> m_owner;
+    };
+
+    /**
+     * Implementation of string which repeats already existing string given
+     * number of times, without constructing the repeated contents.
+     */
+    class repeated_string : public string
+    {
+    public:
+      explicit repeated_string(const std::shared_ptr<string>& original,
+                               size_type count)
+        : string(original->length() * count)
+        , m_original(original)
+        , m_original_length(original->length()) {}
+
+      void copy(size_type offset, size_type count, pointer output) const
       {
-        return m_length;
+        while (count > 0)
+        {
+          const auto original_offset = offset % m_original_length;
+          const auto chunk = std::min(
+            count,
+            m_original_length - original_offset
+          );
+
+          m_original->copy(original_offset, chunk, output);
+          offset += chunk;
+          count -= chunk;
+          output += chunk;
+        }
       }
 
-      value_type at(size_type offset) const
+    protected:
+      value_type element(size_type offset) const
       {
-        return m_original->at(m_offset + offset);
+        return m_original->at(offset % m_original_length);
       }
 
     private:
       const std::shared_ptr<string> m_original;
-      const size_type m_offset;
-      const size_type m_length;
+      const size_type m_original_length;
     };
 
     /**
@@ -136,14 +253,11 @@ namespace plorth
     {
     public:
       explicit reversed_string(const std::shared_ptr<string>& original)
-        : m_original(original) {}
+        : string(original->length())
+        , m_original(original) {}
 
-      inline size_type length() const
-      {
-        return m_original->length();
-      }
-
-      value_type at(size_type offset) const
+    protected:
+      value_type element(size_type offset) const
       {
         return m_original->at(length() - offset - 1);
       }
@@ -153,20 +267,146 @@ namespace plorth
     };
   }
 
+  string::string(size_type length, const_pointer data)
+    : value(type::string)
+    , m_length(length)
+    , m_data(data) {}
+
+  string::value_type string::element(size_type offset) const
+  {
+    return m_data[offset];
+  }
+
+  void string::copy(size_type offset, size_type count, pointer output) const
+  {
+    const auto chars = data();
+
+    if (chars)
+    {
+      std::memcpy(output, chars + offset, sizeof(value_type) * count);
+      return;
+    }
+    for (size_type i = 0; i < count; ++i)
+    {
+      output[i] = at(offset + i);
+    }
+  }
+
+  /**
+   * Returns string which stores it's characters in contiguous memory. If the
+   * given string is already such, it's returned as it is. Otherwise it's
+   * contents are copied into a new string.
+   */
+  static std::shared_ptr<string> flatten(runtime& runtime,
+                                         const std::shared_ptr<string>& str)
+  {
+    const auto length = str->length();
+    string::pointer chars;
+
+    if (!length || str->data())
+    {
+      return str;
+    }
+    chars = new string::value_type[length];
+    str->copy(0, length, chars);
+
+    return runtime.adopt_string(chars, length);
+  }
+
+  /**
+   * Returns portion of string which stores it's characters in contiguous
+   * memory. Short portions are always copied. Other portions are returned as
+   * views into the original string, unless the portions taken from the
+   * original string cover only a small part of it in total, in which case
+   * they are copied so that they do not keep possibly large original string
+   * alive.
+   *
+   * \param runtime Scripting runtime.
+   * \param str     String which stores it's characters in contiguous memory.
+   * \param offset  Offset of the portion.
+   * \param length  Length of the portion.
+   * \param covered Total length of the portions taken from the string.
+   */
+  static std::shared_ptr<string> slice(runtime& runtime,
+                                       const std::shared_ptr<string>& str,
+                                       string::size_type offset,
+                                       string::size_type length,
+                                       string::size_type covered)
+  {
+    if (length == str->length())
+    {
+      return str;
+    }
+    else if (length <= PLORTH_STRING_VIEW_MIN_LENGTH
+             || covered * PLORTH_STRING_VIEW_MIN_FRACTION < str->length())
+    {
+      return runtime.string(str->data() + offset, length);
+    }
+
+    return runtime.value<string_view>(str, str->data() + offset, length);
+  }
+
+  static inline std::shared_ptr<string> slice(
+    runtime& runtime,
+    const std::shared_ptr<string>& str,
+    string::size_type offset,
+    string::size_type length
+  )
+  {
+    return slice(runtime, str, offset, length, length);
+  }
+
+  /**
+   * Slices string into given portions, each given as offset and length pair.
+   * Whether the portions are copied or not is decided from the total length
+   * of all of them, so that portions of a large string are returned as views
+   * when they together cover most of it.
+   */
+  static void slice(runtime& runtime,
+                    const std::shared_ptr<string>& str,
+                    const std::vector<std::pair<
+                      string::size_type,
+                      string::size_type
+                    >>& portions,
+                    std::vector<std::shared_ptr<value>>& result)
+  {
+    string::size_type covered = 0;
+
+    for (const auto& portion : portions)
+    {
+      covered += portion.second;
+    }
+    result.reserve(portions.size());
+    for (const auto& portion : portions)
+    {
+      result.push_back(slice(
+        runtime,
+        str,
+        portion.first,
+        portion.second,
+        covered
+      ));
+    }
+  }
+
   bool string::equals(const std::shared_ptr<class value>& that) const
   {
     const size_type len = length();
-    std::shared_ptr<string> str;
+    const string* str;
 
     if (!is(that, type::string))
     {
       return false;
     }
-    str = std::static_pointer_cast<string>(that);
+    str = static_cast<const string*>(that.get());
     if (len != str->length())
     {
       return false;
     }
+    if (data() && str->data())
+    {
+      return !len || !std::memcmp(data(), str->data(), sizeof(value_type) * len);
+    }
     for (size_type i = 0; i < len; ++i)
     {
       if (at(i) != str->at(i))
@@ -180,14 +420,9 @@ namespace plorth
 
   std::u32string string::to_string() const
   {
-    const size_type len = length();
-    std::u32string result;
+    std::u32string result(length(), 0);
 
-    result.reserve(len);
-    for (size_type i = 0; i < len; ++i)
-    {
-      result.append(1, at(i));
-    }
+    copy(0, result.length(), &result[0]);
 
     return result;
   }
@@ -253,11 +488,79 @@ namespace plorth
   std::shared_ptr<string> runtime::string(string::const_pointer chars,
                                           string::size_type length)
   {
+    if (length == 0 && m_empty_string)
+    {
+      return m_empty_string;
+    }
+    else if (length == 1)
+    {
+      return character(chars[0]);
+    }
+    else if (length <= PLORTH_INLINE_STRING_MAX_LENGTH)
+    {
+      return inline_string::make(*m_memory_manager, chars, length);
+    }
+
     return std::shared_ptr<class string>(
       new (*m_memory_manager) simple_string(chars, length)
     );
   }
 
+  std::shared_ptr<string> runtime::adopt_string(string::pointer chars,
+                                                string::size_type length)
+  {
+    if (length <= PLORTH_INLINE_STRING_MAX_LENGTH)
+    {
+      const auto result = string(chars, length);
+
+      delete[] chars;
+
+      return result;
+    }
+
+    return std::shared_ptr<class string>(
+      new (*m_memory_manager) simple_string(length, chars)
+    );
+  }
+
+  std::shared_ptr<string> runtime::character(string::value_type c)
+  {
+#if PLORTH_ENABLE_CHARACTER_CACHE
+    if (c < 256)
+    {
+      // Latin-1 page is populated when the runtime is being constructed, so
+      // it can be accessed without locking.
+      if (m_character_cache[0])
+      {
+        return m_character_cache[0][c];
+      }
+    }
+    else if (c <= PLORTH_CHARACTER_CACHE_MAX)
+    {
+# if PLORTH_ENABLE_MUTEXES
+      std::lock_guard<std::mutex> lock(m_character_cache_mutex);
+# endif
+      auto& page = m_character_cache[c >> 8];
+
+      if (!page)
+      {
+        page.reset(new std::shared_ptr<class string>[256]);
+      }
+
+      auto& reference = page[c & 0xff];
+
+      if (!reference)
+      {
+        reference = value<character_string>(c);
+      }
+
+      return reference;
+    }
+#endif
+
+    return value<character_string>(c);
+  }
+
   /**
    * Word: length
    * Prototype: string
@@ -708,7 +1011,7 @@ namespace plorth
       output.reserve(length);
       for (const auto c : str)
       {
-        output.push_back(runtime->string(&c, 1));
+        output.push_back(runtime->character(c));
       }
       ctx->push(str);
       ctx->push_array(output.data(), length);
@@ -770,18 +1073,21 @@ namespace plorth
 
     if (ctx->pop_string(str))
     {
-      const auto length = str->length();
+      const auto flat = flatten(*runtime, str);
+      const auto chars = flat->data();
+      const auto length = flat->length();
       string::size_type begin = 0;
       string::size_type end = 0;
+      std::vector<std::pair<string::size_type, string::size_type>> portions;
       std::vector<std::shared_ptr<value>> result;
 
       for (string::size_type i = 0; i < length; ++i)
       {
-        if (unicode_isspace(str->at(i)))
+        if (unicode_isspace(chars[i]))
         {
           if (end - begin > 0)
           {
-            result.push_back(runtime->value<substring>(str, begin, end - begin));
+            portions.emplace_back(begin, end - begin);
           }
           begin = end = i + 1;
         } else {
@@ -790,8 +1096,9 @@ namespace plorth
       }
       if (end - begin > 0)
       {
-        result.push_back(runtime->value<substring>(str, begin, end - begin));
+        portions.emplace_back(begin, end - begin);
       }
+      slice(*runtime, flat, portions, result);
 
       ctx->push(str);
       ctx->push_array(result.data(), result.size());
@@ -818,23 +1125,26 @@ namespace plorth
 
     if (ctx->pop_string(str))
     {
-      const auto length = str->length();
+      const auto flat = flatten(*runtime, str);
+      const auto chars = flat->data();
+      const auto length = flat->length();
       string::size_type begin = 0;
       string::size_type end = 0;
+      std::vector<std::pair<string::size_type, string::size_type>> portions;
       std::vector<std::shared_ptr<value>> result;
 
       for (string::size_type i = 0; i < length; ++i)
       {
-        const auto c = str->at(i);
+        const auto c = chars[i];
 
-        if (i + 1 < length && c == '\r' && str->at(i + 1) == '\n')
+        if (i + 1 < length && c == '\r' && chars[i + 1] == '\n')
         {
-          result.push_back(runtime->value<substring>(str, begin, end - begin));
+          portions.emplace_back(begin, end - begin);
           begin = end = ++i + 1;
         }
         else if (c == '\n' || c == '\r')
         {
-          result.push_back(runtime->value<substring>(str, begin, end - begin));
+          portions.emplace_back(begin, end - begin);
           begin = end = i + 1;
         } else {
           ++end;
@@ -842,14 +1152,83 @@ namespace plorth
       }
       if (end - begin > 0)
       {
-        result.push_back(runtime->value<substring>(str, begin, end - begin));
+        portions.emplace_back(begin, end - begin);
       }
+      slice(*runtime, flat, portions, result);
 
       ctx->push(str);
       ctx->push_array(result.data(), result.size());
     }
   }
 
+  /**
+   * Word: split
+   * Prototype: string
+   *
+   * Takes:
+   * - string
+   * - string
+   *
+   * Gives:
+   * - string
+   * - array
+   *
+   * Splits the string given as topmost value of the stack into an array of
+   * strings, using the string given as second topmost value of the stack as
+   * separator. If the separator is empty, string is split into characters.
+   */
+  static void w_split(const std::shared_ptr<context>& ctx)
+  {
+    const auto& runtime = ctx->runtime();
+    std::shared_ptr<string> str;
+    std::shared_ptr<string> separator;
+
+    if (!ctx->pop_string(str) || !ctx->pop_string(separator))
+    {
+      return;
+    }
+
+    const auto flat = flatten(*runtime, str);
+    const auto chars = flat->data();
+    const auto length = flat->length();
+    const auto separator_length = separator->length();
+    std::vector<std::shared_ptr<value>> result;
+
+    if (!separator_length)
+    {
+      result.reserve(length);
+      for (string::size_type i = 0; i < length; ++i)
+      {
+        result.push_back(runtime->character(chars[i]));
+      }
+    } else {
+      const auto flat_separator = flatten(*runtime, separator);
+      const auto separator_chars = flat_separator->data();
+      string::size_type begin = 0;
+      std::vector<std::pair<string::size_type, string::size_type>> portions;
+
+      for (string::size_type i = 0; i + separator_length <= length;)
+      {
+        if (std::equal(
+          separator_chars,
+          separator_chars + separator_length,
+          chars + i
+        ))
+        {
+          portions.emplace_back(begin, i - begin);
+          begin = i += separator_length;
+        } else {
+          ++i;
+        }
+      }
+      portions.emplace_back(begin, length - begin);
+      slice(*runtime, flat, portions, result);
+    }
+
+    ctx->push(str);
+    ctx->push_array(result.data(), result.size());
+  }
+
   /**
    * Word: reverse
    * Prototype: string
@@ -880,13 +1259,13 @@ namespace plorth
     if (ctx->pop_string(str))
     {
       const auto length = str->length();
-      char32_t result[length];
+      const auto result = new string::value_type[length];
 
       for (string::size_type i = 0; i < length; ++i)
       {
         result[i] = callback(str->at(i));
       }
-      ctx->push_string(result, length);
+      ctx->push(ctx->runtime()->adopt_string(result, length));
     }
   }
 
@@ -971,7 +1350,7 @@ namespace plorth
     if (ctx->pop_string(str))
     {
       const auto length = str->length();
-      char32_t output[length];
+      const auto output = new string::value_type[length];
 
       for (string::size_type i = 0; i < length; ++i)
       {
@@ -985,7 +1364,7 @@ namespace plorth
         }
         output[i] = c;
       }
-      ctx->push_string(output, length);
+      ctx->push(ctx->runtime()->adopt_string(output, length));
     }
   }
 
@@ -1007,26 +1386,28 @@ namespace plorth
 
     if (ctx->pop_string(str))
     {
-      const string::size_type length = str->length();
+      const auto flat = flatten(*ctx->runtime(), str);
+      const auto chars = flat->data();
+      const auto length = flat->length();
       string::size_type i, j;
 
       for (i = 0; i < length; ++i)
       {
-        if (!unicode_isspace(str->at(i)))
+        if (!unicode_isspace(chars[i]))
         {
           break;
         }
       }
       for (j = length; j != 0; --j)
       {
-        if (!unicode_isspace(str->at(j - 1)))
+        if (!unicode_isspace(chars[j - 1]))
         {
           break;
         }
       }
       if (i != 0 || j != length)
       {
-        ctx->push(ctx->runtime()->value<substring>(str, i, j - i));
+        ctx->push(slice(*ctx->runtime(), flat, i, j - i));
       } else {
         ctx->push(str);
       }
@@ -1051,19 +1432,21 @@ namespace plorth
 
     if (ctx->pop_string(str))
     {
-      const string::size_type length = str->length();
+      const auto flat = flatten(*ctx->runtime(), str);
+      const auto chars = flat->data();
+      const auto length = flat->length();
       string::size_type i;
 
       for (i = 0; i < length; ++i)
       {
-        if (!unicode_isspace(str->at(i)))
+        if (!unicode_isspace(chars[i]))
         {
           break;
         }
       }
       if (i != 0)
       {
-        ctx->push(ctx->runtime()->value<substring>(str, i, length - i));
+        ctx->push(slice(*ctx->runtime(), flat, i, length - i));
       } else {
         ctx->push(str);
       }
@@ -1088,19 +1471,21 @@ namespace plorth
 
     if (ctx->pop_string(str))
     {
-      const string::size_type length = str->length();
+      const auto flat = flatten(*ctx->runtime(), str);
+      const auto chars = flat->data();
+      const auto length = flat->length();
       string::size_type i;
 
       for (i = length; i != 0; --i)
       {
-        if (!unicode_isspace(str->at(i - 1)))
+        if (!unicode_isspace(chars[i - 1]))
         {
           break;
         }
       }
       if (i != length)
       {
-        ctx->push(ctx->runtime()->value<substring>(str, 0, i));
+        ctx->push(slice(*ctx->runtime(), flat, 0, i));
       } else {
         ctx->push(str);
       }
@@ -1192,22 +1577,27 @@ namespace plorth
     {
       number::int_type count = num->as_int();
 
-      if (count > 0)
+      if (count < 0)
       {
-        const auto& runtime = ctx->runtime();
-        std::shared_ptr<string> result = str;
-
-        for (number::int_type i = 1; i < count; ++i)
-        {
-          result = runtime->value<concat_string>(result, str);
-        }
-        ctx->push(result);
+        ctx->error(error::code::range, U"Invalid repeat count.");
       }
-      else if (count == 0)
+      else if (count == 0 || str->empty())
       {
         ctx->push_string(nullptr, 0);
+      }
+      else if (count == 1)
+      {
+        ctx->push(str);
+      }
+      else if (static_cast<std::uint64_t>(count) >
+               std::numeric_limits<string::size_type>::max() / str->length())
+      {
+        ctx->error(error::code::range, U"Repeat count is too large.");
       } else {
-        ctx->error(error::code::range, U"Invalid repeat count.");
+        ctx->push(ctx->runtime()->value<repeated_string>(
+          str,
+          static_cast<string::size_type>(count)
+        ));
       }
     }
   }
@@ -1298,51 +1688,198 @@ namespace plorth
     }
   }
 
+  /**
+   * Word: >string-builder
+   * Prototype: string
+   *
+   * Takes:
+   * - string
+   *
+   * Gives:
+   * - string-builder
+   *
+   * Constructs new string builder which initially contains characters of the
+   * string.
+   */
+  static void w_to_string_builder(const std::shared_ptr<context>& ctx)
+  {
+    std::shared_ptr<string> str;
+
+    if (ctx->pop_string(str))
+    {
+      const auto builder = ctx->runtime()->value<string_builder>();
+
+      builder->append(str);
+      ctx->push(builder);
+    }
+  }
+
+  /**
+   * Word: >bytes
+   * Prototype: string
+   *
+   * Takes:
+   * - string
+   *
+   * Gives:
+   * - bytes
+   *
+   * Encodes the string as UTF-8 and returns the result as a byte sequence.
+   */
+  static void w_to_bytes(const std::shared_ptr<context>& ctx)
+  {
+    std::shared_ptr<string> str;
+
+    if (ctx->pop_string(str))
+    {
+      const auto encoded = utf8_encode(str->to_string());
+
+      ctx->push(ctx->runtime()->bytes(
+        reinterpret_cast<bytes::const_pointer>(encoded.data()),
+        encoded.length()
+      ));
+    }
+  }
+
+  /**
+   * Word: pack
+   * Prototype: string
+   *
+   * Takes:
+   * - number
+   * - string
+   *
+   * Gives:
+   * - bytes
+   *
+   * Packs the integer number given as second topmost value of the stack into
+   * a byte sequence, using integer format given as topmost value of the
+   * stack. See the unpack word of bytes for description of the format. Range
+   * error will be thrown if the number does not fit in the format. Unsigned 64
+   * bit integers are limited to the range of numbers, that is below 2^63.
+   *
+   *     258 "u16be" pack #=> <bytes 0102>
+   */
+  static void w_pack(const std::shared_ptr<context>& ctx)
+  {
+    std::shared_ptr<string> format;
+    std::shared_ptr<number> num;
+
+    if (ctx->pop_string(format) && ctx->pop_number(num))
+    {
+      std::int64_t value;
+      bytes::integer_layout layout;
+      bytes::value_type buffer[8];
+
+      if (!bytes::integer_layout::parse(format->to_string(), layout))
+      {
+        ctx->error(error::code::value, U"Unknown integer format.");
+        return;
+      }
+
+      // Real numbers outside the range of integers, [-2^63, 2^63), cannot be
+      // converted into one.
+      if (num->is(number::number_type::real))
+      {
+        const auto real = num->as_real();
+        const number::real_type limit = 9223372036854775808.0;
+
+        if (!(real >= -limit && real < limit))
+        {
+          ctx->error(error::code::range, U"Integer out of range for format.");
+          return;
+        }
+      }
+      value = num->as_int();
+      if (layout.size < 8)
+      {
+        const auto bits = layout.size * 8;
+        const std::int64_t min = layout.is_signed
+          ? -(INT64_C(1) << (bits - 1))
+          : 0;
+        const std::int64_t max = layout.is_signed
+          ? (INT64_C(1) << (bits - 1)) - 1
+          : (INT64_C(1) << bits) - 1;
+
+        if (value < min || value > max)
+        {
+          ctx->error(error::code::range, U"Integer out of range for format.");
+          return;
+        }
+      }
+      else if (!layout.is_signed && value < 0)
+      {
+        ctx->error(error::code::range, U"Integer out of range for format.");
+        return;
+      }
+      for (std::size_t i = 0; i < layout.size; ++i)
+      {
+        const auto shift = 8 * (layout.little_endian ? i : layout.size - i - 1);
+
+        buffer[i] = static_cast<bytes::value_type>(
+          static_cast<std::uint64_t>(value) >> shift
+        );
+      }
+      ctx->push(ctx->runtime()->bytes(buffer, layout.size));
+    }
+  }
+
   namespace api
   {
     runtime::prototype_definition string_prototype()
     {
       return
       {
-        { U"length", w_length },
-        { U"chars", w_chars },
-        { U"runes", w_runes },
-        { U"words", w_words },
-        { U"lines", w_lines },
+        { U"length", w_length, U"string -- string number" },
+        { U"chars", w_chars, U"string -- string array" },
+        { U"runes", w_runes, U"string -- string array" },
+        { U"words", w_words, U"string -- string array" },
+        { U"lines", w_lines, U"string -- string array" },
+        { U"split", w_split, U"string string -- string array" },
 
         // Tests.
-        { U"includes?", w_includes },
-        { U"index-of", w_index_of },
-        { U"last-index-of", w_last_index_of },
-        { U"starts-with?", w_starts_with },
-        { U"ends-with?", w_ends_with },
-        { U"space?", w_is_space },
-        { U"lower-case?", w_is_lower_case },
-        { U"upper-case?", w_is_upper_case },
+        { U"includes?", w_includes, U"string string -- string boolean" },
+        { U"index-of", w_index_of, U"string string -- string number|null" },
+        {
+          U"last-index-of",
+          w_last_index_of,
+          U"string string -- string number|null"
+        },
+        { U"starts-with?", w_starts_with, U"string string -- string boolean" },
+        { U"ends-with?", w_ends_with, U"string string -- string boolean" },
+        { U"space?", w_is_space, U"string -- string boolean" },
+        { U"lower-case?", w_is_lower_case, U"string -- string boolean" },
+        { U"upper-case?", w_is_upper_case, U"string -- string boolean" },
 
         // Conversions.
-        { U"reverse", w_reverse },
-        { U"upper-case", w_upper_case },
-        { U"lower-case", w_lower_case },
-        { U"swap-case", w_swap_case },
-        { U"capitalize", w_capitalize },
-        { U"trim", w_trim },
-        { U"trim-left", w_trim_left },
-        { U"trim-right", w_trim_right },
+        { U"reverse", w_reverse, U"string -- string" },
+        { U"upper-case", w_upper_case, U"string -- string" },
+        { U"lower-case", w_lower_case, U"string -- string" },
+        { U"swap-case", w_swap_case, U"string -- string" },
+        { U"capitalize", w_capitalize, U"string -- string" },
+        { U"trim", w_trim, U"string -- string" },
+        { U"trim-left", w_trim_left, U"string -- string" },
+        { U"trim-right", w_trim_right, U"string -- string" },
         // TODO: pad-left
         // TODO: pad-right
         // TODO: substring
-        // TODO: split
         // TODO: replace
         // TODO: normalize
-        { U">number", w_to_number },
+        { U">number", w_to_number, U"string -- number" },
 
-        { U"+", w_concat },
-        { U"*", w_repeat },
-        { U"@", w_get },
+        { U"+", w_concat, U"string string -- string" },
+        { U"*", w_repeat, U"number string -- string" },
+        { U"@", w_get, U"number string -- string string" },
 
         // Type conversions.
-        { U">symbol", w_to_symbol }
+        { U">symbol", w_to_symbol, U"string -- symbol" },
+        { U">bytes", w_to_bytes, U"string -- bytes" },
+        { U"pack", w_pack, U"number string -- bytes" },
+        {
+          U">string-builder",
+          w_to_string_builder,
+          U"string -- string-builder"
+        }
       };
     }
   }
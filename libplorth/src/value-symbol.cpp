@@ -28,9 +28,11 @@
 namespace plorth
 {
   symbol::symbol(const std::u32string& id, const struct position* position)
-    : m_id(id)
+    : value(type::symbol)
+    , m_id(id)
     , m_position(position ? new struct position(*position) : nullptr)
-    , m_hash(0) {}
+    , m_hash(0)
+    , m_cache_version(0) {}
 
   symbol::~symbol()
   {
@@ -57,6 +59,37 @@ namespace plorth
     return h;
   }
 
+  bool symbol::cached_word(unsigned long version,
+                           std::shared_ptr<quote>& slot,
+                           std::shared_ptr<object>& module) const
+  {
+#if PLORTH_ENABLE_MUTEXES
+    std::lock_guard<std::mutex> lock(const_cast<symbol*>(this)->m_mutex);
+#endif
+
+    if (m_cache_version != version)
+    {
+      return false;
+    }
+    slot = m_cache_word;
+    module = m_cache_module;
+
+    return true;
+  }
+
+  void symbol::cache_word(unsigned long version,
+                          const std::shared_ptr<quote>& quote,
+                          const std::shared_ptr<object>& module) const
+  {
+#if PLORTH_ENABLE_MUTEXES
+    std::lock_guard<std::mutex> lock(const_cast<symbol*>(this)->m_mutex);
+#endif
+
+    m_cache_version = version;
+    m_cache_word = quote;
+    m_cache_module = module;
+  }
+
   bool symbol::equals(const std::shared_ptr<value>& that) const
   {
     if (is(that, type::symbol))
@@ -172,8 +205,8 @@ namespace plorth
     {
       return
       {
-        { U"position", w_position },
-        { U"call", w_call }
+        { U"position", w_position, U"symbol -- symbol object|null" },
+        { U"call", w_call, nullptr }
       };
     }
   }
@@ -30,7 +30,8 @@ namespace plorth
 {
   word::word(const std::shared_ptr<class symbol>& symbol,
              const std::shared_ptr<class quote>& quote)
-    : m_symbol(symbol)
+    : value(type::word)
+    , m_symbol(symbol)
     , m_quote(quote) {}
 
   bool word::equals(const std::shared_ptr<value>& that) const
@@ -165,11 +166,11 @@ namespace plorth
     {
       return
       {
-        { U"symbol", w_symbol },
-        { U"quote", w_quote },
+        { U"symbol", w_symbol, U"word -- word symbol" },
+        { U"quote", w_quote, U"word -- word quote" },
 
-        { U"call", w_call },
-        { U"define", w_define }
+        { U"call", w_call, nullptr },
+        { U"define", w_define, nullptr }
       };
     }
   }
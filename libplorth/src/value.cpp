@@ -27,6 +27,9 @@
 
 namespace plorth
 {
+  value::value(enum type type)
+    : m_type(type) {}
+
   std::u32string value::type_description() const
   {
     return type_description(type());
@@ -65,6 +68,18 @@ namespace plorth
 
     case type::error:
       return U"error";
+
+    case type::string_builder:
+      return U"string-builder";
+
+    case type::file:
+      return U"file";
+
+    case type::bytes:
+      return U"bytes";
+
+    case type::stream:
+      return U"stream";
     }
 
     return U"unknown";
@@ -103,6 +118,18 @@ namespace plorth
     case type::error:
       return runtime->error_prototype();
 
+    case type::string_builder:
+      return runtime->string_builder_prototype();
+
+    case type::file:
+      return runtime->file_prototype();
+
+    case type::bytes:
+      return runtime->bytes_prototype();
+
+    case type::stream:
+      return runtime->stream_prototype();
+
     case type::object:
       {
         std::shared_ptr<value> slot;
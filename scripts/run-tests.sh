@@ -6,8 +6,5 @@ mkdir -p build
 cd build
 cmake ..
 make
-for file in ../tests/test-*.plorth
-do
-  echo $file
-  ./cli/plorth $file
-done
+./cli/plorth --test --junit test-results.xml ../tests
+./tests/test-modules
@@ -0,0 +1,272 @@
+/*
+ * Copyright (c) 2017-2018, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <plorth/context.hpp>
+#include <plorth/module.hpp>
+#include <plorth/unicode.hpp>
+
+#include <cstdlib>
+#include <iostream>
+
+using namespace plorth;
+
+static int failures = 0;
+
+/**
+ * Executes given source code in given execution context and returns string
+ * representation of the value left on top of the data stack, or description
+ * of the error if the execution failed.
+ */
+static std::u32string run(const std::shared_ptr<context>& ctx,
+                          const std::u32string& source)
+{
+  const auto compiled = ctx->compile(source);
+
+  if (!compiled || !compiled->call(ctx))
+  {
+    const auto error = ctx->error();
+
+    ctx->clear_error();
+
+    return U"error: " + (error ? error->to_string() : U"unknown");
+  }
+  else if (ctx->data().empty())
+  {
+    return U"empty stack";
+  }
+
+  return ctx->data().back()->to_string();
+}
+
+/**
+ * Constructs new execution context which has given value on it's data stack.
+ */
+static std::shared_ptr<context> with_value(
+  const std::shared_ptr<class runtime>& runtime,
+  const std::shared_ptr<value>& value
+)
+{
+  const auto ctx = context::make(runtime);
+
+  ctx->push(value);
+
+  return ctx;
+}
+
+static void expect(const char* description,
+                   const std::u32string& actual,
+                   const std::u32string& expected)
+{
+  if (actual == expected)
+  {
+    std::cout << "✔ " << description << std::endl;
+    return;
+  }
+  ++failures;
+  std::cout << "✘ " << description
+            << ": expected `" << utf8_encode(expected)
+            << "', got `" << utf8_encode(actual) << "'"
+            << std::endl;
+}
+
+static void expect(const char* description,
+                   std::size_t actual,
+                   std::size_t expected)
+{
+  expect(
+    description,
+    utf8_decode(std::to_string(actual)),
+    utf8_decode(std::to_string(expected))
+  );
+}
+
+#if PLORTH_ENABLE_FILE_SYSTEM_MODULES
+static void test_changed_dependency()
+{
+  memory::manager memory_manager;
+  const auto modules = module::manager::virtual_file_system(
+    memory_manager,
+    {
+      { U"/a.plorth", U": value 1 ;" },
+      { U"/b.plorth", U"\"./a\" import : total value 10 + ;" },
+    }
+  );
+  const auto runtime = runtime::make(
+    memory_manager,
+    std::shared_ptr<io::input>(),
+    std::shared_ptr<io::output>(),
+    modules
+  );
+  const auto ctx = context::make(runtime);
+
+  expect(
+    "module is imported",
+    run(ctx, U"\"/b\" import total"),
+    U"11"
+  );
+  modules->write_file(U"/a.plorth", U": value 2 ;");
+  expect(
+    "changed module and module depending on it are reloaded",
+    modules->reload(ctx),
+    2
+  );
+  expect(
+    "module depending on changed module sees the change",
+    run(context::make(runtime), U"\"/b\" import total"),
+    U"12"
+  );
+  expect(
+    "nothing is reloaded when nothing has changed",
+    modules->reload(ctx),
+    0
+  );
+}
+#endif
+
+static void test_failing_reload()
+{
+  memory::manager memory_manager;
+  const auto modules = module::manager::virtual_file_system(
+    memory_manager,
+    {
+      { U"/a.plorth", U": value \"old\" ;" },
+    }
+  );
+  const auto runtime = runtime::make(
+    memory_manager,
+    std::shared_ptr<io::input>(),
+    std::shared_ptr<io::output>(),
+    modules
+  );
+  const auto ctx = context::make(runtime);
+  const auto generation = modules->generation();
+
+  expect(
+    "module is imported",
+    run(ctx, U"\"/a\" import value"),
+    U"old"
+  );
+  modules->write_file(U"/a.plorth", U": value ( ;");
+  expect(
+    "module which fails to compile is not reloaded",
+    modules->reload(ctx),
+    0
+  );
+  ctx->clear_error();
+  expect(
+    "generation is not changed by failing reload",
+    modules->generation(),
+    generation
+  );
+  expect(
+    "previous version of the module is restored",
+    run(context::make(runtime), U"\"/a\" import value"),
+    U"old"
+  );
+  modules->write_file(U"/a.plorth", U": value \"new\" ;");
+  expect(
+    "module is reloaded after it has been fixed",
+    modules->reload(ctx),
+    1
+  );
+  expect(
+    "fixed version of the module is used",
+    run(context::make(runtime), U"\"/a\" import value"),
+    U"new"
+  );
+}
+
+static void test_quote_held_across_reload()
+{
+  memory::manager memory_manager;
+  const auto modules = module::manager::virtual_file_system(
+    memory_manager,
+    {
+      // The helper is too large to be inlined into the word which calls it,
+      // so it has to be looked up from the module when called.
+      {
+        U"/s.plorth",
+        U": helper \"o\" \"l\" + \"d\" + \"\" + \"\" + \"\" + ;"
+        U": greet helper ;"
+      },
+    }
+  );
+  const auto runtime = runtime::make(
+    memory_manager,
+    std::shared_ptr<io::input>(),
+    std::shared_ptr<io::output>(),
+    modules
+  );
+  const auto ctx = context::make(runtime);
+  std::shared_ptr<value> greet;
+
+  // Hold only the quote, so that the word it calls cannot be found from the
+  // execution context calling it.
+  if (const auto module = modules->import_module(ctx, U"/s"))
+  {
+    module->own_property(U"greet", greet);
+  }
+  if (!value::is(greet, value::type::quote))
+  {
+    expect("module is imported", U"no quote", U"quote");
+    return;
+  }
+  expect(
+    "quote from module is called",
+    run(with_value(runtime, greet), U"call"),
+    U"old"
+  );
+  modules->write_file(
+    U"/s.plorth",
+    U": helper \"new\" ; : greet helper \" again\" + ;"
+  );
+  expect(
+    "changed module is reloaded",
+    modules->reload(ctx),
+    1
+  );
+  expect(
+    "quote held across reload still uses previous version",
+    run(with_value(runtime, greet), U"call"),
+    U"old"
+  );
+  expect(
+    "word imported after reload uses new version",
+    run(context::make(runtime), U"\"/s\" import greet"),
+    U"new again"
+  );
+}
+
+int main()
+{
+#if PLORTH_ENABLE_FILE_SYSTEM_MODULES
+  test_changed_dependency();
+#endif
+  test_failing_reload();
+  test_quote_held_across_reload();
+
+  return failures > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}